@@ -3,4 +3,6 @@
 #include "Modelling3DOne.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogProceduralMesh);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Modelling3DOne, "Modelling3DOne" );
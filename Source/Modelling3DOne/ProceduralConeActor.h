@@ -3,32 +3,29 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "ProceduralMeshComponent.h"
+#include "ProceduralShapeActor.h"
 #include "ProceduralConeActor.generated.h"
 
+// Identifies the generated cone mesh; every field of FProceduralConeParams must be appended
+inline FProceduralMeshKey MakeMeshKey(const FProceduralConeParams& Params)
+{
+	FProceduralMeshKey Key(TEXT("Cone"));
+	Key.Append(Params.TopRadius);
+	Key.Append(Params.BottomRadius);
+	Key.Append(Params.Height);
+	Key.Append(Params.NumMeridians);
+	return Key;
+}
+
 /**
  * 
  */
 UCLASS()
-class MODELLING3DONE_API AProceduralConeActor : public AActor
+class MODELLING3DONE_API AProceduralConeActor : public AProceduralShapeActor
 {
 	GENERATED_BODY()
 
 public:
-	// Sets default values for this actor's properties
-	AProceduralConeActor();
-	
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	virtual void OnConstruction(const FTransform& Transform) override;
-	
-public:
-	// The procedural mesh component that will hold our geometry
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
-	UProceduralMeshComponent* ProceduralMesh;
-
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Cone")
 	float TopRadius = 10.0f;
 	
@@ -53,9 +50,23 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
 	void GenerateCone();
 
-private:
-	// Helper function to create a single triangle
-	void CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, 
-					   TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2);
-};
+	// Snapshot of the shape parameters GenerateCone builds from, coarsened for the given LOD
+	FProceduralConeParams GetMeshParams(int32 LODIndex = 0) const;
+
+	// Exact vertex and index counts GenerateCone will emit for the current parameters
+	FProceduralMeshCapacity ComputeMeshCapacity() const { return ComputeMeshCapacity(GetMeshParams()); }
+	static FProceduralMeshCapacity ComputeMeshCapacity(const FProceduralConeParams& Params);
+
+	// Fills the builder with the cone mesh; touches no actor state, so it can run off the game thread
+	static void BuildMesh(const FProceduralConeParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token);
 
+	// One convex hull over the base ring and the top ring or apex, used by Simple collision
+	static void BuildCollisionHulls(const FProceduralConeParams& Params, TArray<TArray<FVector>>& OutHulls);
+
+protected:
+	virtual FProceduralMeshBuildFunction CreateMeshBuildFunction(int32 LODIndex) const override;
+	virtual FProceduralMeshKey GetMeshKey(int32 LODIndex) const override { return MakeMeshKey(GetMeshParams(LODIndex)); }
+	virtual FString GetTessellationDescription(int32 LODIndex) const override { return FString::Printf(TEXT("%d"), GetMeshParams(LODIndex).NumMeridians); }
+	virtual UMaterialInterface* GetShapeMaterial() const override { return ConeMaterial; }
+	virtual bool GetSimpleCollisionHulls(TArray<TArray<FVector>>& OutHulls) const override { BuildCollisionHulls(GetMeshParams(), OutHulls); return true; }
+};
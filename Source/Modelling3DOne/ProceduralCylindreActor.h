@@ -3,29 +3,25 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "ProceduralMeshComponent.h"
+#include "ProceduralShapeActor.h"
 #include "ProceduralCylindreActor.generated.h"
 
+// Identifies the generated cylinder mesh; every field of FProceduralCylinderParams must be appended
+inline FProceduralMeshKey MakeMeshKey(const FProceduralCylinderParams& Params)
+{
+	FProceduralMeshKey Key(TEXT("Cylinder"));
+	Key.Append(Params.Radius);
+	Key.Append(Params.Height);
+	Key.Append(Params.NumMeridians);
+	return Key;
+}
+
 UCLASS()
-class MODELLING3DONE_API AProceduralCylindreActor : public AActor
+class MODELLING3DONE_API AProceduralCylindreActor : public AProceduralShapeActor
 {
 	GENERATED_BODY()
 
 public:
-	// Sets default values for this actor's properties
-	AProceduralCylindreActor();
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	virtual void OnConstruction(const FTransform& Transform) override;
-
-public:
-	// The procedural mesh component that will hold our geometry
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
-	UProceduralMeshComponent* ProceduralMesh;
-
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Cylinder")
 	float Radius = 50.0f;
  
@@ -48,9 +44,23 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
 	void GenerateCylinder();
 
-private:
-	// Helper function to create a single triangle
-	void CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, 
-					   TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2);
-};
+	// Snapshot of the shape parameters GenerateCylinder builds from, coarsened for the given LOD
+	FProceduralCylinderParams GetMeshParams(int32 LODIndex = 0) const;
+
+	// Exact vertex and index counts GenerateCylinder will emit for the current parameters
+	FProceduralMeshCapacity ComputeMeshCapacity() const { return ComputeMeshCapacity(GetMeshParams()); }
+	static FProceduralMeshCapacity ComputeMeshCapacity(const FProceduralCylinderParams& Params);
+
+	// Fills the builder with the cylinder mesh; touches no actor state, so it can run off the game thread
+	static void BuildMesh(const FProceduralCylinderParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token);
 
+	// One convex prism over both cap rings, used by Simple collision
+	static void BuildCollisionHulls(const FProceduralCylinderParams& Params, TArray<TArray<FVector>>& OutHulls);
+
+protected:
+	virtual FProceduralMeshBuildFunction CreateMeshBuildFunction(int32 LODIndex) const override;
+	virtual FProceduralMeshKey GetMeshKey(int32 LODIndex) const override { return MakeMeshKey(GetMeshParams(LODIndex)); }
+	virtual FString GetTessellationDescription(int32 LODIndex) const override { return FString::Printf(TEXT("%d"), GetMeshParams(LODIndex).NumMeridians); }
+	virtual UMaterialInterface* GetShapeMaterial() const override { return CylinderMaterial; }
+	virtual bool GetSimpleCollisionHulls(TArray<TArray<FVector>>& OutHulls) const override { BuildCollisionHulls(GetMeshParams(), OutHulls); return true; }
+};
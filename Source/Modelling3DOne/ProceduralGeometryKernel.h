@@ -0,0 +1,1857 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Engine-free core of the procedural primitives: shape parameters, exact capacities and the vertex, tangent and
+ * index emission of the sphere (lat/long, icosphere or cube-sphere), Pac-Man, cone, cylinder, trapezoid and
+ * plane. Plain C++ with no engine include, so the actors and standalone tools (Tools/GeometryBench) run the very same code.
+ *
+ * Generators write through a Writer supplied by the caller:
+ *   void Reset(const FProceduralMeshCapacity& Capacity);
+ *   int32_t AddVertex(const FVec3& Position, const FVec3& Normal, const FTangent& Tangent, const FVec2& UV);
+ *   void AddTriangle(int32_t V0, int32_t V1, int32_t V2);
+ *   FRingView GetRing(int32_t NumSegments);    // shared table, valid until the generator returns
+ *   int32_t AddRing(const FProceduralRingParams& Params, const FRingView& Ring, int32_t FirstMeridian, int32_t Count);
+ *   int32_t AddGridRow(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove, int32_t Count);
+ *   bool IsCancelled() const;
+ * Every expression is the one the actors evaluated before the split, so meshes are bit-identical.
+ * Tangents are analytic too: each generator derives them from its own parameterization while it emits the vertex.
+ */
+
+/**
+ * Exact number of vertices and indices a generator will emit.
+ * Computed up front from the shape parameters so the builder can allocate once.
+ */
+struct FProceduralMeshCapacity
+{
+	int32_t NumVertices = 0;
+	int32_t NumIndices = 0;
+
+	FProceduralMeshCapacity() = default;
+	FProceduralMeshCapacity(int32_t InNumVertices, int32_t InNumIndices)
+		: NumVertices(InNumVertices)
+		, NumIndices(InNumIndices)
+	{
+	}
+};
+
+/**
+ * One latitude ring of a lat/long surface. Every vertex of the ring is
+ * Position = (PositionScale * cos(phi), PositionScale * sin(phi), PositionZ), with the normal built the same way,
+ * so the whole ring reduces to two multiplies per component over the shared meridian table.
+ */
+struct FProceduralRingParams
+{
+	// Radius * sin(theta) and Radius * cos(theta)
+	float PositionScale = 0.0f;
+	float PositionZ = 0.0f;
+
+	// Same for the unit normal: sin(theta) and cos(theta), negated for a negative radius
+	float NormalScale = 0.0f;
+	float NormalZ = 0.0f;
+
+	// V of the ring; U is Meridian / NumMeridians
+	float V = 0.0f;
+	int32_t NumMeridians = 0;
+
+	// Tangent along increasing U is TangentScale * (-sin(phi), cos(phi), 0); the bitangent direction is the same for the whole ring
+	float TangentScale = 0.0f;
+	bool bFlipTangentY = false;
+};
+
+/**
+ * One row of a height-displaced grid. Vertex i sits on grid column Col = FirstCol + i * ColStep:
+ * Position = (Col * QuadSize, Y, Heights[i]), with the normal and tangent from the central differences of the heights
+ * around it, so a whole row reduces to a few multiplies and one square root per vertex.
+ */
+struct FProceduralGridRowParams
+{
+	float Y = 0.0f;
+	float QuadSize = 0.0f;
+	int32_t FirstCol = 0;
+	int32_t ColStep = 1;
+
+	// V of the row; U is Col / NumCols
+	float V = 0.0f;
+	int32_t NumCols = 0;
+
+	// 1 / (2 * distance to the neighbouring vertices) along X and Y: turns a height difference into a slope
+	float SlopeScaleX = 0.0f;
+	float SlopeScaleY = 0.0f;
+
+	// Sign of QuadSize, which U follows along X
+	float TangentSign = 1.0f;
+};
+
+namespace ProceduralGeometry
+{
+	// Tessellation layouts of the sphere; the actor's EProceduralSphereTopology mirrors them value for value
+	enum class ESphereTopology : uint8_t
+	{
+		LatLong,
+		Icosphere,
+		CubeSphere,
+	};
+}
+
+// Parameters the sphere is built from, copied by value so the geometry can be built on any thread
+struct FProceduralSphereParams
+{
+	float Radius = 0.0f;
+	int32_t NumParallels = 0;
+	int32_t NumMeridians = 0;
+
+	// The rings only apply to LatLong; the other layouts split their base solid Subdivisions times instead
+	ProceduralGeometry::ESphereTopology Topology = ProceduralGeometry::ESphereTopology::LatLong;
+	int32_t Subdivisions = 0;
+};
+
+// Parameters the Pac-Man is built from, copied by value so the geometry can be built on any thread
+struct FProceduralPacManParams
+{
+	float Radius = 0.0f;
+	float MouthAngleDegrees = 0.0f;
+	int32_t NumParallels = 0;
+	int32_t NumMeridians = 0;
+	bool bFixedTopology = false;
+};
+
+// Parameters the cone is built from, copied by value so the geometry can be built on any thread
+struct FProceduralConeParams
+{
+	float TopRadius = 0.0f;
+	float BottomRadius = 0.0f;
+	float Height = 0.0f;
+	int32_t NumMeridians = 0;
+};
+
+// Parameters the cylinder is built from, copied by value so the geometry can be built on any thread
+struct FProceduralCylinderParams
+{
+	float Radius = 0.0f;
+	float Height = 0.0f;
+	int32_t NumMeridians = 0;
+};
+
+// Parameters the trapezoid is built from, copied by value so the geometry can be built on any thread
+struct FProceduralTrapezoidParams
+{
+	float TopWidth = 0.0f;
+	float BottomWidth = 0.0f;
+	float Height = 0.0f;
+	float Depth = 0.0f;
+};
+
+// Parameters the plane is built from, copied by value so the geometry can be built on any thread
+struct FProceduralPlaneParams
+{
+	int32_t Nb_Lignes = 0;
+	int32_t Nb_Colones = 0;
+	float QuadSize = 0.0f;
+	bool bUseIndexedGrid = false;
+
+	// Height field added to Z: HeightSamplesX by HeightSamplesY row-major samples stretched over the whole plane, so the
+	// first and last samples land on its corners. Borrowed; whoever builds keeps them alive until the build returns
+	const float* HeightSamples = nullptr;
+	int32_t HeightSamplesX = 0;
+	int32_t HeightSamplesY = 0;
+	float HeightScale = 1.0f;
+
+	// 128-bit hash of the samples, which identifies them in mesh keys in place of the pointer; the generators never read it
+	uint64_t HeightSamplesHashLow = 0;
+	uint64_t HeightSamplesHashHigh = 0;
+
+	// Fractal noise added to Z on top of the samples: NoiseOctaves octaves of gradient noise, the first one with cells
+	// NoiseScale units wide. No noise while NoiseAmplitude is 0
+	float NoiseAmplitude = 0.0f;
+	float NoiseScale = 1000.0f;
+	int32_t NoiseOctaves = 4;
+	int32_t NoiseSeed = 0;
+};
+
+// Rectangle of plane quads generated as one mesh, e.g. one section of a tiled plane
+struct FProceduralPlaneTile
+{
+	int32_t FirstRow = 0;
+	int32_t FirstCol = 0;
+	int32_t NumRows = 0;
+	int32_t NumCols = 0;
+
+	// Keeps one grid corner out of 2^LOD along each side; NumRows and NumCols must be multiples of that step
+	int32_t LOD = 0;
+
+	// Depth of the skirt hanging below the tile's border, which hides the cracks against a neighbour at another LOD. 0 for none
+	float SkirtDepth = 0.0f;
+};
+
+namespace ProceduralGeometry
+{
+	constexpr float Pi = 3.1415926535897932f;
+
+	// Double precision vector with the engine's FVector layout and arithmetic; the actors' writer stores the results as floats
+	struct FVec3
+	{
+		double X = 0.0;
+		double Y = 0.0;
+		double Z = 0.0;
+
+		FVec3() = default;
+		FVec3(double InX, double InY, double InZ)
+			: X(InX)
+			, Y(InY)
+			, Z(InZ)
+		{
+		}
+
+		FVec3 operator+(const FVec3& Other) const { return FVec3(X + Other.X, Y + Other.Y, Z + Other.Z); }
+		FVec3 operator-(const FVec3& Other) const { return FVec3(X - Other.X, Y - Other.Y, Z - Other.Z); }
+		FVec3 operator*(double Scale) const { return FVec3(X * Scale, Y * Scale, Z * Scale); }
+
+		static FVec3 CrossProduct(const FVec3& A, const FVec3& B)
+		{
+			return FVec3(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X);
+		}
+
+		static double DotProduct(const FVec3& A, const FVec3& B)
+		{
+			return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+		}
+
+		// Same tolerance and branches as FVector::GetSafeNormal
+		FVec3 GetSafeNormal() const
+		{
+			const double SquareSum = X * X + Y * Y + Z * Z;
+			if (SquareSum == 1.0)
+			{
+				return *this;
+			}
+			if (SquareSum < double(1.e-8f))
+			{
+				return FVec3();
+			}
+			const double Scale = 1.0 / std::sqrt(SquareSum);
+			return FVec3(X * Scale, Y * Scale, Z * Scale);
+		}
+	};
+
+	struct FVec2
+	{
+		double X = 0.0;
+		double Y = 0.0;
+
+		FVec2() = default;
+		FVec2(double InX, double InY)
+			: X(InX)
+			, Y(InY)
+		{
+		}
+	};
+
+	// Single precision storage with the layout of FVector3f, FVector4f and FVector2f: what writers keep, while the math above stays double
+	struct FStoredVec3
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+	};
+
+	// A tangent as stored: TangentX in XYZ and the binormal sign in W, -1 where FTangent sets bFlipTangentY
+	struct FStoredVec4
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+		float W = 0.0f;
+	};
+
+	struct FStoredVec2
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+	};
+
+	// Tangent frame of one vertex in FProcMeshTangent's convention: the bitangent is cross(Normal, TangentX), negated when bFlipTangentY is set
+	struct FTangent
+	{
+		FVec3 TangentX;
+		bool bFlipTangentY = false;
+
+		FTangent() = default;
+		FTangent(const FVec3& InTangentX, bool bInFlipTangentY)
+			: TangentX(InTangentX)
+			, bFlipTangentY(bInFlipTangentY)
+		{
+		}
+	};
+
+	// Tangent from the surface directions in which U and V grow: TangentX follows U, and the bitangent is flipped to follow V
+	inline FTangent MakeTangent(const FVec3& Normal, const FVec3& DirectionU, const FVec3& DirectionV)
+	{
+		FVec3 TangentX = DirectionU.GetSafeNormal();
+		return FTangent(TangentX, FVec3::DotProduct(FVec3::CrossProduct(Normal, TangentX), DirectionV) < 0.0);
+	}
+
+	// Constant tangent of a flat face from three of its corners and their UVs
+	inline FTangent MakeFaceTangent(const FVec3& Normal, const FVec3& P0, const FVec3& P1, const FVec3& P2,
+		const FVec2& UV0, const FVec2& UV1, const FVec2& UV2)
+	{
+		FVec3 Edge1 = P1 - P0;
+		FVec3 Edge2 = P2 - P0;
+		double DeltaU1 = UV1.X - UV0.X;
+		double DeltaV1 = UV1.Y - UV0.Y;
+		double DeltaU2 = UV2.X - UV0.X;
+		double DeltaV2 = UV2.Y - UV0.Y;
+
+		// Solves Edge = DeltaU * dP/dU + DeltaV * dP/dV for both edges; only the sign of the determinant matters for directions
+		double Sign = DeltaU1 * DeltaV2 - DeltaU2 * DeltaV1 < 0.0 ? -1.0 : 1.0;
+		return MakeTangent(Normal, (Edge1 * DeltaV2 - Edge2 * DeltaV1) * Sign, (Edge2 * DeltaU1 - Edge1 * DeltaU2) * Sign);
+	}
+
+	/**
+	 * Tangent of a lat/long surface at meridian angle phi. U follows phi, so TangentX is dP/dphi:
+	 * RadiusSign * (-sin(phi), cos(phi), 0). V grows from the north pole down, against cross(Normal, TangentX) for a positive radius
+	 */
+	inline FTangent MakeLatLongTangent(float SinPhi, float CosPhi, float RadiusSign)
+	{
+		return FTangent(FVec3(-RadiusSign * SinPhi, RadiusSign * CosPhi, 0.0f), RadiusSign > 0.0f);
+	}
+
+	// The few FMath helpers the generators use, with the same definitions
+	namespace Math
+	{
+		template <typename T> inline T Max(T A, T B) { return A >= B ? A : B; }
+		template <typename T> inline T Min(T A, T B) { return A <= B ? A : B; }
+		template <typename T> inline T Clamp(T X, T MinValue, T MaxValue) { return X < MinValue ? MinValue : X < MaxValue ? X : MaxValue; }
+		template <typename T> inline T Abs(T A) { return A < T(0) ? -A : A; }
+		template <typename T> inline T Sign(T A) { return A > T(0) ? T(1) : (A < T(0) ? T(-1) : T(0)); }
+		inline float Sin(float Value) { return std::sin(Value); }
+		inline float Cos(float Value) { return std::cos(Value); }
+		inline float DegreesToRadians(float Degrees) { return Degrees * (Pi / 180.f); }
+	}
+
+	// Sine and cosine of NumSegments angles around a ring; borrowed from a table the writer keeps alive
+	struct FRingView
+	{
+		const float* Sin = nullptr;
+		const float* Cos = nullptr;
+		int32_t NumSegments = 0;
+	};
+
+	// Angle of one ring segment; every ring table is filled from this expression
+	inline float GetRingAngle(int32_t SegmentIdx, int32_t NumSegments, float Phase = 0.0f)
+	{
+		return Phase + 2.0f * Pi * float(SegmentIdx) / float(NumSegments);
+	}
+
+	inline void FillRing(int32_t NumSegments, float Phase, float* OutSin, float* OutCos)
+	{
+		for (int32_t SegmentIdx = 0; SegmentIdx < NumSegments; SegmentIdx++)
+		{
+			float Angle = GetRingAngle(SegmentIdx, NumSegments, Phase);
+			OutSin[SegmentIdx] = Math::Sin(Angle);
+			OutCos[SegmentIdx] = Math::Cos(Angle);
+		}
+	}
+
+	// Reference ring emission, straight into single precision storage; the engine's SIMD ring kernels are bit-identical to it
+	inline void EmitRing(const FProceduralRingParams& Params, const FRingView& Ring, int32_t FirstMeridian, int32_t Count,
+		FStoredVec3* OutPositions, FStoredVec3* OutNormals, FStoredVec4* OutTangents, FStoredVec2* OutUVs)
+	{
+		const float BinormalSign = Params.bFlipTangentY ? -1.0f : 1.0f;
+		for (int32_t Index = 0; Index < Count; Index++)
+		{
+			int32_t MeridianIdx = FirstMeridian + Index;
+			float CosPhi = Ring.Cos[MeridianIdx];
+			float SinPhi = Ring.Sin[MeridianIdx];
+
+			OutPositions[Index] = FStoredVec3{ Params.PositionScale * CosPhi, Params.PositionScale * SinPhi, Params.PositionZ };
+			OutNormals[Index] = FStoredVec3{ Params.NormalScale * CosPhi, Params.NormalScale * SinPhi, Params.NormalZ };
+			OutTangents[Index] = FStoredVec4{ -Params.TangentScale * SinPhi, Params.TangentScale * CosPhi, 0.0f, BinormalSign };
+			OutUVs[Index] = FStoredVec2{ float(MeridianIdx) / float(Params.NumMeridians), Params.V };
+		}
+	}
+
+	/**
+	 * Reference grid row emission, straight into single precision storage; the engine's SIMD grid kernel is bit-identical to it.
+	 * Heights is read from index -1 to Count, HeightsBelow and HeightsAbove (the rows one step down and up in Y) from 0 to Count - 1
+	 */
+	inline void EmitGridRow(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove,
+		int32_t Count, FStoredVec3* OutPositions, FStoredVec3* OutNormals, FStoredVec4* OutTangents, FStoredVec2* OutUVs)
+	{
+		for (int32_t Index = 0; Index < Count; Index++)
+		{
+			int32_t Col = Params.FirstCol + Index * Params.ColStep;
+
+			// The normal is (-dZ/dX, -dZ/dY, 1) normalized; negating through the differences keeps +0 on a flat grid
+			float NegSlopeX = (Heights[Index - 1] - Heights[Index + 1]) * Params.SlopeScaleX;
+			float NegSlopeY = (HeightsBelow[Index] - HeightsAbove[Index]) * Params.SlopeScaleY;
+			float NormalScale = 1.0f / std::sqrt(NegSlopeX * NegSlopeX + NegSlopeY * NegSlopeY + 1.0f);
+
+			// TangentX follows U, along (1, 0, dZ/dX) normalized; cross(Normal, TangentX) then always follows V
+			float SlopeX = (Heights[Index + 1] - Heights[Index - 1]) * Params.SlopeScaleX;
+			float TangentX = Params.TangentSign * (1.0f / std::sqrt(SlopeX * SlopeX + 1.0f));
+
+			OutPositions[Index] = FStoredVec3{ float(Col) * Params.QuadSize, Params.Y, Heights[Index] };
+			OutNormals[Index] = FStoredVec3{ NegSlopeX * NormalScale, NegSlopeY * NormalScale, NormalScale };
+			OutTangents[Index] = FStoredVec4{ TangentX, 0.0f, SlopeX * TangentX, 1.0f };
+			OutUVs[Index] = FStoredVec2{ float(Col) / float(Params.NumCols), Params.V };
+		}
+	}
+
+	// Adds one flat-shaded triangle with its own three vertices (counter-clockwise winding)
+	template <typename WriterType>
+	void AddFlatTriangle(WriterType& Writer, const FVec3& V0, const FVec3& V1, const FVec3& V2)
+	{
+		// Calculate normal for the triangle
+		FVec3 Normal = FVec3::CrossProduct(V1 - V0, V2 - V0).GetSafeNormal();
+
+		// U runs along the first edge and V along the second
+		FTangent Tangent = MakeTangent(Normal, V1 - V0, V2 - V0);
+
+		// Add vertices with basic planar UVs
+		int32_t StartIndex = Writer.AddVertex(V0, Normal, Tangent, FVec2(0, 0));
+		Writer.AddVertex(V1, Normal, Tangent, FVec2(1, 0));
+		Writer.AddVertex(V2, Normal, Tangent, FVec2(0, 1));
+
+		// Add triangle indices (counter-clockwise for proper face orientation)
+		Writer.AddTriangle(StartIndex, StartIndex + 1, StartIndex + 2);
+	}
+
+	// Adds one flat face as two triangles (0,1,2) and (0,2,3)
+	template <typename WriterType>
+	void AddFlatQuad(WriterType& Writer, const FVec3& P0, const FVec3& P1, const FVec3& P2, const FVec3& P3,
+		const FVec3& Normal, const FVec2 (&FaceUVs)[4])
+	{
+		FTangent Tangent = MakeFaceTangent(Normal, P0, P1, P2, FaceUVs[0], FaceUVs[1], FaceUVs[2]);
+
+		int32_t StartIdx = Writer.AddVertex(P0, Normal, Tangent, FaceUVs[0]);
+		Writer.AddVertex(P1, Normal, Tangent, FaceUVs[1]);
+		Writer.AddVertex(P2, Normal, Tangent, FaceUVs[2]);
+		Writer.AddVertex(P3, Normal, Tangent, FaceUVs[3]);
+
+		Writer.AddTriangle(StartIdx + 0, StartIdx + 1, StartIdx + 2);
+		Writer.AddTriangle(StartIdx + 0, StartIdx + 2, StartIdx + 3);
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Subdivided spheres
+	// ---------------------------------------------------------------------------------------------
+
+	// Deepest split the icosphere and cube-sphere accept; level 8 is already 655k icosphere vertices
+	constexpr int32_t MaxSphereSubdivisions = 8;
+
+	/**
+	 * Vertex made for each edge of one subdivision level, so the two faces sharing an edge split it at the same vertex.
+	 * Hashed on the lower vertex index into a fixed bucket per vertex: no vertex of either layout has more than
+	 * MaxValence edges, so a bucket never overflows. Vertices are numbered in the order faces are split, so
+	 * consecutive lookups land in nearby buckets and stay in cache, where a scattering hash missed on nearly every edge
+	 */
+	class FEdgeMidpointTable
+	{
+	public:
+		static constexpr int32_t MaxValence = 6;
+
+		void Reset(int32_t NumVertices)
+		{
+			Buckets.assign(size_t(NumVertices) * MaxValence, EmptySlot);
+		}
+
+		// Vertex of the edge between A and B in either direction; the first lookup creates it with MakeVertex()
+		template <typename MakeVertexType>
+		int32_t FindOrAdd(int32_t A, int32_t B, MakeVertexType&& MakeVertex)
+		{
+			const int32_t Lower = A < B ? A : B;
+			const uint32_t Upper = uint32_t(A < B ? B : A);
+
+			// Each slot packs the upper vertex over the midpoint vertex
+			uint64_t* Bucket = Buckets.data() + size_t(Lower) * MaxValence;
+			int32_t Slot = 0;
+			for (; Slot < MaxValence && Bucket[Slot] != EmptySlot; Slot++)
+			{
+				if (uint32_t(Bucket[Slot] >> 32) == Upper)
+				{
+					return int32_t(uint32_t(Bucket[Slot]));
+				}
+			}
+
+			const int32_t Midpoint = MakeVertex();
+			Bucket[Slot] = (uint64_t(Upper) << 32) | uint32_t(Midpoint);
+			return Midpoint;
+		}
+
+	private:
+		static constexpr uint64_t EmptySlot = ~uint64_t(0);
+
+		std::vector<uint64_t> Buckets;
+	};
+
+	inline FProceduralMeshCapacity ComputeSubdividedSphereCapacity(const FProceduralSphereParams& Params)
+	{
+		int32_t Subdivisions = Math::Clamp(Params.Subdivisions, 0, MaxSphereSubdivisions);
+
+		// Every level splits each triangle (or cube quad) in four. The surface is closed with every edge shared by
+		// two triangles, so Euler's formula gives V = T / 2 + 2
+		int32_t BaseTriangles = Params.Topology == ESphereTopology::Icosphere ? 20 : 12;
+		int32_t NumTriangles = BaseTriangles << (2 * Subdivisions);
+		return FProceduralMeshCapacity(NumTriangles / 2 + 2, 3 * NumTriangles);
+	}
+
+	// One vertex of a subdivided sphere from its unit direction, with the lat/long layout's U around Z and V down from the north pole
+	template <typename WriterType>
+	void AddSphereDirectionVertex(WriterType& Writer, const FVec3& Direction, float Radius, float NormalSign)
+	{
+		double U = std::atan2(Direction.Y, Direction.X) / (2.0 * Pi);
+		if (U < 0.0)
+		{
+			U += 1.0;
+		}
+		double V = std::acos(Math::Clamp(Direction.Z, -1.0, 1.0)) / Pi;
+
+		// Same frame as the rings; the poles take meridian 0's like the lat/long poles do
+		double RingRadius = std::sqrt(Direction.X * Direction.X + Direction.Y * Direction.Y);
+		FTangent Tangent = RingRadius > 0.0
+			? MakeLatLongTangent(float(Direction.Y / RingRadius), float(Direction.X / RingRadius), NormalSign)
+			: MakeLatLongTangent(0.0f, 1.0f, NormalSign);
+		Writer.AddVertex(Direction * Radius, Direction * NormalSign, Tangent, FVec2(U, V));
+	}
+
+	/**
+	 * Icosahedron with every face split in four Subdivisions times, each new vertex pushed back onto the unit sphere.
+	 * Triangles stay close to equal in size, where lat/long rings crowd them at the poles.
+	 * Vertices are shared, so U wraps across the seam triangles at +X; prefer LatLong for textures that rely on the UVs
+	 */
+	template <typename WriterType>
+	void BuildIcosphere(const FProceduralSphereParams& Params, WriterType& Writer)
+	{
+		int32_t Subdivisions = Math::Clamp(Params.Subdivisions, 0, MaxSphereSubdivisions);
+		FProceduralMeshCapacity Capacity = ComputeSubdividedSphereCapacity(Params);
+
+		// Arrays to hold mesh data, sized once for the whole sphere
+		Writer.Reset(Capacity);
+
+		// Golden-ratio rectangles in the three axis planes
+		const double T = (1.0 + std::sqrt(5.0)) / 2.0;
+		const FVec3 Corners[12] = {
+			FVec3(-1, T, 0), FVec3(1, T, 0), FVec3(-1, -T, 0), FVec3(1, -T, 0),
+			FVec3(0, -1, T), FVec3(0, 1, T), FVec3(0, -1, -T), FVec3(0, 1, -T),
+			FVec3(T, 0, -1), FVec3(T, 0, 1), FVec3(-T, 0, -1), FVec3(-T, 0, 1),
+		};
+
+		// Counter-clockwise seen from outside in right-handed terms
+		const int32_t Faces[20 * 3] = {
+			0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+			1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+			3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+			4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1,
+		};
+
+		std::vector<FVec3> Directions;
+		Directions.reserve(Capacity.NumVertices);
+		for (const FVec3& Corner : Corners)
+		{
+			Directions.push_back(Corner.GetSafeNormal());
+		}
+		std::vector<int32_t> Triangles(Faces, Faces + 20 * 3);
+		std::vector<int32_t> SplitTriangles;
+		SplitTriangles.reserve(Capacity.NumIndices);
+
+		FEdgeMidpointTable Midpoints;
+		auto GetMidpoint = [&Directions, &Midpoints](int32_t A, int32_t B)
+		{
+			return Midpoints.FindOrAdd(A, B, [&Directions, A, B]()
+			{
+				FVec3 Midpoint = (Directions[A] + Directions[B]).GetSafeNormal();
+				Directions.push_back(Midpoint);
+				return int32_t(Directions.size()) - 1;
+			});
+		};
+
+		for (int32_t Level = 0; Level < Subdivisions; Level++)
+		{
+			// A newer request superseded this build
+			if (Writer.IsCancelled())
+			{
+				return;
+			}
+
+			Midpoints.Reset(int32_t(Directions.size()));
+			SplitTriangles.clear();
+			for (size_t Index = 0; Index < Triangles.size(); Index += 3)
+			{
+				int32_t A = Triangles[Index];
+				int32_t B = Triangles[Index + 1];
+				int32_t C = Triangles[Index + 2];
+				int32_t AB = GetMidpoint(A, B);
+				int32_t BC = GetMidpoint(B, C);
+				int32_t CA = GetMidpoint(C, A);
+
+				const int32_t Split[12] = { A, AB, CA,  AB, B, BC,  CA, BC, C,  AB, BC, CA };
+				SplitTriangles.insert(SplitTriangles.end(), Split, Split + 12);
+			}
+			Triangles.swap(SplitTriangles);
+		}
+
+		float NormalSign = Math::Sign(Params.Radius);
+		for (const FVec3& Direction : Directions)
+		{
+			AddSphereDirectionVertex(Writer, Direction, Params.Radius, NormalSign);
+		}
+
+		// Reversed into the winding the other generators use
+		for (size_t Index = 0; Index < Triangles.size(); Index += 3)
+		{
+			Writer.AddTriangle(Triangles[Index], Triangles[Index + 2], Triangles[Index + 1]);
+		}
+	}
+
+	/**
+	 * Cube with every face split into a 2^Subdivisions grid, then projected onto the sphere by normalizing.
+	 * Splitting happens in cube space and only the final vertices are normalized, so each face is a regular grid seen
+	 * from the center. Same shared-vertex UV caveat as the icosphere
+	 */
+	template <typename WriterType>
+	void BuildCubeSphere(const FProceduralSphereParams& Params, WriterType& Writer)
+	{
+		int32_t Subdivisions = Math::Clamp(Params.Subdivisions, 0, MaxSphereSubdivisions);
+		FProceduralMeshCapacity Capacity = ComputeSubdividedSphereCapacity(Params);
+
+		// Arrays to hold mesh data, sized once for the whole sphere
+		Writer.Reset(Capacity);
+
+		// Corner I sits at +1 on X, Y and Z for bits 0, 1 and 2 of I
+		std::vector<FVec3> Points;
+		Points.reserve(Capacity.NumVertices);
+		for (int32_t CornerIdx = 0; CornerIdx < 8; CornerIdx++)
+		{
+			Points.push_back(FVec3((CornerIdx & 1) ? 1 : -1, (CornerIdx & 2) ? 1 : -1, (CornerIdx & 4) ? 1 : -1));
+		}
+
+		// +X, -X, +Y, -Y, +Z, -Z, counter-clockwise seen from outside in right-handed terms
+		const int32_t Faces[6 * 4] = {
+			1, 3, 7, 5,  0, 4, 6, 2,  2, 6, 7, 3,  0, 1, 5, 4,  4, 5, 7, 6,  0, 2, 3, 1,
+		};
+		std::vector<int32_t> Quads(Faces, Faces + 6 * 4);
+		std::vector<int32_t> SplitQuads;
+		SplitQuads.reserve(Capacity.NumIndices * 2 / 3);
+
+		FEdgeMidpointTable Midpoints;
+		auto GetMidpoint = [&Points, &Midpoints](int32_t A, int32_t B)
+		{
+			return Midpoints.FindOrAdd(A, B, [&Points, A, B]()
+			{
+				FVec3 Midpoint = (Points[A] + Points[B]) * 0.5;
+				Points.push_back(Midpoint);
+				return int32_t(Points.size()) - 1;
+			});
+		};
+
+		for (int32_t Level = 0; Level < Subdivisions; Level++)
+		{
+			// A newer request superseded this build
+			if (Writer.IsCancelled())
+			{
+				return;
+			}
+
+			Midpoints.Reset(int32_t(Points.size()));
+			SplitQuads.clear();
+			for (size_t Index = 0; Index < Quads.size(); Index += 4)
+			{
+				int32_t A = Quads[Index];
+				int32_t B = Quads[Index + 1];
+				int32_t C = Quads[Index + 2];
+				int32_t D = Quads[Index + 3];
+				int32_t AB = GetMidpoint(A, B);
+				int32_t BC = GetMidpoint(B, C);
+				int32_t CD = GetMidpoint(C, D);
+				int32_t DA = GetMidpoint(D, A);
+
+				// The center belongs to this quad alone
+				Points.push_back((Points[A] + Points[B] + Points[C] + Points[D]) * 0.25);
+				int32_t Center = int32_t(Points.size()) - 1;
+
+				const int32_t Split[16] = { A, AB, Center, DA,  AB, B, BC, Center,  Center, BC, C, CD,  DA, Center, CD, D };
+				SplitQuads.insert(SplitQuads.end(), Split, Split + 16);
+			}
+			Quads.swap(SplitQuads);
+		}
+
+		float NormalSign = Math::Sign(Params.Radius);
+		for (const FVec3& Point : Points)
+		{
+			AddSphereDirectionVertex(Writer, Point.GetSafeNormal(), Params.Radius, NormalSign);
+		}
+
+		// Two triangles per quad, reversed into the winding the other generators use
+		for (size_t Index = 0; Index < Quads.size(); Index += 4)
+		{
+			Writer.AddTriangle(Quads[Index], Quads[Index + 2], Quads[Index + 1]);
+			Writer.AddTriangle(Quads[Index], Quads[Index + 3], Quads[Index + 2]);
+		}
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Sphere
+	// ---------------------------------------------------------------------------------------------
+
+	inline FProceduralMeshCapacity ComputeSphereCapacity(const FProceduralSphereParams& Params)
+	{
+		if (Params.Topology != ESphereTopology::LatLong)
+		{
+			return ComputeSubdividedSphereCapacity(Params);
+		}
+
+		int32_t Parallels = Math::Max(3, Params.NumParallels);
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+
+		// Two poles plus one ring per inner parallel; two caps of fans plus the quad strips between rings
+		int32_t NumVertices = 2 + (Parallels - 1) * Meridians;
+		int32_t NumIndices = 3 * Meridians * 2 + 6 * Meridians * (Parallels - 2);
+		return FProceduralMeshCapacity(NumVertices, NumIndices);
+	}
+
+	template <typename WriterType>
+	void BuildSphere(const FProceduralSphereParams& Params, WriterType& Writer)
+	{
+		if (Params.Topology == ESphereTopology::Icosphere)
+		{
+			BuildIcosphere(Params, Writer);
+			return;
+		}
+		if (Params.Topology == ESphereTopology::CubeSphere)
+		{
+			BuildCubeSphere(Params, Writer);
+			return;
+		}
+
+		// Arrays to hold mesh data, sized once for the whole sphere
+		Writer.Reset(ComputeSphereCapacity(Params));
+
+		// Ensure minimum values
+		int32_t Parallels = Math::Max(3, Params.NumParallels);
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+
+		// Every ring samples the same meridian angles
+		FRingView Ring = Writer.GetRing(Meridians);
+
+		// Ring normals are the unit direction itself, flipped for a negative radius like GetSafeNormal would
+		float NormalSign = Math::Sign(Params.Radius);
+
+		// The poles have no meridian of their own and take meridian 0's tangent
+		FTangent PoleTangent = MakeLatLongTangent(0.0f, 1.0f, NormalSign);
+
+		// Create North Pole vertex (index 0)
+		FVec3 NorthPole = FVec3(0, 0, Params.Radius);
+		Writer.AddVertex(NorthPole, NorthPole.GetSafeNormal(), PoleTangent, FVec2(0.5f, 1.0f));
+
+		// Generate vertices for parallels (latitude circles)
+		// Skip poles: start from parallel 1 to Parallels-1
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+		{
+			// A newer request superseded this build
+			if (Writer.IsCancelled())
+			{
+				return;
+			}
+
+			// Angle from north pole (0 to PI)
+			float Theta = Pi * float(ParallelIdx) / float(Parallels);
+			float SinTheta = Math::Sin(Theta);
+			float CosTheta = Math::Cos(Theta);
+
+			// Spherical to Cartesian coordinates for the whole ring at once
+			FProceduralRingParams RingParams;
+			RingParams.PositionScale = Params.Radius * SinTheta;
+			RingParams.PositionZ = Params.Radius * CosTheta;
+			RingParams.NormalScale = NormalSign * SinTheta;
+			RingParams.NormalZ = NormalSign * CosTheta;
+			RingParams.V = float(ParallelIdx) / float(Parallels);
+			RingParams.NumMeridians = Meridians;
+			RingParams.TangentScale = PoleTangent.TangentX.Y;
+			RingParams.bFlipTangentY = PoleTangent.bFlipTangentY;
+
+			Writer.AddRing(RingParams, Ring, 0, Meridians);
+		}
+
+		// Create South Pole vertex (last vertex)
+		FVec3 SouthPole = FVec3(0, 0, -Params.Radius);
+		int32_t SouthPoleIndex = Writer.AddVertex(SouthPole, SouthPole.GetSafeNormal(), PoleTangent, FVec2(0.5f, 0.0f));
+
+		// --- Generate Triangles ---
+
+		// North Pole cap triangles
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t Next = (MeridianIdx + 1) % Meridians;
+
+			// Triangle: North Pole -> Next meridian -> Current meridian
+			Writer.AddTriangle(0, 1 + Next, 1 + MeridianIdx);
+		}
+
+		// Middle section: quads between parallels (each quad = 2 triangles)
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels - 1; ParallelIdx++)
+		{
+			for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+			{
+				int32_t Next = (MeridianIdx + 1) % Meridians;
+
+				// Calculate vertex indices
+				int32_t Current = 1 + (ParallelIdx - 1) * Meridians + MeridianIdx;
+				int32_t CurrentNext = 1 + (ParallelIdx - 1) * Meridians + Next;
+				int32_t Below = 1 + ParallelIdx * Meridians + MeridianIdx;
+				int32_t BelowNext = 1 + ParallelIdx * Meridians + Next;
+
+				// First triangle of the quad
+				Writer.AddTriangle(Current, CurrentNext, Below);
+
+				// Second triangle of the quad
+				Writer.AddTriangle(CurrentNext, BelowNext, Below);
+			}
+		}
+
+		// South Pole cap triangles
+		int32_t LastParallelStart = 1 + (Parallels - 2) * Meridians;
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t Next = (MeridianIdx + 1) % Meridians;
+
+			// Triangle: Current meridian -> Next meridian -> South Pole
+			Writer.AddTriangle(LastParallelStart + MeridianIdx, LastParallelStart + Next, SouthPoleIndex);
+		}
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Pac-Man
+	// ---------------------------------------------------------------------------------------------
+
+	// True when the meridian falls inside the removed mouth wedge (centered on +X)
+	inline bool IsMeridianInMouth(int32_t MeridianIdx, int32_t Meridians, float HalfMouthAngleRad)
+	{
+		float Phi = GetRingAngle(MeridianIdx, Meridians);
+		float PhiNormalized = Phi;
+		if (PhiNormalized > Pi)
+			PhiNormalized = PhiNormalized - 2.0f * Pi;
+
+		return Math::Abs(PhiNormalized) < HalfMouthAngleRad;
+	}
+
+	/**
+	 * Every meridian plus a seam copy of meridian 0, with the ones inside the mouth folded onto the nearer wall.
+	 * Meridians outside the mouth keep the shared table's exact values
+	 */
+	struct FFoldedRing
+	{
+		std::vector<float> Sin;
+		std::vector<float> Cos;
+
+		void Build(int32_t Meridians, float HalfMouthAngleRad)
+		{
+			Sin.resize(Meridians + 1);
+			Cos.resize(Meridians + 1);
+
+			float WallAngle = Math::Clamp(HalfMouthAngleRad, 0.0f, Pi);
+			for (int32_t MeridianIdx = 0; MeridianIdx <= Meridians; MeridianIdx++)
+			{
+				float Phi = GetRingAngle(MeridianIdx, Meridians);
+				if (Phi < WallAngle)
+					Phi = WallAngle;
+				else if (Phi > 2.0f * Pi - WallAngle)
+					Phi = 2.0f * Pi - WallAngle;
+
+				Sin[MeridianIdx] = Math::Sin(Phi);
+				Cos[MeridianIdx] = Math::Cos(Phi);
+			}
+		}
+
+		FRingView GetView() const { return FRingView{ Sin.data(), Cos.data(), int32_t(Sin.size()) }; }
+	};
+
+	inline FProceduralMeshCapacity ComputePacManCapacity(const FProceduralPacManParams& Params)
+	{
+		int32_t Parallels = Math::Max(3, Params.NumParallels);
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+		float HalfMouthAngleRad = Math::DegreesToRadians(Params.MouthAngleDegrees / 2.0f);
+
+		// Every parallel skips the same meridians, so count the kept vertices and kept quads of one ring
+		int32_t KeptMeridians = 0;
+		int32_t KeptEdges = 0;
+		if (Params.bFixedTopology)
+		{
+			// All meridians plus the seam, whatever the mouth angle
+			KeptMeridians = Meridians + 1;
+			KeptEdges = Meridians;
+		}
+		else
+		{
+			for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+			{
+				if (!IsMeridianInMouth(MeridianIdx, Meridians, HalfMouthAngleRad))
+				{
+					KeptMeridians++;
+					if (!IsMeridianInMouth((MeridianIdx + 1) % Meridians, Meridians, HalfMouthAngleRad))
+					{
+						KeptEdges++;
+					}
+				}
+			}
+		}
+
+		// Surface: center, two poles and the kept ring vertices; pole fans plus quad strips
+		int32_t NumVertices = 3 + (Parallels - 1) * KeptMeridians;
+		int32_t NumIndices = 2 * 3 * KeptEdges + 6 * KeptEdges * (Parallels - 2);
+
+		// Mouth walls: a pole-to-pole edge and a center vertex per wall, fanned into one triangle per parallel
+		NumVertices += 2 * (Parallels + 1) + 2;
+		NumIndices += 2 * 3 * Parallels;
+
+		return FProceduralMeshCapacity(NumVertices, NumIndices);
+	}
+
+	template <typename WriterType>
+	void BuildPacMan(const FProceduralPacManParams& Params, WriterType& Writer)
+	{
+		// Arrays to hold mesh data, sized once for the whole shape
+		Writer.Reset(ComputePacManCapacity(Params));
+
+		// Ensure minimum values
+		int32_t Parallels = Math::Max(3, Params.NumParallels);
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+
+		// Convert mouth angle to radians (half angle on each side)
+		float HalfMouthAngleRad = Math::DegreesToRadians(Params.MouthAngleDegrees / 2.0f);
+
+		// Every ring samples the same meridian angles; a fixed topology folds the mouth ones onto the walls instead of skipping them
+		FFoldedRing FoldedRing;
+		FRingView Ring;
+		if (Params.bFixedTopology)
+		{
+			FoldedRing.Build(Meridians, HalfMouthAngleRad);
+			Ring = FoldedRing.GetView();
+		}
+		else
+		{
+			Ring = Writer.GetRing(Meridians);
+		}
+
+		// Ring normals are the unit direction itself, flipped for a negative radius like GetSafeNormal would
+		float NormalSign = Math::Sign(Params.Radius);
+
+		// The poles have no meridian of their own and take meridian 0's tangent, as on the sphere
+		FTangent PoleTangent = MakeLatLongTangent(0.0f, 1.0f, NormalSign);
+
+		// Center vertex for mouth (at origin)
+		Writer.AddVertex(FVec3(0, 0, 0), FVec3(1, 0, 0), PoleTangent, FVec2(0.5f, 0.5f));
+
+		// Create North Pole vertex
+		FVec3 NorthPole = FVec3(0, 0, Params.Radius);
+		int32_t NorthPoleIndex = Writer.AddVertex(NorthPole, NorthPole.GetSafeNormal(), PoleTangent, FVec2(0.5f, 1.0f));
+
+		// Slot of each meridian within a ring, or -1 inside the mouth.
+		// Every parallel skips the same meridians, so this one table maps (parallel, meridian)
+		// to a vertex index in constant time. A fixed topology keeps every meridian and closes the ring
+		// on a seam copy of meridian 0, so the strip never bridges the mouth.
+		int32_t RingMeridians = Params.bFixedTopology ? Meridians + 1 : Meridians;
+		std::vector<int32_t> MeridianSlots(RingMeridians);
+		int32_t KeptMeridians = 0;
+		for (int32_t MeridianIdx = 0; MeridianIdx < RingMeridians; MeridianIdx++)
+		{
+			bool bSkipped = !Params.bFixedTopology && IsMeridianInMouth(MeridianIdx, Meridians, HalfMouthAngleRad);
+			MeridianSlots[MeridianIdx] = bSkipped ? -1 : KeptMeridians++;
+		}
+		int32_t FirstRingIndex = NorthPoleIndex + 1;
+
+		// Runs of consecutive kept meridians; their slots, and so their vertices, are contiguous.
+		// The mouth is a single wedge, so there are at most two
+		struct FRun
+		{
+			int32_t First = 0;
+			int32_t Count = 0;
+		};
+		FRun KeptRuns[2];
+		int32_t NumKeptRuns = 0;
+		for (int32_t MeridianIdx = 0; MeridianIdx < RingMeridians; MeridianIdx++)
+		{
+			if (MeridianSlots[MeridianIdx] == -1)
+				continue;
+
+			if (MeridianIdx > 0 && MeridianSlots[MeridianIdx - 1] != -1)
+				KeptRuns[NumKeptRuns - 1].Count++;
+			else
+				KeptRuns[NumKeptRuns++] = FRun{ MeridianIdx, 1 };
+		}
+
+		// Generate vertices for parallels (latitude circles)
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+		{
+			// A newer request superseded this build
+			if (Writer.IsCancelled())
+			{
+				return;
+			}
+
+			float Theta = Pi * float(ParallelIdx) / float(Parallels);
+			float SinTheta = Math::Sin(Theta);
+			float CosTheta = Math::Cos(Theta);
+
+			FProceduralRingParams RingParams;
+			RingParams.PositionScale = Params.Radius * SinTheta;
+			RingParams.PositionZ = Params.Radius * CosTheta;
+			RingParams.NormalScale = NormalSign * SinTheta;
+			RingParams.NormalZ = NormalSign * CosTheta;
+			RingParams.V = float(ParallelIdx) / float(Parallels);
+			RingParams.NumMeridians = Meridians;
+			RingParams.TangentScale = PoleTangent.TangentX.Y;
+			RingParams.bFlipTangentY = PoleTangent.bFlipTangentY;
+
+			// Vertices in the mouth region are skipped by emitting only the kept runs
+			for (int32_t RunIdx = 0; RunIdx < NumKeptRuns; RunIdx++)
+			{
+				Writer.AddRing(RingParams, Ring, KeptRuns[RunIdx].First, KeptRuns[RunIdx].Count);
+			}
+		}
+
+		// Create South Pole vertex
+		FVec3 SouthPole = FVec3(0, 0, -Params.Radius);
+		int32_t SouthPoleIndex = Writer.AddVertex(SouthPole, SouthPole.GetSafeNormal(), PoleTangent, FVec2(0.5f, 0.0f));
+
+		// --- Helper function to get vertex index ---
+		auto GetVertexIndex = [&](int32_t ParallelIdx, int32_t MeridianIdx) -> int32_t
+		{
+			if (ParallelIdx == 0)
+				return NorthPoleIndex;
+			if (ParallelIdx == Parallels)
+				return SouthPoleIndex;
+
+			int32_t Slot = MeridianSlots[MeridianIdx];
+			if (Slot == -1)
+				return -1;
+
+			return FirstRingIndex + (ParallelIdx - 1) * KeptMeridians + Slot;
+		};
+
+		// --- Generate Triangles for the sphere surface ---
+
+		// North Pole cap triangles
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t Current = GetVertexIndex(1, MeridianIdx);
+			int32_t Next = GetVertexIndex(1, (MeridianIdx + 1) % RingMeridians);
+
+			if (Current != -1 && Next != -1)
+			{
+				Writer.AddTriangle(NorthPoleIndex, Next, Current);
+			}
+		}
+
+		// Middle section: quads between parallels
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels - 1; ParallelIdx++)
+		{
+			for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+			{
+				int32_t NextMeridianIdx = (MeridianIdx + 1) % RingMeridians;
+
+				int32_t Current = GetVertexIndex(ParallelIdx, MeridianIdx);
+				int32_t CurrentNext = GetVertexIndex(ParallelIdx, NextMeridianIdx);
+				int32_t Below = GetVertexIndex(ParallelIdx + 1, MeridianIdx);
+				int32_t BelowNext = GetVertexIndex(ParallelIdx + 1, NextMeridianIdx);
+
+				if (Current != -1 && CurrentNext != -1 && Below != -1 && BelowNext != -1)
+				{
+					Writer.AddTriangle(Current, CurrentNext, Below);
+					Writer.AddTriangle(CurrentNext, BelowNext, Below);
+				}
+			}
+		}
+
+		// South Pole cap triangles
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t Current = GetVertexIndex(Parallels - 1, MeridianIdx);
+			int32_t Next = GetVertexIndex(Parallels - 1, (MeridianIdx + 1) % RingMeridians);
+
+			if (Current != -1 && Next != -1)
+			{
+				Writer.AddTriangle(Current, Next, SouthPoleIndex);
+			}
+		}
+
+		// --- Create mouth wall vertices and triangles ---
+
+		// Calculate normal for upper wall (perpendicular to the upper mouth edge)
+		// The upper edge is at angle +HalfMouthAngleRad, so normal points perpendicular inward
+		FVec3 UpperWallNormal = FVec3(
+			-Math::Sin(HalfMouthAngleRad),  // Perpendicular to the edge
+			Math::Cos(HalfMouthAngleRad),
+			0
+		).GetSafeNormal();
+
+		// Calculate normal for lower wall
+		FVec3 LowerWallNormal = FVec3(
+			-Math::Sin(-HalfMouthAngleRad),
+			Math::Cos(-HalfMouthAngleRad),
+			0
+		).GetSafeNormal();
+
+		// Both mouth edges sit at a fixed angle, so their trig is the same on every parallel
+		float CosUpperEdge = Math::Cos(HalfMouthAngleRad);
+		float SinUpperEdge = Math::Sin(HalfMouthAngleRad);
+		float CosLowerEdge = Math::Cos(-HalfMouthAngleRad);
+		float SinLowerEdge = Math::Sin(-HalfMouthAngleRad);
+
+		// On each wall V runs down the pole-to-pole edge and U from that edge's arc (0 upper, 1 lower) to the center at 0.5
+		FTangent UpperWallTangent = MakeTangent(UpperWallNormal, FVec3(CosUpperEdge, SinUpperEdge, 0) * -Params.Radius, FVec3(0, 0, Params.Radius));
+		FTangent LowerWallTangent = MakeTangent(LowerWallNormal, FVec3(CosLowerEdge, SinLowerEdge, 0) * Params.Radius, FVec3(0, 0, Params.Radius));
+
+		// Create vertices along the upper mouth wall edge (contiguous, north pole to south pole)
+
+		// Add north pole for upper wall (duplicate with different normal)
+		int32_t UpperNorthPole = Writer.AddVertex(NorthPole, UpperWallNormal, UpperWallTangent, FVec2(0.0f, 1.0f));
+
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+		{
+			float Theta = Pi * float(ParallelIdx) / float(Parallels);
+			float SinTheta = Math::Sin(Theta);
+			float CosTheta = Math::Cos(Theta);
+
+			// Upper edge is at +HalfMouthAngleRad
+			FVec3 Position = FVec3(
+				Params.Radius * SinTheta * CosUpperEdge,
+				Params.Radius * SinTheta * SinUpperEdge,
+				Params.Radius * CosTheta
+			);
+
+			Writer.AddVertex(Position, UpperWallNormal, UpperWallTangent, FVec2(0.0f, 1.0f - float(ParallelIdx) / float(Parallels)));
+		}
+
+		// Add south pole for upper wall
+		Writer.AddVertex(SouthPole, UpperWallNormal, UpperWallTangent, FVec2(0.0f, 0.0f));
+
+		// Create vertices along the lower mouth wall edge (contiguous, north pole to south pole)
+
+		// Add north pole for lower wall
+		int32_t LowerNorthPole = Writer.AddVertex(NorthPole, LowerWallNormal, LowerWallTangent, FVec2(1.0f, 1.0f));
+
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+		{
+			float Theta = Pi * float(ParallelIdx) / float(Parallels);
+			float SinTheta = Math::Sin(Theta);
+			float CosTheta = Math::Cos(Theta);
+
+			// Lower edge is at -HalfMouthAngleRad
+			FVec3 Position = FVec3(
+				Params.Radius * SinTheta * CosLowerEdge,
+				Params.Radius * SinTheta * SinLowerEdge,
+				Params.Radius * CosTheta
+			);
+
+			Writer.AddVertex(Position, LowerWallNormal, LowerWallTangent, FVec2(1.0f, 1.0f - float(ParallelIdx) / float(Parallels)));
+		}
+
+		// Add south pole for lower wall
+		Writer.AddVertex(SouthPole, LowerWallNormal, LowerWallTangent, FVec2(1.0f, 0.0f));
+
+		// Create center vertex duplicates for each wall
+		int32_t CenterUpperWall = Writer.AddVertex(FVec3(0, 0, 0), UpperWallNormal, UpperWallTangent, FVec2(0.5f, 0.5f));
+		int32_t CenterLowerWall = Writer.AddVertex(FVec3(0, 0, 0), LowerWallNormal, LowerWallTangent, FVec2(0.5f, 0.5f));
+
+		// Create triangles for upper mouth wall (connecting to center)
+		for (int32_t i = 0; i < Parallels; i++)
+		{
+			Writer.AddTriangle(CenterUpperWall, UpperNorthPole + i, UpperNorthPole + i + 1);
+		}
+
+		// Create triangles for lower mouth wall (connecting to center, reversed winding)
+		for (int32_t i = 0; i < Parallels; i++)
+		{
+			Writer.AddTriangle(CenterLowerWall, LowerNorthPole + i + 1, LowerNorthPole + i);
+		}
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Cone and cylinder
+	// ---------------------------------------------------------------------------------------------
+
+	inline FProceduralMeshCapacity ComputeConeCapacity(const FProceduralConeParams& Params)
+	{
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+		bool bIsTruncated = Math::Max(0.0f, Params.TopRadius) > 0.01f;
+
+		// Body: one top/bottom vertex pair and one quad per meridian
+		int32_t NumVertices = 2 * Meridians;
+		int32_t NumIndices = 6 * Meridians;
+
+		// Caps: a center vertex plus a ring, fanned into one triangle per meridian
+		int32_t NumCaps = bIsTruncated ? 2 : 1;
+		NumVertices += NumCaps * (1 + Meridians);
+		NumIndices += NumCaps * 3 * Meridians;
+
+		return FProceduralMeshCapacity(NumVertices, NumIndices);
+	}
+
+	// Flat disk at height Z: a center vertex and a ring fanned around it, facing +Z (or -Z when bFacingDown)
+	template <typename WriterType>
+	void AddDiskCap(WriterType& Writer, const FRingView& Ring, int32_t Meridians, float Radius, float Z, bool bFacingDown)
+	{
+		const FVec3 Normal = bFacingDown ? FVec3(0, 0, -1) : FVec3(0, 0, 1);
+
+		// The UVs are the disk seen from above, so U grows along X and V along Y
+		const FTangent Tangent = MakeTangent(Normal, FVec3(Radius, 0, 0), FVec3(0, Radius, 0));
+
+		// Add center vertex for the disk (center of UV space)
+		int32_t CenterIndex = Writer.AddVertex(FVec3(0, 0, Z), Normal, Tangent, FVec2(0.5f, 0.5f));
+
+		// Add vertices around the disk edge
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			float CosAngle = Ring.Cos[MeridianIdx];
+			float SinAngle = Ring.Sin[MeridianIdx];
+
+			FVec3 EdgeVertex = FVec3(Radius * CosAngle, Radius * SinAngle, Z);
+
+			// UV mapped in circular pattern
+			float U = 0.5f + 0.5f * CosAngle;
+			float V = 0.5f + 0.5f * SinAngle;
+			Writer.AddVertex(EdgeVertex, Normal, Tangent, FVec2(U, V));
+		}
+
+		// Create triangular fan for the disk; the downward one has reversed winding for correct facing
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t NextIdx = (MeridianIdx + 1) % Meridians;
+
+			if (bFacingDown)
+			{
+				// Triangle: Center -> Current edge -> Next edge
+				Writer.AddTriangle(CenterIndex, CenterIndex + 1 + MeridianIdx, CenterIndex + 1 + NextIdx);
+			}
+			else
+			{
+				// Triangle: Center -> Next edge -> Current edge
+				Writer.AddTriangle(CenterIndex, CenterIndex + 1 + NextIdx, CenterIndex + 1 + MeridianIdx);
+			}
+		}
+	}
+
+	// Side of a cone or cylinder: one top/bottom vertex pair per meridian, every meridian sharing SlopeZ in its normal
+	template <typename WriterType>
+	void AddConeBody(WriterType& Writer, const FRingView& Ring, int32_t Meridians, float TopRadius, float BottomRadius, float HalfHeight, float SlopeZ)
+	{
+		// Create vertices for top and bottom circles
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			float CosAngle = Ring.Cos[MeridianIdx];
+			float SinAngle = Ring.Sin[MeridianIdx];
+
+			// The normal is perpendicular to the surface: horizontal for a cylinder, sloped with a cone
+			FVec3 SlopeDirection = FVec3(CosAngle, SinAngle, SlopeZ).GetSafeNormal();
+
+			// UV for the body
+			float U = float(MeridianIdx) / float(Meridians);
+
+			FVec3 TopVertex = FVec3(TopRadius * CosAngle, TopRadius * SinAngle, HalfHeight);
+			FVec3 BottomVertex = FVec3(BottomRadius * CosAngle, BottomRadius * SinAngle, -HalfHeight);
+
+			// U goes around with the meridian angle and V up the slant, bottom to top
+			FTangent Tangent = MakeTangent(SlopeDirection, FVec3(-SinAngle, CosAngle, 0) * (TopRadius + BottomRadius), TopVertex - BottomVertex);
+
+			// Top circle vertex
+			Writer.AddVertex(TopVertex, SlopeDirection, Tangent, FVec2(U, 1.0f)); // Top
+
+			// Bottom circle vertex
+			Writer.AddVertex(BottomVertex, SlopeDirection, Tangent, FVec2(U, 0.0f)); // Bottom
+		}
+
+		// Generate triangles for the body (quads made of 2 triangles)
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t NextIdx = (MeridianIdx + 1) % Meridians;
+
+			// Vertex indices (alternating top/bottom pattern)
+			int32_t TopCurrent = MeridianIdx * 2;
+			int32_t BottomCurrent = MeridianIdx * 2 + 1;
+			int32_t TopNext = NextIdx * 2;
+			int32_t BottomNext = NextIdx * 2 + 1;
+
+			// First triangle (Top-Current, Top-Next, Bottom-Current)
+			Writer.AddTriangle(TopCurrent, TopNext, BottomCurrent);
+
+			// Second triangle (Top-Next, Bottom-Next, Bottom-Current)
+			Writer.AddTriangle(TopNext, BottomNext, BottomCurrent);
+		}
+	}
+
+	template <typename WriterType>
+	void BuildCone(const FProceduralConeParams& Params, WriterType& Writer)
+	{
+		// Arrays to hold mesh data, sized once for the whole shape
+		Writer.Reset(ComputeConeCapacity(Params));
+
+		// Ensure minimum values
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+		float HalfHeight = Params.Height * 0.5f;
+
+		// Clamp TopRadius to be non-negative and not larger than BottomRadius
+		float SafeTopRadius = Math::Max(0.0f, Params.TopRadius);
+		float SafeBottomRadius = Math::Max(0.0f, Params.BottomRadius);
+
+		// Determine if this is a complete cone (apex) or truncated cone (frustum)
+		bool bIsTruncated = SafeTopRadius > 0.01f;
+
+		// The body and both caps sample the same meridian angles
+		FRingView Ring = Writer.GetRing(Meridians);
+
+		// --- PART 1: Generate Cone Body ---
+		float RadiusDiff = SafeBottomRadius - SafeTopRadius;
+		AddConeBody(Writer, Ring, Meridians, SafeTopRadius, SafeBottomRadius, HalfHeight, RadiusDiff / Params.Height);
+
+		// --- PART 2: Generate Top Cap (only if truncated) ---
+		if (bIsTruncated)
+		{
+			AddDiskCap(Writer, Ring, Meridians, SafeTopRadius, HalfHeight, false);
+		}
+
+		// --- PART 3: Generate Bottom Cap ---
+		AddDiskCap(Writer, Ring, Meridians, SafeBottomRadius, -HalfHeight, true);
+	}
+
+	inline FProceduralMeshCapacity ComputeCylinderCapacity(const FProceduralCylinderParams& Params)
+	{
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+
+		// Body: one top/bottom vertex pair and one quad per meridian
+		// Caps: a center vertex plus a ring, fanned into one triangle per meridian, on both ends
+		int32_t NumVertices = 2 * Meridians + 2 * (1 + Meridians);
+		int32_t NumIndices = 6 * Meridians + 2 * 3 * Meridians;
+		return FProceduralMeshCapacity(NumVertices, NumIndices);
+	}
+
+	template <typename WriterType>
+	void BuildCylinder(const FProceduralCylinderParams& Params, WriterType& Writer)
+	{
+		// Arrays to hold mesh data, sized once for the whole shape
+		Writer.Reset(ComputeCylinderCapacity(Params));
+
+		// Ensure minimum values
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+		float HalfHeight = Params.Height * 0.5f;
+
+		// The body and both caps sample the same meridian angles
+		FRingView Ring = Writer.GetRing(Meridians);
+
+		// --- PART 1: Generate Cylinder Body (normals point outward horizontally) ---
+		AddConeBody(Writer, Ring, Meridians, Params.Radius, Params.Radius, HalfHeight, 0.0f);
+
+		// --- PART 2 and 3: Generate both Disk Caps (using center vertex + triangular fan) ---
+		AddDiskCap(Writer, Ring, Meridians, Params.Radius, HalfHeight, false);
+		AddDiskCap(Writer, Ring, Meridians, Params.Radius, -HalfHeight, true);
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Trapezoid
+	// ---------------------------------------------------------------------------------------------
+
+	inline FProceduralMeshCapacity ComputeTrapezoidCapacity(const FProceduralTrapezoidParams& /*Params*/)
+	{
+		// Six faces, each with its own 4 vertices (hard edges) and 2 triangles
+		return FProceduralMeshCapacity(6 * 4, 6 * 6);
+	}
+
+	template <typename WriterType>
+	void BuildTrapezoid(const FProceduralTrapezoidParams& Params, WriterType& Writer)
+	{
+		// Arrays to hold mesh data, sized once for the whole prism
+		Writer.Reset(ComputeTrapezoidCapacity(Params));
+
+		// Calculate half dimensions for centering
+		float HalfTopWidth = Params.TopWidth * 0.5f;
+		float HalfBottomWidth = Params.BottomWidth * 0.5f;
+		float HalfHeight = Params.Height * 0.5f;
+		float HalfDepth = Params.Depth * 0.5f;
+
+		// --- Define the 8 vertices of the trapezoid prism ---
+
+		// Front face (4 vertices forming a trapezoid)
+		FVec3 FrontTopLeft = FVec3(-HalfTopWidth, -HalfDepth, HalfHeight);
+		FVec3 FrontTopRight = FVec3(HalfTopWidth, -HalfDepth, HalfHeight);
+		FVec3 FrontBottomLeft = FVec3(-HalfBottomWidth, -HalfDepth, -HalfHeight);
+		FVec3 FrontBottomRight = FVec3(HalfBottomWidth, -HalfDepth, -HalfHeight);
+
+		// Back face (4 vertices forming a trapezoid)
+		FVec3 BackTopLeft = FVec3(-HalfTopWidth, HalfDepth, HalfHeight);
+		FVec3 BackTopRight = FVec3(HalfTopWidth, HalfDepth, HalfHeight);
+		FVec3 BackBottomLeft = FVec3(-HalfBottomWidth, HalfDepth, -HalfHeight);
+		FVec3 BackBottomRight = FVec3(HalfBottomWidth, HalfDepth, -HalfHeight);
+
+		// UV layouts shared by the faces
+		const FVec2 FaceUVs[4] = { FVec2(0, 1), FVec2(1, 1), FVec2(1, 0), FVec2(0, 0) };
+		const FVec2 BottomFaceUVs[4] = { FVec2(0, 0), FVec2(1, 0), FVec2(1, 1), FVec2(0, 1) };
+
+		// --- FRONT FACE ---
+		AddFlatQuad(Writer, FrontTopLeft, FrontTopRight, FrontBottomRight, FrontBottomLeft, FVec3(0, -1, 0), FaceUVs);
+
+		// --- BACK FACE ---
+		AddFlatQuad(Writer, BackTopRight, BackTopLeft, BackBottomLeft, BackBottomRight, FVec3(0, 1, 0), FaceUVs);
+
+		// --- TOP FACE (Rectangle) ---
+		AddFlatQuad(Writer, BackTopLeft, BackTopRight, FrontTopRight, FrontTopLeft, FVec3(0, 0, 1), FaceUVs);
+
+		// --- BOTTOM FACE (Rectangle) ---
+		AddFlatQuad(Writer, FrontBottomLeft, FrontBottomRight, BackBottomRight, BackBottomLeft, FVec3(0, 0, -1), BottomFaceUVs);
+
+		// --- LEFT SLANTED FACE ---
+
+		// Calculate normal for slanted face
+		FVec3 LeftEdge1 = FrontTopLeft - BackTopLeft;
+		FVec3 LeftEdge2 = FrontBottomLeft - BackTopLeft;
+		FVec3 LeftNormal = FVec3::CrossProduct(LeftEdge2, LeftEdge1).GetSafeNormal();
+
+		AddFlatQuad(Writer, BackTopLeft, FrontTopLeft, FrontBottomLeft, BackBottomLeft, LeftNormal, FaceUVs);
+
+		// --- RIGHT SLANTED FACE ---
+
+		// Calculate normal for slanted face
+		FVec3 RightEdge1 = BackTopRight - FrontTopRight;
+		FVec3 RightEdge2 = BackBottomRight - FrontTopRight;
+		FVec3 RightNormal = FVec3::CrossProduct(RightEdge2, RightEdge1).GetSafeNormal();
+
+		AddFlatQuad(Writer, FrontTopRight, BackTopRight, BackBottomRight, FrontBottomRight, RightNormal, FaceUVs);
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Plane
+	// ---------------------------------------------------------------------------------------------
+
+	// The whole grid as a single tile
+	inline FProceduralPlaneTile MakeWholePlaneTile(const FProceduralPlaneParams& Params)
+	{
+		FProceduralPlaneTile Tile;
+		Tile.NumRows = Math::Max(0, Params.Nb_Lignes);
+		Tile.NumCols = Math::Max(0, Params.Nb_Colones);
+		return Tile;
+	}
+
+	// Grid corners skipped between two vertices of the tile
+	inline int32_t GetPlaneTileStep(const FProceduralPlaneTile& Tile)
+	{
+		return 1 << Math::Max(0, Tile.LOD);
+	}
+
+	inline FProceduralMeshCapacity ComputePlaneTileCapacity(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile)
+	{
+		int32_t Step = GetPlaneTileStep(Tile);
+		int32_t Rows = Math::Max(0, Tile.NumRows) / Step;
+		int32_t Cols = Math::Max(0, Tile.NumCols) / Step;
+		int32_t NumQuads = Rows * Cols;
+
+		// Two triangles hang below every edge along the tile's border
+		int32_t NumSkirtTriangles = NumQuads > 0 && Tile.SkirtDepth > 0.0f ? 4 * (Rows + Cols) : 0;
+
+		if (Params.bUseIndexedGrid)
+		{
+			// One shared vertex per grid corner, two triangles per quad, and a lowered copy of each border's corners
+			int32_t NumVertices = NumQuads > 0 ? (Rows + 1) * (Cols + 1) : 0;
+			int32_t NumSkirtVertices = NumSkirtTriangles > 0 ? 2 * (Rows + Cols) + 4 : 0;
+			return FProceduralMeshCapacity(NumVertices + NumSkirtVertices, 6 * NumQuads + 3 * NumSkirtTriangles);
+		}
+
+		// Two flat triangles with their own three vertices per quad
+		return FProceduralMeshCapacity(6 * NumQuads + 3 * NumSkirtTriangles, 6 * NumQuads + 3 * NumSkirtTriangles);
+	}
+
+	inline FProceduralMeshCapacity ComputePlaneCapacity(const FProceduralPlaneParams& Params)
+	{
+		return ComputePlaneTileCapacity(Params, MakeWholePlaneTile(Params));
+	}
+
+	inline bool HasPlaneHeightSamples(const FProceduralPlaneParams& Params)
+	{
+		return Params.HeightSamples != nullptr && Params.HeightSamplesX > 0 && Params.HeightSamplesY > 0;
+	}
+
+	inline bool HasPlaneNoise(const FProceduralPlaneParams& Params)
+	{
+		return Params.NoiseAmplitude != 0.0f && Params.NoiseOctaves > 0 && Params.NoiseScale > 0.0f;
+	}
+
+	// False for a flat plane
+	inline bool HasPlaneHeights(const FProceduralPlaneParams& Params)
+	{
+		return HasPlaneHeightSamples(Params) || HasPlaneNoise(Params);
+	}
+
+	// Integer hash of one noise lattice corner; the same on every platform
+	inline uint32_t HashNoiseCorner(int64_t X, int64_t Y, int32_t Seed)
+	{
+		uint32_t Hash = uint32_t(X) * 0x8da6b343u + uint32_t(Y) * 0xd8163841u + uint32_t(Seed) * 0xcb1ab31fu;
+		Hash ^= Hash >> 16;
+		Hash *= 0x7feb352du;
+		Hash ^= Hash >> 15;
+		Hash *= 0x846ca68bu;
+		Hash ^= Hash >> 16;
+		return Hash;
+	}
+
+	// 2D gradient noise in [-1, 1]: one of eight unit gradients per lattice corner, blended with a quintic fade
+	inline double GradientNoise(double X, double Y, int32_t Seed)
+	{
+		static constexpr double Diagonal = 0.70710678118654752;
+		static constexpr double GradientX[8] = { 1.0, -1.0, 0.0, 0.0, Diagonal, -Diagonal, Diagonal, -Diagonal };
+		static constexpr double GradientY[8] = { 0.0, 0.0, 1.0, -1.0, Diagonal, Diagonal, -Diagonal, -Diagonal };
+
+		const double CellX = std::floor(X);
+		const double CellY = std::floor(Y);
+		const int64_t X0 = int64_t(CellX);
+		const int64_t Y0 = int64_t(CellY);
+		const double FracX = X - CellX;
+		const double FracY = Y - CellY;
+
+		double CornerValues[4];
+		for (int32_t Corner = 0; Corner < 4; Corner++)
+		{
+			const int32_t OffsetX = Corner & 1;
+			const int32_t OffsetY = Corner >> 1;
+			const uint32_t Gradient = HashNoiseCorner(X0 + OffsetX, Y0 + OffsetY, Seed) & 7;
+			CornerValues[Corner] = GradientX[Gradient] * (FracX - OffsetX) + GradientY[Gradient] * (FracY - OffsetY);
+		}
+
+		const double FadeX = FracX * FracX * FracX * (FracX * (FracX * 6.0 - 15.0) + 10.0);
+		const double FadeY = FracY * FracY * FracY * (FracY * (FracY * 6.0 - 15.0) + 10.0);
+		const double Bottom = CornerValues[0] + (CornerValues[1] - CornerValues[0]) * FadeX;
+		const double Top = CornerValues[2] + (CornerValues[3] - CornerValues[2]) * FadeX;
+
+		// Unit gradients peak at sqrt(2) / 2
+		return (Bottom + (Top - Bottom) * FadeY) * 1.4142135623730951;
+	}
+
+	// NumOctaves octaves of gradient noise, each at twice the frequency and half the amplitude of the last, in [-1, 1]
+	inline double FractalNoise(double X, double Y, int32_t NumOctaves, int32_t Seed)
+	{
+		double Sum = 0.0;
+		double Amplitude = 1.0;
+		double TotalAmplitude = 0.0;
+		for (int32_t Octave = 0; Octave < NumOctaves; Octave++)
+		{
+			Sum += Amplitude * GradientNoise(X, Y, Seed + Octave);
+			TotalAmplitude += Amplitude;
+			X *= 2.0;
+			Y *= 2.0;
+			Amplitude *= 0.5;
+		}
+		return TotalAmplitude > 0.0 ? Sum / TotalAmplitude : 0.0;
+	}
+
+	// Height of one corner of Params' grid. Both sources are placed by world position, so the corners of a coarser LOD
+	// grid land on the same heights as the full-detail corners under them
+	inline float GetPlaneHeight(const FProceduralPlaneParams& Params, int32_t Row, int32_t Col)
+	{
+		double Height = 0.0;
+		if (HasPlaneHeightSamples(Params))
+		{
+			// Bilinear between the four samples around the corner
+			double SampleX = Params.Nb_Colones > 0 ? double(Col) * double(Params.HeightSamplesX - 1) / double(Params.Nb_Colones) : 0.0;
+			double SampleY = Params.Nb_Lignes > 0 ? double(Row) * double(Params.HeightSamplesY - 1) / double(Params.Nb_Lignes) : 0.0;
+			int32_t X0 = Math::Clamp(int32_t(std::floor(SampleX)), 0, Params.HeightSamplesX - 1);
+			int32_t Y0 = Math::Clamp(int32_t(std::floor(SampleY)), 0, Params.HeightSamplesY - 1);
+			int32_t X1 = Math::Min(X0 + 1, Params.HeightSamplesX - 1);
+			int32_t Y1 = Math::Min(Y0 + 1, Params.HeightSamplesY - 1);
+			double FracX = Math::Clamp(SampleX - X0, 0.0, 1.0);
+			double FracY = Math::Clamp(SampleY - Y0, 0.0, 1.0);
+
+			const float* SamplesBelow = Params.HeightSamples + size_t(Y0) * size_t(Params.HeightSamplesX);
+			const float* SamplesAbove = Params.HeightSamples + size_t(Y1) * size_t(Params.HeightSamplesX);
+			double Bottom = SamplesBelow[X0] + (SamplesBelow[X1] - SamplesBelow[X0]) * FracX;
+			double Top = SamplesAbove[X0] + (SamplesAbove[X1] - SamplesAbove[X0]) * FracX;
+			Height += Params.HeightScale * (Bottom + (Top - Bottom) * FracY);
+		}
+		if (HasPlaneNoise(Params))
+		{
+			double CellScale = double(Params.QuadSize) / double(Params.NoiseScale);
+			Height += Params.NoiseAmplitude * FractalNoise(Col * CellScale, Row * CellScale, Params.NoiseOctaves, Params.NoiseSeed);
+		}
+		return float(Height);
+	}
+
+	/**
+	 * Heights of a tile's corners at its LOD step with one more corner all around for the central differences, row-major in
+	 * rows of NumCols / Step + 3. Corners past the edge of the plane continue the slope of the last two inside it, so the
+	 * border normals see no cliff. A flat plane gets a single row of zeros and a stride of 0. Returns the row stride
+	 */
+	inline int32_t ComputePlaneTileHeights(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile, std::vector<float>& OutHeights)
+	{
+		const int32_t Step = GetPlaneTileStep(Tile);
+		const int32_t Rows = Tile.NumRows / Step;
+		const int32_t Cols = Tile.NumCols / Step;
+		const int32_t Stride = Cols + 3;
+		if (!HasPlaneHeights(Params))
+		{
+			OutHeights.assign(size_t(Stride), 0.0f);
+			return 0;
+		}
+
+		OutHeights.assign(size_t(Rows + 3) * size_t(Stride), 0.0f);
+		for (int32_t PaddedRow = 0; PaddedRow < Rows + 3; PaddedRow++)
+		{
+			int32_t Row = Tile.FirstRow + (PaddedRow - 1) * Step;
+			if (Row < 0 || Row > Params.Nb_Lignes)
+			{
+				continue;
+			}
+			for (int32_t PaddedCol = 0; PaddedCol < Cols + 3; PaddedCol++)
+			{
+				int32_t Col = Tile.FirstCol + (PaddedCol - 1) * Step;
+				if (Col >= 0 && Col <= Params.Nb_Colones)
+				{
+					OutHeights[size_t(PaddedRow) * Stride + PaddedCol] = GetPlaneHeight(Params, Row, Col);
+				}
+			}
+		}
+
+		// Columns first, then whole rows, so the outer corners are extrapolated as well
+		for (int32_t PaddedRow = 0; PaddedRow < Rows + 3; PaddedRow++)
+		{
+			float* Heights = OutHeights.data() + size_t(PaddedRow) * Stride;
+			if (Tile.FirstCol - Step < 0)
+			{
+				Heights[0] = 2.0f * Heights[1] - Heights[2];
+			}
+			if (Tile.FirstCol + Tile.NumCols + Step > Params.Nb_Colones)
+			{
+				Heights[Cols + 2] = 2.0f * Heights[Cols + 1] - Heights[Cols];
+			}
+		}
+		for (int32_t PaddedCol = 0; PaddedCol < Cols + 3; PaddedCol++)
+		{
+			float* Heights = OutHeights.data() + PaddedCol;
+			if (Tile.FirstRow - Step < 0)
+			{
+				Heights[0] = 2.0f * Heights[Stride] - Heights[2 * Stride];
+			}
+			if (Tile.FirstRow + Tile.NumRows + Step > Params.Nb_Lignes)
+			{
+				Heights[size_t(Rows + 2) * Stride] = 2.0f * Heights[size_t(Rows + 1) * Stride] - Heights[size_t(Rows) * Stride];
+			}
+		}
+		return Stride;
+	}
+
+	// One border of a tile's grid: NumEdges edges from the corner (Row, Col), stepping by (RowStep, ColStep) corners
+	struct FPlaneTileBorder
+	{
+		int32_t Row = 0;
+		int32_t Col = 0;
+		int32_t RowStep = 0;
+		int32_t ColStep = 0;
+		int32_t NumEdges = 0;
+	};
+
+	// The four borders of a Rows x Cols grid counter-clockwise seen from above, so a skirt wound like the grid faces outward:
+	// west to east along the first row, up the last column, back along the last row and down the first column
+	inline void GetPlaneTileBorders(int32_t Rows, int32_t Cols, FPlaneTileBorder (&OutBorders)[4])
+	{
+		OutBorders[0] = FPlaneTileBorder{ 0, 0, 0, 1, Cols };
+		OutBorders[1] = FPlaneTileBorder{ 0, Cols, 1, 0, Rows };
+		OutBorders[2] = FPlaneTileBorder{ Rows, Cols, 0, -1, Cols };
+		OutBorders[3] = FPlaneTileBorder{ Rows, 0, -1, 0, Rows };
+	}
+
+	// Legacy layout: every quad as two flat triangles with their own vertices
+	template <typename WriterType>
+	void BuildPlaneTriangleSoup(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile, WriterType& Writer)
+	{
+		const int32_t Step = GetPlaneTileStep(Tile);
+		const int32_t Rows = Tile.NumRows / Step;
+		const int32_t Cols = Tile.NumCols / Step;
+		if (Rows <= 0 || Cols <= 0)
+		{
+			return;
+		}
+
+		std::vector<float> Heights;
+		const int32_t HeightStride = ComputePlaneTileHeights(Params, Tile, Heights);
+
+		// Corner of the tile's grid, displaced
+		auto GetCorner = [&](int32_t TileRow, int32_t TileCol)
+		{
+			int32_t Row = Tile.FirstRow + TileRow * Step;
+			int32_t Col = Tile.FirstCol + TileCol * Step;
+			return FVec3(Col * Params.QuadSize, Row * Params.QuadSize, Heights[size_t(TileRow + 1) * HeightStride + TileCol + 1]);
+		};
+
+		// Generate a grid of quads, each made of 2 triangles
+		// The plane will be in the XY plane (horizontal)
+		for (int32_t TileRow = 0; TileRow < Rows; TileRow++)
+		{
+			// A newer request superseded this build
+			if (Writer.IsCancelled())
+			{
+				return;
+			}
+
+			for (int32_t TileCol = 0; TileCol < Cols; TileCol++)
+			{
+				// Calculate the four corners of the quad
+				FVec3 BottomLeft = GetCorner(TileRow, TileCol);
+				FVec3 BottomRight = GetCorner(TileRow, TileCol + 1);
+				FVec3 TopLeft = GetCorner(TileRow + 1, TileCol);
+				FVec3 TopRight = GetCorner(TileRow + 1, TileCol + 1);
+
+				// Create first triangle (Bottom-Left, Top-Left, Bottom-Right)
+				AddFlatTriangle(Writer, BottomLeft, TopLeft, BottomRight);
+
+				// Create second triangle (Bottom-Right, Top-Left, Top-Right)
+				AddFlatTriangle(Writer, BottomRight, TopLeft, TopRight);
+			}
+		}
+
+		if (Tile.SkirtDepth > 0.0f)
+		{
+			// Each border edge gets a quad down to SkirtDepth below it
+			const FVec3 Drop(0, 0, Tile.SkirtDepth);
+			FPlaneTileBorder Borders[4];
+			GetPlaneTileBorders(Rows, Cols, Borders);
+			for (const FPlaneTileBorder& Border : Borders)
+			{
+				for (int32_t Edge = 0; Edge < Border.NumEdges; Edge++)
+				{
+					FVec3 Start = GetCorner(Border.Row + Edge * Border.RowStep, Border.Col + Edge * Border.ColStep);
+					FVec3 End = GetCorner(Border.Row + (Edge + 1) * Border.RowStep, Border.Col + (Edge + 1) * Border.ColStep);
+					AddFlatTriangle(Writer, Start, End, Start - Drop);
+					AddFlatTriangle(Writer, End, End - Drop, Start - Drop);
+				}
+			}
+		}
+	}
+
+	// Indexed layout: (NumRows + 1) * (NumCols + 1) shared vertices per tile at its step. UVs span the whole grid and the
+	// normals come from central differences across tile borders, so the vertices on the border of two tiles at the same
+	// LOD are identical in both
+	template <typename WriterType>
+	void BuildPlaneIndexedGrid(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile, WriterType& Writer)
+	{
+		const int32_t Step = GetPlaneTileStep(Tile);
+		const int32_t Rows = Tile.NumRows / Step;
+		const int32_t Cols = Tile.NumCols / Step;
+		if (Rows <= 0 || Cols <= 0)
+		{
+			return;
+		}
+
+		std::vector<float> Heights;
+		const int32_t HeightStride = ComputePlaneTileHeights(Params, Tile, Heights);
+		auto GetRowHeights = [&](int32_t TileRow) { return Heights.data() + size_t(TileRow + 1) * HeightStride + 1; };
+
+		// Row TileRow of the tile's grid; a flat plane gets an up normal and a tangent along X
+		FProceduralGridRowParams RowParams;
+		RowParams.QuadSize = Params.QuadSize;
+		RowParams.FirstCol = Tile.FirstCol;
+		RowParams.ColStep = Step;
+		RowParams.NumCols = Params.Nb_Colones;
+		RowParams.SlopeScaleX = Params.QuadSize != 0.0f ? 1.0f / (2.0f * float(Step) * Params.QuadSize) : 0.0f;
+		RowParams.SlopeScaleY = RowParams.SlopeScaleX;
+		RowParams.TangentSign = Math::Sign(Params.QuadSize);
+		auto GetRowParams = [&](int32_t TileRow)
+		{
+			int32_t Row = Tile.FirstRow + TileRow * Step;
+			RowParams.Y = Row * Params.QuadSize;
+			RowParams.V = float(Row) / float(Params.Nb_Lignes);
+			return RowParams;
+		};
+
+		// One vertex per grid corner, row-major, with UVs spanning the whole plane once
+		for (int32_t TileRow = 0; TileRow <= Rows; TileRow++)
+		{
+			// A newer request superseded this build
+			if (Writer.IsCancelled())
+			{
+				return;
+			}
+
+			const float* RowHeights = GetRowHeights(TileRow);
+			Writer.AddGridRow(GetRowParams(TileRow), RowHeights, RowHeights - HeightStride, RowHeights + HeightStride, Cols + 1);
+		}
+
+		// Same winding as the triangle soup: (Bottom-Left, Top-Left, Bottom-Right) and (Bottom-Right, Top-Left, Top-Right)
+		int32_t Stride = Cols + 1;
+		for (int32_t Row = 0; Row < Rows; Row++)
+		{
+			for (int32_t Col = 0; Col < Cols; Col++)
+			{
+				int32_t BottomLeft = Row * Stride + Col;
+				int32_t BottomRight = BottomLeft + 1;
+				int32_t TopLeft = BottomLeft + Stride;
+				int32_t TopRight = TopLeft + 1;
+
+				Writer.AddTriangle(BottomLeft, TopLeft, BottomRight);
+				Writer.AddTriangle(BottomRight, TopLeft, TopRight);
+			}
+		}
+
+		if (Tile.SkirtDepth > 0.0f)
+		{
+			// Every border corner gets a copy SkirtDepth lower, with the corner's own normal, tangent and UV so the skirt
+			// shades like the edge it hangs from
+			auto AddSkirtVertex = [&](int32_t TileRow, int32_t TileCol)
+			{
+				FProceduralGridRowParams CornerParams = GetRowParams(TileRow);
+				CornerParams.FirstCol += TileCol * Step;
+				const float* CornerHeights = GetRowHeights(TileRow) + TileCol;
+				FStoredVec3 Position, Normal;
+				FStoredVec4 Tangent;
+				FStoredVec2 UV;
+				EmitGridRow(CornerParams, CornerHeights, CornerHeights - HeightStride, CornerHeights + HeightStride, 1, &Position, &Normal, &Tangent, &UV);
+				return Writer.AddVertex(FVec3(Position.X, Position.Y, Position.Z - Tile.SkirtDepth), FVec3(Normal.X, Normal.Y, Normal.Z),
+					FTangent(FVec3(Tangent.X, Tangent.Y, Tangent.Z), Tangent.W < 0.0f), FVec2(UV.X, UV.Y));
+			};
+
+			FPlaneTileBorder Borders[4];
+			GetPlaneTileBorders(Rows, Cols, Borders);
+			for (const FPlaneTileBorder& Border : Borders)
+			{
+				int32_t PreviousTop = 0;
+				int32_t PreviousBottom = 0;
+				for (int32_t Corner = 0; Corner <= Border.NumEdges; Corner++)
+				{
+					int32_t TileRow = Border.Row + Corner * Border.RowStep;
+					int32_t TileCol = Border.Col + Corner * Border.ColStep;
+					int32_t Top = TileRow * Stride + TileCol;
+					int32_t Bottom = AddSkirtVertex(TileRow, TileCol);
+					if (Corner > 0)
+					{
+						Writer.AddTriangle(PreviousTop, Top, PreviousBottom);
+						Writer.AddTriangle(Top, Bottom, PreviousBottom);
+					}
+					PreviousTop = Top;
+					PreviousBottom = Bottom;
+				}
+			}
+		}
+	}
+
+	// One tile of the grid; tiles share the grid's positions, so they line up without seams
+	template <typename WriterType>
+	void BuildPlaneTile(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile, WriterType& Writer)
+	{
+		// Arrays to hold mesh data, sized once for the whole tile
+		Writer.Reset(ComputePlaneTileCapacity(Params, Tile));
+
+		if (Params.bUseIndexedGrid)
+		{
+			BuildPlaneIndexedGrid(Params, Tile, Writer);
+		}
+		else
+		{
+			BuildPlaneTriangleSoup(Params, Tile, Writer);
+		}
+	}
+
+	template <typename WriterType>
+	void BuildPlane(const FProceduralPlaneParams& Params, WriterType& Writer)
+	{
+		BuildPlaneTile(Params, MakeWholePlaneTile(Params), Writer);
+	}
+}
@@ -0,0 +1,36 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralGeometryStats.h"
+
+DEFINE_STAT(STAT_ProceduralVertexMemory);
+DEFINE_STAT(STAT_ProceduralIndexMemory);
+DEFINE_STAT(STAT_ProceduralLiveMeshes);
+
+FProceduralShapeStats FProceduralShapeStats::Get(FName ShapeType)
+{
+#if STATS
+	static FCriticalSection Lock;
+	static TMap<FName, FProceduralShapeStats> ShapeStats;
+
+	FScopeLock ScopeLock(&Lock);
+	if (const FProceduralShapeStats* Existing = ShapeStats.Find(ShapeType))
+	{
+		return *Existing;
+	}
+
+	auto MakeStatId = [&ShapeType](const TCHAR* Phase)
+	{
+		return FDynamicStats::CreateStatId<FStatGroup_STATGROUP_ProceduralGeometry>(FString::Printf(TEXT("%s %s"), *ShapeType.ToString(), Phase));
+	};
+
+	FProceduralShapeStats Stats;
+	Stats.Build = MakeStatId(TEXT("Build"));
+	Stats.Upload = MakeStatId(TEXT("Upload"));
+	Stats.Collision = MakeStatId(TEXT("Collision"));
+	Stats.Material = MakeStatId(TEXT("Material"));
+	return ShapeStats.Add(ShapeType, Stats);
+#else
+	return FProceduralShapeStats();
+#endif
+}
@@ -0,0 +1,36 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("ProceduralGeometry"), STATGROUP_ProceduralGeometry, STATCAT_Advanced);
+
+// Arrays of every generated mesh still alive: cached, committed to a component or kept as a spare buffer
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Vertex Data"), STAT_ProceduralVertexMemory, STATGROUP_ProceduralGeometry, MODELLING3DONE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Index Data"), STAT_ProceduralIndexMemory, STATGROUP_ProceduralGeometry, MODELLING3DONE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Meshes"), STAT_ProceduralLiveMeshes, STATGROUP_ProceduralGeometry, MODELLING3DONE_API);
+
+/**
+ * Cycle counters of one shape type in STATGROUP_ProceduralGeometry, one per pipeline phase ("Sphere Build",
+ * "Sphere Upload", ...). Registered the first time a shape type is timed, so new shapes need no declaration.
+ * Compiled out with the stats system; the phases still show up in Insights through their trace scopes.
+ */
+struct MODELLING3DONE_API FProceduralShapeStats
+{
+	// Generating the arrays, on whichever thread runs the build
+	TStatId Build;
+
+	// CreateMeshSection or UpdateMeshSection on the game thread, including the body setup refresh of a section with collision
+	TStatId Upload;
+
+	// Simple collision: hulls and collision primitives. Triangle meshes are cooked asynchronously, outside any counter here
+	TStatId Collision;
+
+	// Materials and LOD section visibility
+	TStatId Material;
+
+	// Safe to call from any thread
+	static FProceduralShapeStats Get(FName ShapeType);
+};
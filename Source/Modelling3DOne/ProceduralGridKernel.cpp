@@ -0,0 +1,186 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralGridKernel.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Modelling3DOne.h"
+
+// SSE2 is part of every x64 target
+#define PROCEDURAL_GRID_SIMD PLATFORM_CPU_X86_FAMILY
+
+#if PROCEDURAL_GRID_SIMD
+#include <immintrin.h>
+#endif
+
+// The reference path writes the kernel header's storage types, which have the builder's layout
+static_assert(sizeof(FVector3f) == sizeof(ProceduralGeometry::FStoredVec3), "Grid kernels expect a packed FVector3f");
+static_assert(sizeof(FVector4f) == sizeof(ProceduralGeometry::FStoredVec4), "Grid kernels expect a packed FVector4f");
+static_assert(sizeof(FVector2f) == sizeof(ProceduralGeometry::FStoredVec2), "Grid kernels expect a packed FVector2f");
+
+namespace
+{
+	void EmitGridRowScalar(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove, int32 Count,
+		FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+	{
+		ProceduralGeometry::EmitGridRow(Params, Heights, HeightsBelow, HeightsAbove, Count,
+			reinterpret_cast<ProceduralGeometry::FStoredVec3*>(OutPositions), reinterpret_cast<ProceduralGeometry::FStoredVec3*>(OutNormals),
+			reinterpret_cast<ProceduralGeometry::FStoredVec4*>(OutTangents), reinterpret_cast<ProceduralGeometry::FStoredVec2*>(OutUVs));
+	}
+
+#if PROCEDURAL_GRID_SIMD
+	// Interleaves four vertices held as X, Y and Z lanes into x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+	FORCEINLINE void StoreVectors4(FVector3f* Out, __m128 X, __m128 Y, __m128 Z)
+	{
+		float* Dest = reinterpret_cast<float*>(Out);
+		const __m128 XYLow = _mm_unpacklo_ps(X, Y);
+		const __m128 XYHigh = _mm_unpackhi_ps(X, Y);
+		_mm_storeu_ps(Dest + 0, _mm_shuffle_ps(XYLow, _mm_shuffle_ps(Z, XYLow, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storeu_ps(Dest + 4, _mm_shuffle_ps(_mm_shuffle_ps(XYLow, Z, _MM_SHUFFLE(1, 1, 3, 3)), XYHigh, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(Dest + 8, _mm_shuffle_ps(_mm_shuffle_ps(Z, XYHigh, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(XYHigh, Z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+
+	// Grid tangents are (X, 0, Z) with a binormal sign of 1
+	FORCEINLINE void StoreTangents4(FVector4f* Out, __m128 X, __m128 Z)
+	{
+		float* Dest = reinterpret_cast<float*>(Out);
+		const __m128 XZeroLow = _mm_unpacklo_ps(X, _mm_setzero_ps());
+		const __m128 XZeroHigh = _mm_unpackhi_ps(X, _mm_setzero_ps());
+		const __m128 ZSignLow = _mm_unpacklo_ps(Z, _mm_set1_ps(1.0f));
+		const __m128 ZSignHigh = _mm_unpackhi_ps(Z, _mm_set1_ps(1.0f));
+		_mm_storeu_ps(Dest + 0, _mm_movelh_ps(XZeroLow, ZSignLow));
+		_mm_storeu_ps(Dest + 4, _mm_movehl_ps(ZSignLow, XZeroLow));
+		_mm_storeu_ps(Dest + 8, _mm_movelh_ps(XZeroHigh, ZSignHigh));
+		_mm_storeu_ps(Dest + 12, _mm_movehl_ps(ZSignHigh, XZeroHigh));
+	}
+
+	FORCEINLINE void StoreUVs4(FVector2f* Out, __m128 U, __m128 V)
+	{
+		float* Dest = reinterpret_cast<float*>(Out);
+		_mm_storeu_ps(Dest + 0, _mm_unpacklo_ps(U, V));
+		_mm_storeu_ps(Dest + 4, _mm_unpackhi_ps(U, V));
+	}
+
+	void EmitGridRowSSE(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove, int32 Count,
+		FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+	{
+		const __m128 One = _mm_set1_ps(1.0f);
+		const __m128 QuadSize = _mm_set1_ps(Params.QuadSize);
+		const __m128 Y = _mm_set1_ps(Params.Y);
+		const __m128 V = _mm_set1_ps(Params.V);
+		const __m128 NumCols = _mm_set1_ps(float(Params.NumCols));
+		const __m128 SlopeScaleX = _mm_set1_ps(Params.SlopeScaleX);
+		const __m128 SlopeScaleY = _mm_set1_ps(Params.SlopeScaleY);
+		const __m128 TangentSign = _mm_set1_ps(Params.TangentSign);
+		const __m128i ColAdvance = _mm_set1_epi32(4 * Params.ColStep);
+		__m128i Col = _mm_add_epi32(_mm_set1_epi32(Params.FirstCol), _mm_setr_epi32(0, Params.ColStep, 2 * Params.ColStep, 3 * Params.ColStep));
+
+		int32 Index = 0;
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			const __m128 Height = _mm_loadu_ps(Heights + Index);
+			const __m128 Left = _mm_loadu_ps(Heights + Index - 1);
+			const __m128 Right = _mm_loadu_ps(Heights + Index + 1);
+			const __m128 Below = _mm_loadu_ps(HeightsBelow + Index);
+			const __m128 Above = _mm_loadu_ps(HeightsAbove + Index);
+
+			// Same operations in the same order as the reference, so every lane rounds the same way
+			const __m128 NegSlopeX = _mm_mul_ps(_mm_sub_ps(Left, Right), SlopeScaleX);
+			const __m128 NegSlopeY = _mm_mul_ps(_mm_sub_ps(Below, Above), SlopeScaleY);
+			const __m128 NormalScale = _mm_div_ps(One, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(NegSlopeX, NegSlopeX), _mm_mul_ps(NegSlopeY, NegSlopeY)), One)));
+			const __m128 SlopeX = _mm_mul_ps(_mm_sub_ps(Right, Left), SlopeScaleX);
+			const __m128 TangentX = _mm_mul_ps(TangentSign, _mm_div_ps(One, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(SlopeX, SlopeX), One))));
+			const __m128 ColFloat = _mm_cvtepi32_ps(Col);
+
+			StoreVectors4(OutPositions + Index, _mm_mul_ps(ColFloat, QuadSize), Y, Height);
+			StoreVectors4(OutNormals + Index, _mm_mul_ps(NegSlopeX, NormalScale), _mm_mul_ps(NegSlopeY, NormalScale), NormalScale);
+			StoreTangents4(OutTangents + Index, TangentX, _mm_mul_ps(SlopeX, TangentX));
+			StoreUVs4(OutUVs + Index, _mm_div_ps(ColFloat, NumCols), V);
+
+			Col = _mm_add_epi32(Col, ColAdvance);
+		}
+
+		FProceduralGridRowParams TailParams = Params;
+		TailParams.FirstCol += Index * Params.ColStep;
+		EmitGridRowScalar(TailParams, Heights + Index, HeightsBelow + Index, HeightsAbove + Index, Count - Index,
+			OutPositions + Index, OutNormals + Index, OutTangents + Index, OutUVs + Index);
+	}
+#endif
+
+	void RunGridKernelBenchmark(const TArray<FString>& Args)
+	{
+		const int32 Cols = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1024);
+		const int32 Rows = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1024);
+		const int32 Iterations = FMath::Max(1, Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 20);
+
+		// Padded like the plane's tile heights: one extra corner all around
+		const int32 Stride = Cols + 3;
+		TArray<float> Heights;
+		Heights.SetNumUninitialized(Stride * (Rows + 3));
+		for (int32 Index = 0; Index < Heights.Num(); Index++)
+		{
+			Heights[Index] = 50.0f * FMath::Sin(0.05f * float(Index % Stride)) * FMath::Cos(0.03f * float(Index / Stride));
+		}
+
+		const int32 NumVertices = (Rows + 1) * (Cols + 1);
+		TArray<FVector3f> ReferenceNormals, Positions, Normals;
+		TArray<FVector4f> Tangents;
+		TArray<FVector2f> UVs;
+		ReferenceNormals.SetNumUninitialized(NumVertices);
+		Positions.SetNumUninitialized(NumVertices);
+		Normals.SetNumUninitialized(NumVertices);
+		Tangents.SetNumUninitialized(NumVertices);
+		UVs.SetNumUninitialized(NumVertices);
+
+		auto EmitGrid = [&](bool bSIMD, TArray<FVector3f>& OutNormals)
+		{
+			FProceduralGridRowParams Params;
+			Params.QuadSize = 100.0f;
+			Params.NumCols = Cols;
+			Params.SlopeScaleX = 1.0f / 200.0f;
+			Params.SlopeScaleY = 1.0f / 200.0f;
+			for (int32 Row = 0; Row <= Rows; Row++)
+			{
+				Params.Y = float(Row) * Params.QuadSize;
+				Params.V = float(Row) / float(Rows);
+				const float* RowHeights = Heights.GetData() + (Row + 1) * Stride + 1;
+				const int32 First = Row * (Cols + 1);
+				(bSIMD ? &FProceduralGridKernel::EmitGridRow : &EmitGridRowScalar)(Params, RowHeights, RowHeights - Stride, RowHeights + Stride, Cols + 1,
+					Positions.GetData() + First, OutNormals.GetData() + First, Tangents.GetData() + First, UVs.GetData() + First);
+			}
+		};
+
+		EmitGrid(false, ReferenceNormals);
+
+		UE_LOG(LogProceduralMesh, Log, TEXT("Grid kernel benchmark: %d x %d quads, %d iterations"), Cols, Rows, Iterations);
+		for (bool bSIMD : { false, true })
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				EmitGrid(bSIMD, Normals);
+			}
+			const double Seconds = (FPlatformTime::Seconds() - StartTime) / Iterations;
+
+			const bool bMatches = FMemory::Memcmp(Normals.GetData(), ReferenceNormals.GetData(), NumVertices * sizeof(FVector3f)) == 0;
+			UE_LOG(LogProceduralMesh, Log, TEXT("  %-6s %8.3f ms  %8.1f Mverts/s%s"), bSIMD ? TEXT("Best") : TEXT("Scalar"),
+				Seconds * 1000.0, NumVertices / Seconds / 1.0e6, bMatches ? TEXT("") : TEXT("  MISMATCH vs scalar"));
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdProceduralGridKernelBench(
+	TEXT("ProceduralMesh.GridKernelBench"),
+	TEXT("Times the scalar and SIMD displaced grid row kernels. Args: [Cols=1024] [Rows=1024] [Iterations=20]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunGridKernelBenchmark));
+
+void FProceduralGridKernel::EmitGridRow(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove,
+	int32 Count, FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+{
+#if PROCEDURAL_GRID_SIMD
+	EmitGridRowSSE(Params, Heights, HeightsBelow, HeightsAbove, Count, OutPositions, OutNormals, OutTangents, OutUVs);
+#else
+	EmitGridRowScalar(Params, Heights, HeightsBelow, HeightsAbove, Count, OutPositions, OutNormals, OutTangents, OutUVs);
+#endif
+}
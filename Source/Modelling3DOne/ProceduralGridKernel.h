@@ -0,0 +1,18 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralGeometryKernel.h"
+
+/**
+ * Emits the vertices of a height-displaced grid row straight into the builder arrays.
+ * The SSE path computes the central-difference normals and tangents of 4 corners per iteration and is bit-identical
+ * to ProceduralGeometry::EmitGridRow, which is also the fallback off x86.
+ */
+struct MODELLING3DONE_API FProceduralGridKernel
+{
+	// Writes Count corners of the row; see ProceduralGeometry::EmitGridRow for the heights read around them
+	static void EmitGridRow(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove, int32 Count,
+		FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs);
+};
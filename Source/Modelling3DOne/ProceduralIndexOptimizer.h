@@ -0,0 +1,392 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Engine-free reordering of a finished triangle list for the GPU, in three passes:
+ *   - post-transform vertex cache: Forsyth's linear-speed greedy ordering
+ *   - overdraw: the cache-ordered list is cut into clusters that each start from a cold cache and keep the
+ *     overall ACMR, and the clusters are sorted outermost-facing first (Sander et al., as in Tipsify)
+ *   - vertex fetch: vertices are renumbered in the order the new index list first uses them
+ * Shared by FProceduralMeshBuilder::OptimizeIndexOrder and Tools/GeometryBench, like ProceduralGeometryKernel.h.
+ * Triangles face the way the generators wind them: Cross(C - A, B - A) points out of the front face.
+ */
+namespace ProceduralGeometry
+{
+	// FIFO cache the ACMR is measured against; about the post-transform cache of current desktop GPUs
+	constexpr int32_t VertexCacheSize = 16;
+
+	// LRU cache size Forsyth's scoring models; larger than the real cache so the ordering degrades gracefully on any GPU
+	constexpr int32_t ForsythCacheSize = 32;
+
+	// A cluster ends once its own ACMR, from a cold cache, is within this factor of the whole list's
+	constexpr double OverdrawClusterThreshold = 1.05;
+
+	struct FIndexOrderStats
+	{
+		// Average cache miss ratio, transformed vertices per triangle: 3 at worst, approaching 0.5 on a large regular grid
+		double ACMRBefore = 0.0;
+		double ACMRAfter = 0.0;
+	};
+
+	// ACMR of an index list through a FIFO cache of CacheSize entries
+	inline double ComputeACMR(const int32_t* Indices, int32_t NumIndices, int32_t NumVertices, int32_t CacheSize = VertexCacheSize)
+	{
+		const int32_t NumTriangles = NumIndices / 3;
+		if (NumTriangles == 0)
+		{
+			return 0.0;
+		}
+
+		// Miss count at which each vertex last entered the cache; it is still cached until CacheSize more misses push it out
+		std::vector<int64_t> EnteredAt(NumVertices, -int64_t(CacheSize) - 1);
+		int64_t NumMisses = 0;
+		for (int32_t Index = 0; Index < NumIndices; Index++)
+		{
+			int64_t& Entered = EnteredAt[Indices[Index]];
+			if (NumMisses - Entered > CacheSize)
+			{
+				Entered = NumMisses++;
+			}
+		}
+		return double(NumMisses) / double(NumTriangles);
+	}
+
+	namespace IndexOrderDetail
+	{
+		// Forsyth's vertex score, tabulated by cache position and remaining triangle count
+		struct FForsythScores
+		{
+			static constexpr int32_t MaxTabulatedValence = 32;
+
+			float CachePosition[ForsythCacheSize];
+			float Valence[MaxTabulatedValence];
+
+			FForsythScores()
+			{
+				for (int32_t Position = 0; Position < ForsythCacheSize; Position++)
+				{
+					// The last triangle's three vertices share one fixed score, so the next pick does not simply follow a strip
+					CachePosition[Position] = Position < 3
+						? 0.75f
+						: std::pow(1.0f - float(Position - 3) / float(ForsythCacheSize - 3), 1.5f);
+				}
+				for (int32_t NumTriangles = 0; NumTriangles < MaxTabulatedValence; NumTriangles++)
+				{
+					Valence[NumTriangles] = NumTriangles > 0 ? 2.0f / std::sqrt(float(NumTriangles)) : 0.0f;
+				}
+			}
+
+			float Get(int32_t Position, int32_t NumActiveTriangles) const
+			{
+				// A vertex with nothing left to draw must not attract anything
+				if (NumActiveTriangles == 0)
+				{
+					return -1.0f;
+				}
+				const float ValenceScore = NumActiveTriangles < MaxTabulatedValence
+					? Valence[NumActiveTriangles]
+					: 2.0f / std::sqrt(float(NumActiveTriangles));
+				return (Position >= 0 ? CachePosition[Position] : 0.0f) + ValenceScore;
+			}
+		};
+
+		inline const FForsythScores& GetForsythScores()
+		{
+			static const FForsythScores Scores;
+			return Scores;
+		}
+
+		template <typename PositionType>
+		void AccumulateFace(const PositionType& A, const PositionType& B, const PositionType& C, double* Centroid, double* Normal)
+		{
+			const double AB[3] = { B.X - A.X, B.Y - A.Y, B.Z - A.Z };
+			const double AC[3] = { C.X - A.X, C.Y - A.Y, C.Z - A.Z };
+
+			// Cross(AC, AB): outward for the generators' winding, with twice the face area as its length
+			const double Cross[3] = { AC[1] * AB[2] - AC[2] * AB[1], AC[2] * AB[0] - AC[0] * AB[2], AC[0] * AB[1] - AC[1] * AB[0] };
+			const double Area = std::sqrt(Cross[0] * Cross[0] + Cross[1] * Cross[1] + Cross[2] * Cross[2]);
+
+			Centroid[0] += Area * (A.X + B.X + C.X) / 3.0;
+			Centroid[1] += Area * (A.Y + B.Y + C.Y) / 3.0;
+			Centroid[2] += Area * (A.Z + B.Z + C.Z) / 3.0;
+			Centroid[3] += Area;
+			Normal[0] += Cross[0];
+			Normal[1] += Cross[1];
+			Normal[2] += Cross[2];
+		}
+	}
+
+	// Reorders the triangles of an index list for the post-transform vertex cache; the vertices stay where they are
+	inline void OptimizeVertexCache(int32_t* Indices, int32_t NumIndices, int32_t NumVertices)
+	{
+		const IndexOrderDetail::FForsythScores& Scores = IndexOrderDetail::GetForsythScores();
+		const int32_t NumTriangles = NumIndices / 3;
+		if (NumTriangles < 2)
+		{
+			return;
+		}
+
+		// Triangles still to draw around each vertex, packed: vertex V owns [FirstTriangle[V], FirstTriangle[V] + NumActive[V])
+		std::vector<int32_t> NumActive(NumVertices, 0);
+		for (int32_t Index = 0; Index < NumIndices; Index++)
+		{
+			NumActive[Indices[Index]]++;
+		}
+		std::vector<int32_t> FirstTriangle(NumVertices + 1, 0);
+		for (int32_t Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			FirstTriangle[Vertex + 1] = FirstTriangle[Vertex] + NumActive[Vertex];
+		}
+		std::vector<int32_t> VertexTriangles(NumIndices);
+		{
+			std::vector<int32_t> Cursor(FirstTriangle.begin(), FirstTriangle.end() - 1);
+			for (int32_t Index = 0; Index < NumIndices; Index++)
+			{
+				VertexTriangles[Cursor[Indices[Index]]++] = Index / 3;
+			}
+		}
+
+		std::vector<float> VertexScore(NumVertices);
+		for (int32_t Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			VertexScore[Vertex] = Scores.Get(-1, NumActive[Vertex]);
+		}
+
+		std::vector<uint8_t> bEmitted(NumTriangles, 0);
+		std::vector<int32_t> Output(NumIndices);
+		int32_t Cache[ForsythCacheSize + 3];
+		int32_t NewCache[ForsythCacheSize + 3];
+		int32_t CacheCount = 0;
+		int32_t ScanCursor = 0;
+		int32_t BestTriangle = -1;
+
+		for (int32_t EmittedCount = 0; EmittedCount < NumTriangles; EmittedCount++)
+		{
+			// Nothing around the cache is left (or this is the start): carry on from the first triangle not drawn yet
+			if (BestTriangle < 0)
+			{
+				while (bEmitted[ScanCursor])
+				{
+					ScanCursor++;
+				}
+				BestTriangle = ScanCursor;
+			}
+
+			const int32_t* Corners = Indices + BestTriangle * 3;
+			Output[EmittedCount * 3 + 0] = Corners[0];
+			Output[EmittedCount * 3 + 1] = Corners[1];
+			Output[EmittedCount * 3 + 2] = Corners[2];
+			bEmitted[BestTriangle] = 1;
+
+			// The triangle's vertices move to the front of the cache; everything else shifts back
+			int32_t NewCount = 0;
+			for (int32_t Corner = 0; Corner < 3; Corner++)
+			{
+				const int32_t Vertex = Corners[Corner];
+				int32_t* Triangles = VertexTriangles.data() + FirstTriangle[Vertex];
+				int32_t* Found = std::find(Triangles, Triangles + NumActive[Vertex], BestTriangle);
+				*Found = Triangles[--NumActive[Vertex]];
+
+				if (std::find(NewCache, NewCache + NewCount, Vertex) == NewCache + NewCount)
+				{
+					NewCache[NewCount++] = Vertex;
+				}
+			}
+			const int32_t NumFront = NewCount;
+			for (int32_t Slot = 0; Slot < CacheCount; Slot++)
+			{
+				if (std::find(NewCache, NewCache + NumFront, Cache[Slot]) == NewCache + NumFront)
+				{
+					NewCache[NewCount++] = Cache[Slot];
+				}
+			}
+
+			// Vertices pushed out of the cache drop to the score of an uncached vertex
+			CacheCount = 0;
+			for (int32_t Slot = 0; Slot < NewCount; Slot++)
+			{
+				const int32_t Vertex = NewCache[Slot];
+				const bool bCached = Slot < ForsythCacheSize;
+				VertexScore[Vertex] = Scores.Get(bCached ? Slot : -1, NumActive[Vertex]);
+				if (bCached)
+				{
+					Cache[CacheCount++] = Vertex;
+				}
+			}
+
+			// Only triangles around the cache changed score, so the next pick is among them
+			BestTriangle = -1;
+			float BestScore = -1.0f;
+			for (int32_t Slot = 0; Slot < CacheCount; Slot++)
+			{
+				const int32_t Vertex = Cache[Slot];
+				const int32_t* Triangles = VertexTriangles.data() + FirstTriangle[Vertex];
+				for (int32_t TriangleIdx = 0; TriangleIdx < NumActive[Vertex]; TriangleIdx++)
+				{
+					const int32_t* TriangleCorners = Indices + Triangles[TriangleIdx] * 3;
+					const float Score = VertexScore[TriangleCorners[0]] + VertexScore[TriangleCorners[1]] + VertexScore[TriangleCorners[2]];
+					if (Score > BestScore)
+					{
+						BestScore = Score;
+						BestTriangle = Triangles[TriangleIdx];
+					}
+				}
+			}
+		}
+
+		std::copy(Output.begin(), Output.end(), Indices);
+	}
+
+	// Sorts the cache-ordered triangles cluster by cluster so outward-facing parts far from the center draw first
+	template <typename PositionType>
+	void OptimizeOverdraw(int32_t* Indices, int32_t NumIndices, const PositionType* Positions, int32_t NumVertices,
+		double Threshold = OverdrawClusterThreshold)
+	{
+		const int32_t NumTriangles = NumIndices / 3;
+		if (NumTriangles < 2)
+		{
+			return;
+		}
+
+		// Cut wherever the cluster so far, replayed from a cold cache, is about as cache-friendly as the whole list
+		const double TargetACMR = ComputeACMR(Indices, NumIndices, NumVertices) * Threshold;
+		std::vector<int32_t> ClusterStarts;
+		{
+			std::vector<int64_t> EnteredAt(NumVertices, -int64_t(VertexCacheSize) - 1);
+			int64_t NumMisses = 0;
+			int64_t ClusterFirstMiss = 0;
+			int32_t ClusterStart = 0;
+			for (int32_t Triangle = 0; Triangle < NumTriangles; Triangle++)
+			{
+				if (Triangle == ClusterStart)
+				{
+					ClusterStarts.push_back(Triangle);
+					ClusterFirstMiss = NumMisses;
+				}
+				for (int32_t Corner = 0; Corner < 3; Corner++)
+				{
+					int64_t& Entered = EnteredAt[Indices[Triangle * 3 + Corner]];
+					if (NumMisses - Entered > VertexCacheSize || Entered < ClusterFirstMiss)
+					{
+						Entered = NumMisses++;
+					}
+				}
+				if (double(NumMisses - ClusterFirstMiss) <= TargetACMR * double(Triangle + 1 - ClusterStart))
+				{
+					ClusterStart = Triangle + 1;
+				}
+			}
+		}
+		const int32_t NumClusters = int32_t(ClusterStarts.size());
+		if (NumClusters < 2)
+		{
+			return;
+		}
+		ClusterStarts.push_back(NumTriangles);
+
+		// Area-weighted centroid (with the total area in [3]) and summed normal of each cluster, and of the whole mesh
+		std::vector<double> ClusterCentroids(NumClusters * 4, 0.0);
+		std::vector<double> ClusterNormals(NumClusters * 3, 0.0);
+		double MeshCentroid[4] = { 0.0, 0.0, 0.0, 0.0 };
+		for (int32_t Cluster = 0; Cluster < NumClusters; Cluster++)
+		{
+			for (int32_t Triangle = ClusterStarts[Cluster]; Triangle < ClusterStarts[Cluster + 1]; Triangle++)
+			{
+				const int32_t* Corners = Indices + Triangle * 3;
+				IndexOrderDetail::AccumulateFace(Positions[Corners[0]], Positions[Corners[1]], Positions[Corners[2]],
+					ClusterCentroids.data() + Cluster * 4, ClusterNormals.data() + Cluster * 3);
+			}
+			for (int32_t Axis = 0; Axis < 4; Axis++)
+			{
+				MeshCentroid[Axis] += ClusterCentroids[Cluster * 4 + Axis];
+			}
+		}
+		if (MeshCentroid[3] <= 0.0)
+		{
+			return;
+		}
+
+		std::vector<double> SortKeys(NumClusters, 0.0);
+		for (int32_t Cluster = 0; Cluster < NumClusters; Cluster++)
+		{
+			const double* Centroid = ClusterCentroids.data() + Cluster * 4;
+			const double* Normal = ClusterNormals.data() + Cluster * 3;
+			const double NormalLength = std::sqrt(Normal[0] * Normal[0] + Normal[1] * Normal[1] + Normal[2] * Normal[2]);
+			if (Centroid[3] > 0.0 && NormalLength > 0.0)
+			{
+				double Key = 0.0;
+				for (int32_t Axis = 0; Axis < 3; Axis++)
+				{
+					Key += (Centroid[Axis] / Centroid[3] - MeshCentroid[Axis] / MeshCentroid[3]) * Normal[Axis] / NormalLength;
+				}
+				SortKeys[Cluster] = Key;
+			}
+		}
+
+		std::vector<int32_t> ClusterOrder(NumClusters);
+		for (int32_t Cluster = 0; Cluster < NumClusters; Cluster++)
+		{
+			ClusterOrder[Cluster] = Cluster;
+		}
+		std::stable_sort(ClusterOrder.begin(), ClusterOrder.end(), [&SortKeys](int32_t A, int32_t B) { return SortKeys[A] > SortKeys[B]; });
+
+		std::vector<int32_t> Output;
+		Output.reserve(NumIndices);
+		for (int32_t Cluster : ClusterOrder)
+		{
+			Output.insert(Output.end(), Indices + ClusterStarts[Cluster] * 3, Indices + ClusterStarts[Cluster + 1] * 3);
+		}
+		std::copy(Output.begin(), Output.end(), Indices);
+	}
+
+	// Renumbers vertices in first-use order and rewrites the indices; OutRemap[OldIndex] is the new index. Unused vertices go last
+	inline void OptimizeVertexFetch(int32_t* Indices, int32_t NumIndices, int32_t NumVertices, int32_t* OutRemap)
+	{
+		std::fill(OutRemap, OutRemap + NumVertices, -1);
+		int32_t NextVertex = 0;
+		for (int32_t Index = 0; Index < NumIndices; Index++)
+		{
+			int32_t& NewIndex = OutRemap[Indices[Index]];
+			if (NewIndex < 0)
+			{
+				NewIndex = NextVertex++;
+			}
+			Indices[Index] = NewIndex;
+		}
+		for (int32_t Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			if (OutRemap[Vertex] < 0)
+			{
+				OutRemap[Vertex] = NextVertex++;
+			}
+		}
+	}
+
+	// All three passes in order. The caller moves every vertex attribute to OutRemap[OldIndex]
+	template <typename PositionType>
+	FIndexOrderStats OptimizeIndexOrder(int32_t* Indices, int32_t NumIndices, const PositionType* Positions, int32_t NumVertices, int32_t* OutRemap)
+	{
+		FIndexOrderStats Stats;
+		Stats.ACMRBefore = ComputeACMR(Indices, NumIndices, NumVertices);
+
+		// Some generation orders already beat the greedy one (small fans, short strips); those keep their triangle order
+		const std::vector<int32_t> GenerationOrder(Indices, Indices + NumIndices);
+		OptimizeVertexCache(Indices, NumIndices, NumVertices);
+		OptimizeOverdraw(Indices, NumIndices, Positions, NumVertices);
+		if (ComputeACMR(Indices, NumIndices, NumVertices) >= Stats.ACMRBefore)
+		{
+			std::copy(GenerationOrder.begin(), GenerationOrder.end(), Indices);
+		}
+
+		// Renumbering changes no cache hit, so the ACMR measured above stands
+		OptimizeVertexFetch(Indices, NumIndices, NumVertices, OutRemap);
+		Stats.ACMRAfter = ComputeACMR(Indices, NumIndices, NumVertices);
+		return Stats;
+	}
+}
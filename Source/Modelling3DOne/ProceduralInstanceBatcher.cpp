@@ -0,0 +1,228 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralInstanceBatcher.h"
+
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "EngineUtils.h"
+#include "MeshDescription.h"
+#include "Modelling3DOne.h"
+#include "ProceduralShapeActor.h"
+
+namespace
+{
+	// Actors sharing a key render identically and can become instances of one mesh
+	struct FShapeBatchKey
+	{
+		TArray<FProceduralMeshKey> LODKeys;
+		UMaterialInterface* Material = nullptr;
+		float LODScreenSizeStep = 0.0f;
+
+		bool operator==(const FShapeBatchKey& Other) const
+		{
+			return Material == Other.Material && LODScreenSizeStep == Other.LODScreenSizeStep && LODKeys == Other.LODKeys;
+		}
+
+		friend uint32 GetTypeHash(const FShapeBatchKey& Key)
+		{
+			uint32 Hash = HashCombineFast(GetTypeHash(Key.Material), GetTypeHash(Key.LODScreenSizeStep));
+			for (const FProceduralMeshKey& LODKey : Key.LODKeys)
+			{
+				Hash = HashCombineFast(Hash, GetTypeHash(LODKey));
+			}
+			return Hash;
+		}
+	};
+
+	// Bakes the actor's LOD chain into a transient static mesh; screen sizes follow the actor's own LOD step
+	UStaticMesh* CreateBatchMesh(UObject* Outer, const AProceduralShapeActor& Source, int32 NumLODs, bool bBuildSimpleCollision)
+	{
+		TArray<FMeshDescription> MeshDescriptions;
+		MeshDescriptions.SetNum(NumLODs);
+		TArray<const FMeshDescription*> MeshDescriptionPtrs;
+		for (int32 LODIndex = 0; LODIndex < NumLODs; LODIndex++)
+		{
+			Source.FindOrBuildLODMesh(LODIndex)->BuildMeshDescription(MeshDescriptions[LODIndex]);
+			MeshDescriptionPtrs.Add(&MeshDescriptions[LODIndex]);
+		}
+
+		UStaticMesh* StaticMesh = NewObject<UStaticMesh>(Outer, NAME_None, RF_Transient);
+		StaticMesh->GetStaticMaterials().Add(FStaticMaterial(Source.GetShapeMaterial()));
+
+		UStaticMesh::FBuildMeshDescriptionsParams BuildParams;
+		BuildParams.bBuildSimpleCollision = bBuildSimpleCollision;
+		BuildParams.bFastBuild = true;
+		StaticMesh->BuildFromMeshDescriptions(MeshDescriptionPtrs, BuildParams);
+
+		// Same screen size measure the shape actors use for their own sections
+		if (FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData())
+		{
+			float ScreenSize = 1.0f;
+			for (int32 LODIndex = 0; LODIndex < NumLODs && LODIndex < MAX_STATIC_MESH_LODS; LODIndex++)
+			{
+				RenderData->ScreenSize[LODIndex].Default = ScreenSize;
+				ScreenSize *= Source.LODScreenSizeStep;
+			}
+		}
+
+		return StaticMesh;
+	}
+}
+
+// Sets default values
+AProceduralInstanceBatcher::AProceduralInstanceBatcher()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+// Called when the game starts or when spawned
+void AProceduralInstanceBatcher::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (bBatchOnBeginPlay)
+	{
+		BatchShapes();
+	}
+}
+
+void AProceduralInstanceBatcher::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Only a batcher removed mid-game has actors left to give back; on world teardown they go away with it
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		UnbatchShapes();
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AProceduralInstanceBatcher::BatchShapes()
+{
+	UnbatchShapes();
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// Group every eligible actor by what it renders
+	TMap<FShapeBatchKey, TArray<AProceduralShapeActor*>> Groups;
+	for (TActorIterator<AProceduralShapeActor> It(World); It; ++It)
+	{
+		AProceduralShapeActor* ShapeActor = *It;
+		// An instance draws the whole-shape LOD chain, which would replace a tiled shape's tiles
+		if (!ShapeActor->bAllowInstanceBatching || ShapeActor->IsHidden() || ShapeActor->IsTiled())
+		{
+			continue;
+		}
+
+		FShapeBatchKey Key;
+		Key.LODKeys = ShapeActor->GetLODKeys();
+		Key.Material = ShapeActor->GetShapeMaterial();
+		Key.LODScreenSizeStep = Key.LODKeys.Num() > 1 ? ShapeActor->LODScreenSizeStep : 0.0f;
+		Groups.FindOrAdd(MoveTemp(Key)).Add(ShapeActor);
+	}
+
+	const bool bDestroyActors = bDestroyBatchedActors && World->IsGameWorld();
+	for (TPair<FShapeBatchKey, TArray<AProceduralShapeActor*>>& Group : Groups)
+	{
+		TArray<AProceduralShapeActor*>& ShapeActors = Group.Value;
+		if (ShapeActors.Num() < FMath::Max(1, MinInstancesPerBatch))
+		{
+			continue;
+		}
+
+		// Destroyed actors take their collision with them, so only then does the instanced mesh need its own
+		UStaticMesh* StaticMesh = CreateBatchMesh(this, *ShapeActors[0], Group.Key.LODKeys.Num(), bDestroyActors);
+
+		UHierarchicalInstancedStaticMeshComponent* BatchComponent = NewObject<UHierarchicalInstancedStaticMeshComponent>(this, NAME_None, RF_Transient);
+		BatchComponent->SetupAttachment(RootComponent);
+		BatchComponent->SetStaticMesh(StaticMesh);
+		BatchComponent->SetCollisionEnabled(bDestroyActors ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision);
+		BatchComponent->RegisterComponent();
+
+		TArray<FTransform> InstanceTransforms;
+		InstanceTransforms.Reserve(ShapeActors.Num());
+		for (AProceduralShapeActor* ShapeActor : ShapeActors)
+		{
+			InstanceTransforms.Add(ShapeActor->GetActorTransform());
+		}
+		BatchComponent->AddInstances(InstanceTransforms, /*bShouldReturnIndices=*/false, /*bWorldSpace=*/true);
+		BatchComponents.Add(BatchComponent);
+
+		for (AProceduralShapeActor* ShapeActor : ShapeActors)
+		{
+			if (bDestroyActors)
+			{
+				ShapeActor->Destroy();
+			}
+			else
+			{
+				HideBatchedActor(ShapeActor);
+			}
+		}
+		NumBatchedActors += ShapeActors.Num();
+	}
+
+	UE_LOG(LogProceduralMesh, Log, TEXT("%s: batched %d procedural actors into %d instanced meshes"),
+		*GetName(), NumBatchedActors, BatchComponents.Num());
+}
+
+void AProceduralInstanceBatcher::UnbatchShapes()
+{
+	for (UHierarchicalInstancedStaticMeshComponent* BatchComponent : BatchComponents)
+	{
+		if (IsValid(BatchComponent))
+		{
+			BatchComponent->DestroyComponent();
+		}
+	}
+	BatchComponents.Reset();
+
+	for (AProceduralShapeActor* ShapeActor : HiddenActors)
+	{
+		if (!IsValid(ShapeActor))
+		{
+			continue;
+		}
+
+#if WITH_EDITOR
+		if (!ShapeActor->GetWorld()->IsGameWorld())
+		{
+			ShapeActor->SetIsTemporarilyHiddenInEditor(false);
+		}
+		else
+#endif
+		{
+			ShapeActor->SetActorHiddenInGame(false);
+		}
+
+		// Restores LOD ticking and section visibility without rebuilding
+		ShapeActor->RegenerateMesh();
+	}
+	HiddenActors.Reset();
+	NumBatchedActors = 0;
+}
+
+void AProceduralInstanceBatcher::HideBatchedActor(AProceduralShapeActor* ShapeActor)
+{
+	// Editor hiding is transient, so batching in the editor never changes what gets saved
+#if WITH_EDITOR
+	if (!ShapeActor->GetWorld()->IsGameWorld())
+	{
+		ShapeActor->SetIsTemporarilyHiddenInEditor(true);
+	}
+	else
+#endif
+	{
+		ShapeActor->SetActorHiddenInGame(true);
+	}
+
+	// Hidden actors keep their collision but have no LOD to pick
+	ShapeActor->SetActorTickEnabled(false);
+	HiddenActors.Add(ShapeActor);
+}
@@ -0,0 +1,73 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ProceduralInstanceBatcher.generated.h"
+
+class AProceduralShapeActor;
+class UHierarchicalInstancedStaticMeshComponent;
+
+/**
+ * Level-wide batching pass for procedural primitives.
+ * Groups every AProceduralShapeActor in the world by geometry (all LOD keys), material and LOD step,
+ * bakes each group once into a transient UStaticMesh and draws the whole group with a single
+ * hierarchical instanced mesh component, one instance per actor transform.
+ */
+UCLASS()
+class MODELLING3DONE_API AProceduralInstanceBatcher : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AProceduralInstanceBatcher();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Run the batching pass as soon as play begins
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Batching")
+	bool bBatchOnBeginPlay = true;
+
+	// Groups with fewer actors than this are left alone
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Batching", meta = (ClampMin = "1"))
+	int32 MinInstancesPerBatch = 2;
+
+	// In a game world, destroy the batched actors instead of hiding them. Their collision then comes from the
+	// instanced mesh's simple box collision instead of the original triangle mesh, and the pass cannot be undone
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Batching")
+	bool bDestroyBatchedActors = false;
+
+	// Groups identical shape actors into instanced meshes. Runs the previous batch's UnbatchShapes first
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Batching")
+	void BatchShapes();
+
+	// Removes the instanced meshes and shows the batched actors again
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Batching")
+	void UnbatchShapes();
+
+	UFUNCTION(BlueprintPure, Category = "Batching")
+	int32 GetNumBatches() const { return BatchComponents.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "Batching")
+	int32 GetNumBatchedActors() const { return NumBatchedActors; }
+
+private:
+	// Hides (or destroys) an actor whose geometry now lives in an instanced mesh
+	void HideBatchedActor(AProceduralShapeActor* ShapeActor);
+
+	// One instanced component per group, owned by this actor
+	UPROPERTY(Transient)
+	TArray<UHierarchicalInstancedStaticMeshComponent*> BatchComponents;
+
+	// Actors hidden by the last pass, so UnbatchShapes can show them again
+	UPROPERTY(Transient)
+	TArray<AProceduralShapeActor*> HiddenActors;
+
+	int32 NumBatchedActors = 0;
+};
@@ -0,0 +1,479 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralMeshBuilder.h"
+
+#include "MeshDescription.h"
+#include "ProceduralGeometryStats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "StaticMeshAttributes.h"
+
+namespace
+{
+	// Moves every element to its new index: Array[OldIndex] ends up at Remap[OldIndex]
+	template<typename ElementType>
+	void ApplyVertexRemap(TArray<ElementType>& Array, const TArray<int32>& Remap)
+	{
+		if (Array.Num() != Remap.Num())
+		{
+			return;
+		}
+		TArray<ElementType> Remapped;
+		Remapped.SetNumUninitialized(Array.Num());
+		for (int32 VertexIdx = 0; VertexIdx < Array.Num(); VertexIdx++)
+		{
+			Remapped[Remap[VertexIdx]] = Array[VertexIdx];
+		}
+		Array = MoveTemp(Remapped);
+	}
+
+	// Unit vector folded onto an octahedron and flattened to two 16-bit snorms; well under a thousandth of a degree off
+	struct FOctahedralVector
+	{
+		int16 X = 0;
+		int16 Y = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FOctahedralVector& Vector)
+		{
+			return Ar << Vector.X << Vector.Y;
+		}
+	};
+
+	FORCEINLINE float SignNotZero(float Value)
+	{
+		return Value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	FOctahedralVector EncodeOctahedral(const FVector3f& Vector)
+	{
+		FOctahedralVector Packed;
+		const float Length = FMath::Abs(Vector.X) + FMath::Abs(Vector.Y) + FMath::Abs(Vector.Z);
+		if (Length <= 0.0f)
+		{
+			return Packed;
+		}
+
+		// The lower half folds over the upper one across the diagonals
+		float X = Vector.X / Length;
+		float Y = Vector.Y / Length;
+		if (Vector.Z < 0.0f)
+		{
+			const float FoldedX = (1.0f - FMath::Abs(Y)) * SignNotZero(X);
+			Y = (1.0f - FMath::Abs(X)) * SignNotZero(Y);
+			X = FoldedX;
+		}
+		Packed.X = int16(FMath::RoundToInt(FMath::Clamp(X, -1.0f, 1.0f) * float(MAX_int16)));
+		Packed.Y = int16(FMath::RoundToInt(FMath::Clamp(Y, -1.0f, 1.0f) * float(MAX_int16)));
+		return Packed;
+	}
+
+	FVector3f DecodeOctahedral(const FOctahedralVector& Packed)
+	{
+		float X = float(Packed.X) / float(MAX_int16);
+		float Y = float(Packed.Y) / float(MAX_int16);
+		const float Z = 1.0f - FMath::Abs(X) - FMath::Abs(Y);
+		const float Fold = FMath::Max(-Z, 0.0f);
+		X -= Fold * SignNotZero(X);
+		Y -= Fold * SignNotZero(Y);
+		return FVector3f(X, Y, Z).GetSafeNormal();
+	}
+}
+
+
+FProceduralMeshBuilder::FProceduralMeshBuilder()
+{
+	INC_DWORD_STAT(STAT_ProceduralLiveMeshes);
+}
+
+FProceduralMeshBuilder::~FProceduralMeshBuilder()
+{
+	DEC_MEMORY_STAT_BY(STAT_ProceduralVertexMemory, TrackedVertexBytes);
+	DEC_MEMORY_STAT_BY(STAT_ProceduralIndexMemory, TrackedIndexBytes);
+	DEC_DWORD_STAT(STAT_ProceduralLiveMeshes);
+}
+
+void FProceduralMeshBuilder::Reset(const FProceduralMeshCapacity& InCapacity)
+{
+	Capacity = InCapacity;
+	NumVertices = 0;
+	NumIndices = 0;
+
+	// Size everything once; the generators then write every element exactly once
+	Vertices.SetNumUninitialized(Capacity.NumVertices);
+	Normals.SetNumUninitialized(Capacity.NumVertices);
+	Tangents.SetNumUninitialized(Capacity.NumVertices);
+	UVs.SetNumUninitialized(Capacity.NumVertices);
+	Triangles.SetNumUninitialized(Capacity.NumIndices);
+	VertexColors.Reset();
+	UpdateMemoryStats();
+}
+
+void FProceduralMeshBuilder::Finalize()
+{
+	// A mismatch means a generator's capacity formula is out of sync with its loops
+	if (!ensureMsgf(IsComplete(), TEXT("Procedural mesh wrote %d/%d vertices and %d/%d indices"),
+		NumVertices, Capacity.NumVertices, NumIndices, Capacity.NumIndices))
+	{
+		Vertices.SetNum(NumVertices, EAllowShrinking::No);
+		Normals.SetNum(NumVertices, EAllowShrinking::No);
+		Tangents.SetNum(NumVertices, EAllowShrinking::No);
+		UVs.SetNum(NumVertices, EAllowShrinking::No);
+		Triangles.SetNum(NumIndices, EAllowShrinking::No);
+		Capacity = FProceduralMeshCapacity(NumVertices, NumIndices);
+	}
+}
+
+bool FProceduralMeshBuilder::CanUseHalfPrecisionUVs() const
+{
+	// Half precision steps by 1/2048 below 1, so UVs in [0, 1] pass and tiled UVs (a plane's quad counts) do not
+	constexpr float Tolerance = 1.0f / 4096.0f;
+	for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+	{
+		const FVector2f& UV = UVs[VertexIdx];
+		const FVector2f HalfUV = FVector2DHalf(UV);
+		if (FMath::Abs(HalfUV.X - UV.X) > Tolerance || FMath::Abs(HalfUV.Y - UV.Y) > Tolerance)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+ProceduralGeometry::FIndexOrderStats FProceduralMeshBuilder::OptimizeIndexOrder()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FProceduralMeshBuilder::OptimizeIndexOrder);
+	checkSlow(IsComplete());
+
+	TArray<int32> VertexRemap;
+	VertexRemap.SetNumUninitialized(NumVertices);
+	const ProceduralGeometry::FIndexOrderStats Stats = ProceduralGeometry::OptimizeIndexOrder(
+		Triangles.GetData(), NumIndices, Vertices.GetData(), NumVertices, VertexRemap.GetData());
+
+	ApplyVertexRemap(Vertices, VertexRemap);
+	ApplyVertexRemap(Normals, VertexRemap);
+	ApplyVertexRemap(Tangents, VertexRemap);
+	ApplyVertexRemap(UVs, VertexRemap);
+	ApplyVertexRemap(VertexColors, VertexRemap);
+	UpdateMemoryStats();
+	return Stats;
+}
+
+SIZE_T FProceduralMeshBuilder::GetAllocatedSize() const
+{
+	return Vertices.GetAllocatedSize() + Triangles.GetAllocatedSize() + Normals.GetAllocatedSize()
+		+ UVs.GetAllocatedSize() + VertexColors.GetAllocatedSize() + Tangents.GetAllocatedSize();
+}
+
+void FProceduralMeshBuilder::UpdateMemoryStats()
+{
+#if STATS
+	const int64 VertexBytes = Vertices.GetAllocatedSize() + Normals.GetAllocatedSize() + UVs.GetAllocatedSize()
+		+ VertexColors.GetAllocatedSize() + Tangents.GetAllocatedSize();
+	const int64 IndexBytes = Triangles.GetAllocatedSize();
+
+	// Spare buffers are refilled in place, so most updates change nothing
+	if (VertexBytes != TrackedVertexBytes)
+	{
+		INC_MEMORY_STAT_BY(STAT_ProceduralVertexMemory, VertexBytes - TrackedVertexBytes);
+		TrackedVertexBytes = VertexBytes;
+	}
+	if (IndexBytes != TrackedIndexBytes)
+	{
+		INC_MEMORY_STAT_BY(STAT_ProceduralIndexMemory, IndexBytes - TrackedIndexBytes);
+		TrackedIndexBytes = IndexBytes;
+	}
+#endif
+}
+
+void FProceduralMeshBuilder::FillProcMeshSection(FProcMeshSection& Section, bool bWithPositions) const
+{
+	checkSlow(Section.ProcVertexBuffer.Num() == NumVertices);
+	const bool bWithColors = VertexColors.Num() == NumVertices;
+	if (bWithPositions)
+	{
+		Section.SectionLocalBox.Init();
+	}
+
+	// The component keeps double precision vertices, so this is the one place the float arrays are widened
+	FProcMeshVertex* Dest = Section.ProcVertexBuffer.GetData();
+	for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+	{
+		FProcMeshVertex& Vertex = Dest[VertexIdx];
+		if (bWithPositions)
+		{
+			Vertex.Position = FVector(Vertices[VertexIdx]);
+			Section.SectionLocalBox += Vertex.Position;
+		}
+		Vertex.Normal = FVector(Normals[VertexIdx]);
+		const FVector4f& Tangent = Tangents[VertexIdx];
+		Vertex.Tangent = FProcMeshTangent(FVector(Tangent.X, Tangent.Y, Tangent.Z), Tangent.W < 0.0f);
+		Vertex.Color = bWithColors ? VertexColors[VertexIdx] : FColor::White;
+		Vertex.UV0 = FVector2D(UVs[VertexIdx]);
+		Vertex.UV1 = FVector2D::ZeroVector;
+		Vertex.UV2 = FVector2D::ZeroVector;
+		Vertex.UV3 = FVector2D::ZeroVector;
+	}
+}
+
+void FProceduralMeshBuilder::CreateMeshSection(UProceduralMeshComponent* Mesh, int32 SectionIndex, bool bCreateCollision, bool bRefreshComponent) const
+{
+	checkSlow(IsComplete());
+
+	// Filled where the component keeps it: UProceduralMeshComponent::CreateMeshSection would need FVector copies of every array first
+	if (!Mesh->GetProcMeshSection(SectionIndex))
+	{
+		Mesh->SetProcMeshSection(SectionIndex, FProcMeshSection());
+	}
+	FProcMeshSection& Section = *Mesh->GetProcMeshSection(SectionIndex);
+	Section.ProcVertexBuffer.SetNumUninitialized(NumVertices, EAllowShrinking::No);
+	FillProcMeshSection(Section, true);
+	Section.ProcIndexBuffer.SetNumUninitialized(NumIndices, EAllowShrinking::No);
+	for (int32 Index = 0; Index < NumIndices; Index++)
+	{
+		Section.ProcIndexBuffer[Index] = uint32(Triangles[Index]);
+	}
+	Section.bEnableCollision = bCreateCollision;
+	Section.bSectionVisible = true;
+
+	// Handing the section back to itself copies nothing (array assignment skips self-assignment); it refreshes the
+	// component's bounds, collision and render state the way CreateMeshSection does
+	if (bRefreshComponent)
+	{
+		Mesh->SetProcMeshSection(SectionIndex, Section);
+	}
+}
+
+bool FProceduralMeshBuilder::HasSameTopology(const FProceduralMeshBuilder& Other) const
+{
+	if (NumVertices != Other.NumVertices || NumIndices != Other.NumIndices)
+	{
+		return false;
+	}
+	return this == &Other || FMemory::Memcmp(Triangles.GetData(), Other.Triangles.GetData(), NumIndices * sizeof(int32)) == 0;
+}
+
+void FProceduralMeshBuilder::UpdateMeshSection(UProceduralMeshComponent* Mesh, int32 SectionIndex, bool bUpdateCollision) const
+{
+	checkSlow(IsComplete());
+	FProcMeshSection* Section = Mesh->GetProcMeshSection(SectionIndex);
+	check(Section && Section->ProcVertexBuffer.Num() == NumVertices);
+
+	// The component recooks collision only when it is handed positions, so a section with collision still passes them as
+	// FVectors. Everything else is written in place, and the empty arrays make UpdateMeshSection just send the refilled
+	// vertex buffer to the render thread and refresh the bounds
+	TArray<FVector> CollisionPositions;
+	const bool bWithCollision = Section->bEnableCollision && bUpdateCollision;
+	if (bWithCollision)
+	{
+		CollisionPositions.SetNumUninitialized(NumVertices);
+		for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+		{
+			CollisionPositions[VertexIdx] = FVector(Vertices[VertexIdx]);
+		}
+	}
+	FillProcMeshSection(*Section, !bWithCollision);
+	Mesh->UpdateMeshSection(SectionIndex, CollisionPositions, TArray<FVector>(), TArray<FVector2D>(), TArray<FColor>(), TArray<FProcMeshTangent>());
+}
+
+void FProceduralMeshBuilder::Serialize(FArchive& Ar, EProceduralMeshRecordLayout Layout)
+{
+	check(Ar.IsLoading() || Layout == EProceduralMeshRecordLayout::Latest);
+
+	int32 SavedNumVertices = NumVertices;
+	int32 SavedNumIndices = NumIndices;
+	Ar << SavedNumVertices << SavedNumIndices;
+	if (Ar.IsLoading())
+	{
+		if (SavedNumVertices < 0 || SavedNumIndices < 0 || SavedNumIndices % 3 != 0)
+		{
+			Ar.SetError();
+			return;
+		}
+		Reset(FProceduralMeshCapacity(SavedNumVertices, SavedNumIndices));
+		NumVertices = SavedNumVertices;
+		NumIndices = SavedNumIndices;
+	}
+
+	// Positions go as they are; the older layouts are the builder's own arrays throughout
+	Vertices.BulkSerialize(Ar);
+	if (Layout == EProceduralMeshRecordLayout::PackedVertices)
+	{
+		SerializePackedAttributes(Ar);
+	}
+	else
+	{
+		Normals.BulkSerialize(Ar);
+		if (Layout != EProceduralMeshRecordLayout::NoTangents)
+		{
+			Tangents.BulkSerialize(Ar);
+		}
+		UVs.BulkSerialize(Ar);
+	}
+	if (Ar.IsLoading() && (Vertices.Num() != NumVertices || Normals.Num() != NumVertices || Tangents.Num() != NumVertices || UVs.Num() != NumVertices))
+	{
+		Ar.SetError();
+	}
+
+	// The vertex count decides the index width on both sides, so it needs no flag of its own
+	if (CanUse16BitIndices())
+	{
+		TArray<uint16> CompactIndices;
+		if (Ar.IsSaving())
+		{
+			CompactIndices.SetNumUninitialized(NumIndices);
+			for (int32 Index = 0; Index < NumIndices; Index++)
+			{
+				CompactIndices[Index] = static_cast<uint16>(Triangles[Index]);
+			}
+		}
+		CompactIndices.BulkSerialize(Ar);
+
+		if (Ar.IsLoading() && CompactIndices.Num() == NumIndices)
+		{
+			for (int32 Index = 0; Index < NumIndices; Index++)
+			{
+				Triangles[Index] = CompactIndices[Index];
+			}
+		}
+		else if (Ar.IsLoading())
+		{
+			Ar.SetError();
+		}
+	}
+	else
+	{
+		Triangles.BulkSerialize(Ar);
+		if (Ar.IsLoading() && Triangles.Num() != NumIndices)
+		{
+			Ar.SetError();
+		}
+	}
+
+	// Stale or corrupt data must not reach the renderer; the caller regenerates instead
+	if (Ar.IsLoading())
+	{
+		for (int32 Index = 0; Index < NumIndices && !Ar.IsError(); Index++)
+		{
+			if (Triangles[Index] < 0 || Triangles[Index] >= NumVertices)
+			{
+				Ar.SetError();
+			}
+		}
+		if (Ar.IsError())
+		{
+			Reset(FProceduralMeshCapacity());
+		}
+	}
+}
+
+void FProceduralMeshBuilder::SerializePackedAttributes(FArchive& Ar)
+{
+	TArray<FOctahedralVector> PackedNormals;
+	TArray<FOctahedralVector> PackedTangents;
+	TArray<uint8> FlippedBinormals;
+	bool bHalfUVs = false;
+	if (Ar.IsSaving())
+	{
+		PackedNormals.SetNumUninitialized(NumVertices);
+		PackedTangents.SetNumUninitialized(NumVertices);
+		FlippedBinormals.SetNumUninitialized(NumVertices);
+		for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+		{
+			const FVector4f& Tangent = Tangents[VertexIdx];
+			PackedNormals[VertexIdx] = EncodeOctahedral(Normals[VertexIdx]);
+			PackedTangents[VertexIdx] = EncodeOctahedral(FVector3f(Tangent.X, Tangent.Y, Tangent.Z));
+			FlippedBinormals[VertexIdx] = Tangent.W < 0.0f ? 1 : 0;
+		}
+		bHalfUVs = CanUseHalfPrecisionUVs();
+	}
+	PackedNormals.BulkSerialize(Ar);
+	PackedTangents.BulkSerialize(Ar);
+	FlippedBinormals.BulkSerialize(Ar);
+
+	Ar << bHalfUVs;
+	if (bHalfUVs)
+	{
+		TArray<FVector2DHalf> HalfUVs;
+		if (Ar.IsSaving())
+		{
+			HalfUVs.SetNumUninitialized(NumVertices);
+			for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+			{
+				HalfUVs[VertexIdx] = FVector2DHalf(UVs[VertexIdx]);
+			}
+		}
+		HalfUVs.BulkSerialize(Ar);
+
+		if (Ar.IsLoading() && HalfUVs.Num() == NumVertices)
+		{
+			for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+			{
+				UVs[VertexIdx] = HalfUVs[VertexIdx];
+			}
+		}
+		else if (Ar.IsLoading())
+		{
+			Ar.SetError();
+		}
+	}
+	else
+	{
+		UVs.BulkSerialize(Ar);
+	}
+
+	if (Ar.IsLoading())
+	{
+		if (PackedNormals.Num() != NumVertices || PackedTangents.Num() != NumVertices || FlippedBinormals.Num() != NumVertices)
+		{
+			Ar.SetError();
+			return;
+		}
+		for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+		{
+			Normals[VertexIdx] = DecodeOctahedral(PackedNormals[VertexIdx]);
+			Tangents[VertexIdx] = FVector4f(DecodeOctahedral(PackedTangents[VertexIdx]), FlippedBinormals[VertexIdx] ? -1.0f : 1.0f);
+		}
+	}
+}
+
+void FProceduralMeshBuilder::BuildMeshDescription(FMeshDescription& OutMeshDescription) const
+{
+	checkSlow(IsComplete());
+
+	FStaticMeshAttributes Attributes(OutMeshDescription);
+	Attributes.Register();
+
+	TVertexAttributesRef<FVector3f> Positions = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesRef<FVector3f> InstanceNormals = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector3f> InstanceTangents = Attributes.GetVertexInstanceTangents();
+	TVertexInstanceAttributesRef<float> InstanceBinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+	TVertexInstanceAttributesRef<FVector2f> InstanceUVs = Attributes.GetVertexInstanceUVs();
+
+	OutMeshDescription.ReserveNewVertices(NumVertices);
+	OutMeshDescription.ReserveNewVertexInstances(NumVertices);
+	OutMeshDescription.ReserveNewTriangles(NumIndices / 3);
+	const FPolygonGroupID PolygonGroup = OutMeshDescription.CreatePolygonGroup();
+
+	// Our vertices already carry their normal, tangent and UV, so each one maps to exactly one vertex instance
+	TArray<FVertexInstanceID> VertexInstances;
+	VertexInstances.SetNumUninitialized(NumVertices);
+	for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+	{
+		const FVertexID Vertex = OutMeshDescription.CreateVertex();
+		Positions[Vertex] = Vertices[VertexIdx];
+
+		const FVertexInstanceID VertexInstance = OutMeshDescription.CreateVertexInstance(Vertex);
+		const FVector4f& Tangent = Tangents[VertexIdx];
+		InstanceNormals[VertexInstance] = Normals[VertexIdx];
+		InstanceTangents[VertexInstance] = FVector3f(Tangent.X, Tangent.Y, Tangent.Z);
+		InstanceBinormalSigns[VertexInstance] = Tangent.W;
+		InstanceUVs.Set(VertexInstance, 0, UVs[VertexIdx]);
+		VertexInstances[VertexIdx] = VertexInstance;
+	}
+
+	for (int32 Index = 0; Index < NumIndices; Index += 3)
+	{
+		const FVertexInstanceID Corners[3] = { VertexInstances[Triangles[Index]], VertexInstances[Triangles[Index + 1]], VertexInstances[Triangles[Index + 2]] };
+		OutMeshDescription.CreateTriangle(PolygonGroup, MakeArrayView(Corners));
+	}
+}
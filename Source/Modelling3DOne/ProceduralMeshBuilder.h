@@ -0,0 +1,153 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+#include "ProceduralGeometryKernel.h"
+#include "ProceduralIndexOptimizer.h"
+
+struct FMeshDescription;
+
+// Record layouts FProceduralMeshBuilder::Serialize reads, oldest first; saving always writes Latest
+enum class EProceduralMeshRecordLayout : uint8
+{
+	// Float positions, normals and UVs
+	NoTangents,
+
+	// Float positions, normals, tangents and UVs
+	FloatVertices,
+
+	// Float positions, octahedral normals and tangents, and half precision UVs when they survive the conversion
+	PackedVertices,
+
+	Latest = PackedVertices
+};
+
+/**
+ * Mesh data shared by every procedural actor.
+ * The arrays are sized once from an exact capacity and then filled through raw pointers,
+ * so generation never reallocates and skips the per-element bounds checks of TArray::Add.
+ * Everything is single precision, the precision the render buffers hold, so generated meshes never exist as doubles.
+ */
+struct MODELLING3DONE_API FProceduralMeshBuilder
+{
+	TArray<FVector3f> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector3f> Normals;
+	TArray<FVector2f> UVs;
+	TArray<FColor> VertexColors;
+
+	// TangentX in XYZ and the binormal sign in W: -1 where FProcMeshTangent sets bFlipTangentY
+	TArray<FVector4f> Tangents;
+
+	// Counted in the Live Meshes and vertex/index memory stats for as long as it exists
+	FProceduralMeshBuilder();
+	~FProceduralMeshBuilder();
+	FProceduralMeshBuilder(const FProceduralMeshBuilder&) = delete;
+	FProceduralMeshBuilder& operator=(const FProceduralMeshBuilder&) = delete;
+
+	// Sizes all arrays for exactly Capacity vertices and indices and rewinds the write cursors
+	void Reset(const FProceduralMeshCapacity& InCapacity);
+
+	// Writes one vertex and returns its index
+	FORCEINLINE int32 AddVertex(const FVector3f& Position, const FVector3f& Normal, const FVector4f& Tangent, const FVector2f& UV)
+	{
+		checkSlow(NumVertices < Capacity.NumVertices);
+		Vertices.GetData()[NumVertices] = Position;
+		Normals.GetData()[NumVertices] = Normal;
+		Tangents.GetData()[NumVertices] = Tangent;
+		UVs.GetData()[NumVertices] = UV;
+		return NumVertices++;
+	}
+
+	// Claims Count consecutive vertices for the caller to fill through the array pointers; returns the first index
+	FORCEINLINE int32 AddUninitializedVertices(int32 Count)
+	{
+		checkSlow(NumVertices + Count <= Capacity.NumVertices);
+		const int32 FirstIndex = NumVertices;
+		NumVertices += Count;
+		return FirstIndex;
+	}
+
+	// Claims Count consecutive indices for the caller to fill through the array pointer; returns the first one
+	FORCEINLINE int32 AddUninitializedIndices(int32 Count)
+	{
+		checkSlow(NumIndices + Count <= Capacity.NumIndices);
+		const int32 FirstIndex = NumIndices;
+		NumIndices += Count;
+		return FirstIndex;
+	}
+
+	// Writes the three indices of one triangle
+	FORCEINLINE void AddTriangle(int32 V0, int32 V1, int32 V2)
+	{
+		checkSlow(NumIndices + 3 <= Capacity.NumIndices);
+		int32* Dest = Triangles.GetData() + NumIndices;
+		Dest[0] = V0;
+		Dest[1] = V1;
+		Dest[2] = V2;
+		NumIndices += 3;
+	}
+
+	int32 GetNumVertices() const { return NumVertices; }
+	int32 GetNumIndices() const { return NumIndices; }
+	const FProceduralMeshCapacity& GetCapacity() const { return Capacity; }
+
+	// True when every index fits in 16 bits. UProceduralMeshComponent always uploads 32-bit indices,
+	// so this only matters where the index buffer is stored or uploaded outside the component.
+	bool CanUse16BitIndices() const { return Capacity.NumVertices <= MAX_uint16 + 1; }
+
+	// True when every UV survives half precision to within a 4096th of the texture, so compact destinations may store them as halves
+	bool CanUseHalfPrecisionUVs() const;
+
+	// True when exactly the reserved number of vertices and indices has been written
+	bool IsComplete() const { return NumVertices == Capacity.NumVertices && NumIndices == Capacity.NumIndices; }
+
+	// Validates the counts once generation is done, trimming the arrays to what was actually written
+	void Finalize();
+
+	// Reorders the finished triangles for the post-transform vertex cache and overdraw, then the vertices for fetch
+	// locality (see ProceduralIndexOptimizer.h). The mesh is unchanged apart from its order; returns the ACMR before and after
+	ProceduralGeometry::FIndexOrderStats OptimizeIndexOrder();
+
+	// Heap memory held by the arrays
+	SIZE_T GetAllocatedSize() const;
+
+	// Uploads the built arrays as one section of the given component, converting them straight into its vertex buffer.
+	// bRefreshComponent off only fills the section, for a caller whose last upload refreshes bounds, collision and render state for all
+	void CreateMeshSection(UProceduralMeshComponent* Mesh, int32 SectionIndex, bool bCreateCollision, bool bRefreshComponent = true) const;
+
+	// True when both meshes have the same vertex count and index buffer, so one can replace the other in place
+	bool HasSameTopology(const FProceduralMeshBuilder& Other) const;
+
+	// Rewrites an existing section of the same topology: its render buffers are kept and only refilled.
+	// bUpdateCollision off leaves the collision mesh to a later upload, which reads every section's positions
+	void UpdateMeshSection(UProceduralMeshComponent* Mesh, int32 SectionIndex, bool bUpdateCollision = true) const;
+
+	// Converts the built arrays to a single-material mesh description, e.g. to build a UStaticMesh from it
+	void BuildMeshDescription(FMeshDescription& OutMeshDescription) const;
+
+	// Saves or loads the finished arrays in compact form: float positions, octahedral normals and tangents, half or float UVs,
+	// and 16-bit indices whenever they fit. Saving leaves the builder untouched; loading leaves it complete. Records of an
+	// older Layout load as they were saved; NoTangents leaves the tangents undefined
+	void Serialize(FArchive& Ar, EProceduralMeshRecordLayout Layout = EProceduralMeshRecordLayout::Latest);
+
+private:
+	// Fills the component's own section from the arrays; bWithPositions off leaves its positions and bounds as they are
+	void FillProcMeshSection(FProcMeshSection& Section, bool bWithPositions) const;
+
+	// Normals, tangents and UVs of the PackedVertices layout
+	void SerializePackedAttributes(FArchive& Ar);
+
+	// Brings the memory stats in line with what the arrays hold now
+	void UpdateMemoryStats();
+
+	FProceduralMeshCapacity Capacity;
+	int32 NumVertices = 0;
+	int32 NumIndices = 0;
+
+	// Bytes this builder currently contributes to the memory stats
+	int64 TrackedVertexBytes = 0;
+	int64 TrackedIndexBytes = 0;
+};
@@ -0,0 +1,122 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralMeshCache.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Modelling3DOne.h"
+
+
+static TAutoConsoleVariable<int32> CVarProceduralMeshCacheBudgetMB(
+	TEXT("r.ProceduralMesh.CacheBudgetMB"),
+	64,
+	TEXT("Memory budget in MB of the shared procedural mesh cache. Least recently used meshes are evicted above it; 0 disables caching."),
+	ECVF_Default);
+
+static FAutoConsoleCommand CmdProceduralMeshCacheStats(
+	TEXT("ProceduralMesh.CacheStats"),
+	TEXT("Prints entry count, memory use and hit rate of the shared procedural mesh cache."),
+	FConsoleCommandDelegate::CreateLambda([]() { FProceduralMeshCache::Get().DumpStats(); }));
+
+static FAutoConsoleCommand CmdProceduralMeshCacheFlush(
+	TEXT("ProceduralMesh.CacheFlush"),
+	TEXT("Empties the shared procedural mesh cache."),
+	FConsoleCommandDelegate::CreateLambda([]() { FProceduralMeshCache::Get().Empty(); }));
+
+FProceduralMeshCache& FProceduralMeshCache::Get()
+{
+	static FProceduralMeshCache Instance;
+	return Instance;
+}
+
+FProceduralMeshDataPtr FProceduralMeshCache::Find(const FProceduralMeshKey& Key)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (FEntry* Entry = Entries.Find(Key))
+	{
+		Entry->LastUsed = ++UseCounter;
+		++NumHits;
+		return Entry->MeshData;
+	}
+
+	++NumMisses;
+	return nullptr;
+}
+
+void FProceduralMeshCache::Add(const FProceduralMeshKey& Key, const FProceduralMeshDataRef& MeshData)
+{
+	const SIZE_T BudgetBytes = SIZE_T(FMath::Max(CVarProceduralMeshCacheBudgetMB.GetValueOnAnyThread(), 0)) * 1024 * 1024;
+	const SIZE_T AllocatedSize = MeshData->GetAllocatedSize();
+
+	FScopeLock ScopeLock(&Lock);
+
+	// Two actors missing on the same key at once both build; keep whichever lands first
+	if (FEntry* Existing = Entries.Find(Key))
+	{
+		Existing->LastUsed = ++UseCounter;
+		return;
+	}
+
+	// A mesh bigger than the whole budget would only flush everything else
+	if (AllocatedSize > BudgetBytes)
+	{
+		return;
+	}
+
+	Entries.Add(Key, FEntry{MeshData, AllocatedSize, ++UseCounter});
+	TotalAllocatedSize += AllocatedSize;
+	EvictToBudget();
+}
+
+void FProceduralMeshCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	Entries.Empty();
+	TotalAllocatedSize = 0;
+}
+
+int32 FProceduralMeshCache::GetNumEntries() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
+
+SIZE_T FProceduralMeshCache::GetAllocatedSize() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return TotalAllocatedSize;
+}
+
+void FProceduralMeshCache::DumpStats() const
+{
+	const uint64 Hits = NumHits;
+	const uint64 Misses = NumMisses;
+	const uint64 Lookups = Hits + Misses;
+
+	UE_LOG(LogProceduralMesh, Log, TEXT("Procedural mesh cache: %d entries, %.2f / %d MB, %llu hits, %llu misses (%.1f%% hit rate)"),
+		GetNumEntries(), GetAllocatedSize() / (1024.0 * 1024.0), CVarProceduralMeshCacheBudgetMB.GetValueOnAnyThread(),
+		Hits, Misses, Lookups > 0 ? 100.0 * Hits / Lookups : 0.0);
+}
+
+void FProceduralMeshCache::EvictToBudget()
+{
+	const SIZE_T BudgetBytes = SIZE_T(FMath::Max(CVarProceduralMeshCacheBudgetMB.GetValueOnAnyThread(), 0)) * 1024 * 1024;
+
+	// Only a few dozen distinct parameter sets are expected, so a linear scan for the oldest entry is enough
+	while (TotalAllocatedSize > BudgetBytes && Entries.Num() > 0)
+	{
+		const TPair<FProceduralMeshKey, FEntry>* Oldest = nullptr;
+		for (const TPair<FProceduralMeshKey, FEntry>& Pair : Entries)
+		{
+			if (!Oldest || Pair.Value.LastUsed < Oldest->Value.LastUsed)
+			{
+				Oldest = &Pair;
+			}
+		}
+
+		TotalAllocatedSize -= Oldest->Value.AllocatedSize;
+		const FProceduralMeshKey OldestKey = Oldest->Key;
+		Entries.Remove(OldestKey);
+	}
+}
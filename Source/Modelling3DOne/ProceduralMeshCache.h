@@ -0,0 +1,105 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshBuilder.h"
+
+/**
+ * Identifies a generated mesh by shape type and the exact bytes of its generation parameters.
+ * Two actors with equal keys produce identical geometry, whatever their transform or material.
+ */
+struct FProceduralMeshKey
+{
+	FName ShapeType;
+	TArray<uint8, TInlineAllocator<32>> ParamBytes;
+
+	FProceduralMeshKey() = default;
+	explicit FProceduralMeshKey(FName InShapeType)
+		: ShapeType(InShapeType)
+	{
+	}
+
+	// Appends one parameter; only plain arithmetic values, so the bytes are fully defined
+	template<typename ValueType>
+	FProceduralMeshKey& Append(ValueType Value)
+	{
+		static_assert(TIsArithmetic<ValueType>::Value, "Mesh keys only hold arithmetic parameters");
+		const int32 Offset = ParamBytes.AddUninitialized(sizeof(ValueType));
+		FMemory::Memcpy(ParamBytes.GetData() + Offset, &Value, sizeof(ValueType));
+		return *this;
+	}
+
+	bool operator==(const FProceduralMeshKey& Other) const
+	{
+		return ShapeType == Other.ShapeType && ParamBytes == Other.ParamBytes;
+	}
+
+	bool operator!=(const FProceduralMeshKey& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	friend uint32 GetTypeHash(const FProceduralMeshKey& Key)
+	{
+		return HashCombineFast(GetTypeHash(Key.ShapeType), FCrc::MemCrc32(Key.ParamBytes.GetData(), Key.ParamBytes.Num()));
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FProceduralMeshKey& Key)
+	{
+		return Ar << Key.ShapeType << Key.ParamBytes;
+	}
+};
+
+// Finished, immutable mesh arrays; shared between the cache and every actor committing them
+using FProceduralMeshDataRef = TSharedRef<const FProceduralMeshBuilder, ESPMode::ThreadSafe>;
+using FProceduralMeshDataPtr = TSharedPtr<const FProceduralMeshBuilder, ESPMode::ThreadSafe>;
+
+/**
+ * Process-wide cache of generated meshes, keyed by FProceduralMeshKey.
+ * Entries are ref-counted: eviction only drops the cache's reference, so a mesh still being
+ * committed stays alive. Evicts least recently used entries once over r.ProceduralMesh.CacheBudgetMB.
+ * Thread-safe; background builds add their results directly.
+ */
+class MODELLING3DONE_API FProceduralMeshCache
+{
+public:
+	static FProceduralMeshCache& Get();
+
+	// Returns the cached mesh for Key and marks it most recently used, or null on a miss
+	FProceduralMeshDataPtr Find(const FProceduralMeshKey& Key);
+
+	// Stores a finished mesh under Key and evicts down to the memory budget
+	void Add(const FProceduralMeshKey& Key, const FProceduralMeshDataRef& MeshData);
+
+	// Drops every entry; meshes still referenced elsewhere stay alive
+	void Empty();
+
+	uint64 GetNumHits() const { return NumHits; }
+	uint64 GetNumMisses() const { return NumMisses; }
+	int32 GetNumEntries() const;
+	SIZE_T GetAllocatedSize() const;
+
+	// Prints entry count, memory use and hit rate to the log
+	void DumpStats() const;
+
+private:
+	struct FEntry
+	{
+		FProceduralMeshDataRef MeshData;
+		SIZE_T AllocatedSize;
+		uint64 LastUsed;
+	};
+
+	// Removes least recently used entries until the cache fits in the budget; lock must be held
+	void EvictToBudget();
+
+	mutable FCriticalSection Lock;
+	TMap<FProceduralMeshKey, FEntry> Entries;
+	SIZE_T TotalAllocatedSize = 0;
+	uint64 UseCounter = 0;
+	std::atomic<uint64> NumHits{0};
+	std::atomic<uint64> NumMisses{0};
+};
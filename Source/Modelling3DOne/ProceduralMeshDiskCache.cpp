@@ -0,0 +1,413 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralMeshDiskCache.h"
+
+#include "Async/MappedFileHandle.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modelling3DOne.h"
+#include "ProceduralShapeActor.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+namespace
+{
+	// "PMGC" read as a little-endian uint32; a byte-swapped file fails this check rather than loading garbage
+	constexpr uint32 CacheFileMagic = 0x43474D50;
+
+	// Bump whenever the layout below changes
+	constexpr uint32 CacheFileVersion = 3;
+
+	// Every block starts on a cache line; the mapping itself is page aligned
+	constexpr uint64 BlockAlignment = 64;
+
+	struct FCacheFileHeader
+	{
+		uint32 Magic = CacheFileMagic;
+		uint32 Version = CacheFileVersion;
+
+		// The blocks are raw copies of the builder arrays, so their element sizes are part of the format
+		uint16 PositionSize = sizeof(FVector3f);
+		uint16 NormalSize = sizeof(FVector3f);
+		uint16 TangentSize = sizeof(FVector4f);
+		uint16 UVSize = sizeof(FVector2f);
+		uint16 IndexSize = sizeof(int32);
+		uint16 Padding = 0;
+
+		uint32 NumEntries = 0;
+		uint32 TableChecksum = 0;
+		uint64 TableOffset = 0;
+		uint64 FileSize = 0;
+	};
+
+	// One row of the entry table at the end of the file; offsets count from the start of the file
+	struct FCacheEntryRow
+	{
+		uint64 ShapeTypeOffset = 0;
+		uint64 ParamBytesOffset = 0;
+		uint64 PositionsOffset = 0;
+		uint64 NormalsOffset = 0;
+		uint64 TangentsOffset = 0;
+		uint64 UVsOffset = 0;
+		uint64 IndicesOffset = 0;
+		uint32 ShapeTypeLength = 0;
+		uint32 NumParamBytes = 0;
+		int32 NumVertices = 0;
+		int32 NumIndices = 0;
+
+		// Over the position, normal, tangent, UV and index blocks
+		uint32 DataChecksum = 0;
+		uint32 Padding = 0;
+	};
+
+	// FCrc::MemCrc32 takes an int32 length, so a block past MAX_int32 bytes is treated as damaged rather than narrowed
+	bool IsBlockInFile(uint64 Offset, uint64 Size, uint64 FileSize)
+	{
+		return Size <= uint64(MAX_int32) && Offset <= FileSize && Size <= FileSize - Offset;
+	}
+
+	bool AreRowBlocksInFile(const FCacheEntryRow& Row, uint64 FileSize)
+	{
+		return Row.NumVertices >= 0 && Row.NumIndices >= 0
+			&& IsBlockInFile(Row.ShapeTypeOffset, Row.ShapeTypeLength, FileSize)
+			&& IsBlockInFile(Row.ParamBytesOffset, Row.NumParamBytes, FileSize)
+			&& IsBlockInFile(Row.PositionsOffset, uint64(Row.NumVertices) * sizeof(FVector3f), FileSize)
+			&& IsBlockInFile(Row.NormalsOffset, uint64(Row.NumVertices) * sizeof(FVector3f), FileSize)
+			&& IsBlockInFile(Row.TangentsOffset, uint64(Row.NumVertices) * sizeof(FVector4f), FileSize)
+			&& IsBlockInFile(Row.UVsOffset, uint64(Row.NumVertices) * sizeof(FVector2f), FileSize)
+			&& IsBlockInFile(Row.IndicesOffset, uint64(Row.NumIndices) * sizeof(int32), FileSize);
+	}
+
+	// Checksums one block IsBlockInFile accepted
+	uint32 ChecksumBlock(const uint8* FileData, uint64 Offset, uint64 Size, uint32 Crc = 0)
+	{
+		check(Size <= uint64(MAX_int32));
+		return FCrc::MemCrc32(FileData + Offset, int32(Size), Crc);
+	}
+
+	uint32 ChecksumRowBlocks(const uint8* FileData, const FCacheEntryRow& Row)
+	{
+		uint32 Crc = ChecksumBlock(FileData, Row.PositionsOffset, uint64(Row.NumVertices) * sizeof(FVector3f));
+		Crc = ChecksumBlock(FileData, Row.NormalsOffset, uint64(Row.NumVertices) * sizeof(FVector3f), Crc);
+		Crc = ChecksumBlock(FileData, Row.TangentsOffset, uint64(Row.NumVertices) * sizeof(FVector4f), Crc);
+		Crc = ChecksumBlock(FileData, Row.UVsOffset, uint64(Row.NumVertices) * sizeof(FVector2f), Crc);
+		return ChecksumBlock(FileData, Row.IndicesOffset, uint64(Row.NumIndices) * sizeof(int32), Crc);
+	}
+
+	// Writes every mesh the shape actors of World use into the cache file, keeping the entries of other levels unless asked not to
+	void RebuildDiskCache(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		FProceduralMeshDiskCache& DiskCache = FProceduralMeshDiskCache::Get();
+		TArray<TPair<FProceduralMeshKey, FProceduralMeshDataRef>> Entries;
+		TSet<FProceduralMeshKey> StoredKeys;
+
+		if (!Args.Contains(TEXT("Reset")))
+		{
+			for (const FProceduralMeshKey& Key : DiskCache.GetKeys())
+			{
+				if (FProceduralMeshDataPtr Mesh = DiskCache.Find(Key))
+				{
+					StoredKeys.Add(Key);
+					Entries.Emplace(Key, Mesh.ToSharedRef());
+				}
+			}
+		}
+
+		// Actors that opted out of sharing never read the cache
+		for (TActorIterator<AProceduralShapeActor> It(World); It; ++It)
+		{
+			if (!It->bUseSharedMeshCache)
+			{
+				continue;
+			}
+
+			// The sections the actor looks up at runtime: its LOD chain, or its tiles
+			const TArray<FProceduralMeshKey> SectionKeys = It->GetSectionKeys();
+			for (int32 SectionIndex = 0; SectionIndex < SectionKeys.Num(); SectionIndex++)
+			{
+				if (!StoredKeys.Contains(SectionKeys[SectionIndex]))
+				{
+					StoredKeys.Add(SectionKeys[SectionIndex]);
+					Entries.Emplace(SectionKeys[SectionIndex], It->FindOrBuildSectionMesh(SectionIndex));
+				}
+			}
+		}
+
+		// The mapping has to go before the file can be replaced; the meshes above are copies
+		const FString Path = FProceduralMeshDiskCache::GetDefaultPath();
+		DiskCache.Close();
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), /*Tree=*/true);
+		if (FProceduralMeshDiskCache::Write(Path, Entries))
+		{
+			UE_LOG(LogProceduralMesh, Log, TEXT("Wrote %d meshes to the procedural geometry cache %s"), Entries.Num(), *Path);
+		}
+		else
+		{
+			UE_LOG(LogProceduralMesh, Error, TEXT("Could not write the procedural geometry cache %s"), *Path);
+		}
+		DiskCache.Open(Path);
+	}
+}
+
+static TAutoConsoleVariable<bool> CVarProceduralMeshDiskCache(
+	TEXT("r.ProceduralMesh.DiskCache"),
+	true,
+	TEXT("Take generated meshes from the memory-mapped geometry cache file when it has them."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdProceduralMeshRebuildDiskCache(
+	TEXT("ProceduralMesh.RebuildDiskCache"),
+	TEXT("Writes every mesh the procedural shapes of the current level use to the geometry cache file. Entries of other levels are kept; pass Reset to drop them."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RebuildDiskCache));
+
+FProceduralMeshDiskCache& FProceduralMeshDiskCache::Get()
+{
+	static FProceduralMeshDiskCache Instance;
+	return Instance;
+}
+
+FString FProceduralMeshDiskCache::GetDefaultPath()
+{
+	return FPaths::ProjectContentDir() / TEXT("ProceduralMesh/GeometryCache.bin");
+}
+
+FProceduralMeshDiskCache::FProceduralMeshDiskCache()
+{
+	Open(GetDefaultPath());
+}
+
+FProceduralMeshDiskCache::~FProceduralMeshDiskCache()
+{
+	Close();
+}
+
+bool FProceduralMeshDiskCache::Open(const FString& Path)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FProceduralMeshDiskCache::Open);
+
+	FScopeLock ScopeLock(&Lock);
+	CloseLocked();
+
+	// No file simply means nothing was cached yet
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() < int64(sizeof(FCacheFileHeader)))
+	{
+		CloseLocked();
+		return false;
+	}
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	if (!MappedRegion.IsValid())
+	{
+		CloseLocked();
+		return false;
+	}
+	MappedData = MappedRegion->GetMappedPtr();
+	MappedSize = MappedRegion->GetMappedSize();
+
+	// A stale or damaged file is ignored as a whole and the shapes generate as usual
+	FCacheFileHeader Header;
+	FMemory::Memcpy(&Header, MappedData, sizeof(Header));
+	const FCacheFileHeader Expected;
+	const uint64 TableSize = uint64(Header.NumEntries) * sizeof(FCacheEntryRow);
+	if (Header.Magic != Expected.Magic || Header.Version != Expected.Version
+		|| Header.PositionSize != Expected.PositionSize || Header.NormalSize != Expected.NormalSize || Header.TangentSize != Expected.TangentSize
+		|| Header.UVSize != Expected.UVSize || Header.IndexSize != Expected.IndexSize
+		|| Header.FileSize != MappedSize || !IsBlockInFile(Header.TableOffset, TableSize, MappedSize)
+		|| ChecksumBlock(MappedData, Header.TableOffset, TableSize) != Header.TableChecksum)
+	{
+		UE_LOG(LogProceduralMesh, Warning, TEXT("Ignoring the procedural geometry cache %s: it is from another version or damaged"), *Path);
+		CloseLocked();
+		return false;
+	}
+
+	// Only the keys are read now; the mesh data stays untouched until an actor asks for it
+	for (uint32 EntryIndex = 0; EntryIndex < Header.NumEntries; EntryIndex++)
+	{
+		const uint64 RowOffset = Header.TableOffset + uint64(EntryIndex) * sizeof(FCacheEntryRow);
+		FCacheEntryRow Row;
+		FMemory::Memcpy(&Row, MappedData + RowOffset, sizeof(Row));
+		if (!AreRowBlocksInFile(Row, MappedSize))
+		{
+			continue;
+		}
+
+		FProceduralMeshKey Key(FName(Row.ShapeTypeLength, reinterpret_cast<const ANSICHAR*>(MappedData + Row.ShapeTypeOffset)));
+		Key.ParamBytes.Append(MappedData + Row.ParamBytesOffset, Row.NumParamBytes);
+		FEntry& Entry = Entries.Add(MoveTemp(Key));
+		Entry.TableRowOffset = RowOffset;
+	}
+
+	UE_LOG(LogProceduralMesh, Log, TEXT("Mapped the procedural geometry cache %s: %d entries, %.2f MB"),
+		*Path, Entries.Num(), MappedSize / (1024.0 * 1024.0));
+	return true;
+}
+
+void FProceduralMeshDiskCache::Close()
+{
+	FScopeLock ScopeLock(&Lock);
+	CloseLocked();
+}
+
+void FProceduralMeshDiskCache::CloseLocked()
+{
+	Entries.Empty();
+	MappedData = nullptr;
+	MappedSize = 0;
+
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+FProceduralMeshDataPtr FProceduralMeshDiskCache::Find(const FProceduralMeshKey& Key)
+{
+	if (!CVarProceduralMeshDiskCache.GetValueOnAnyThread())
+	{
+		return nullptr;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FEntry* Entry = Entries.Find(Key);
+	if (!Entry)
+	{
+		return nullptr;
+	}
+
+	FCacheEntryRow Row;
+	FMemory::Memcpy(&Row, MappedData + Entry->TableRowOffset, sizeof(Row));
+
+	// Verified on first use only, so startup never reads entries no actor needs. A damaged entry stays skipped
+	if (!Entry->bVerified)
+	{
+		Entry->bValid = ChecksumRowBlocks(MappedData, Row) == Row.DataChecksum;
+		Entry->bVerified = true;
+		if (!Entry->bValid)
+		{
+			UE_LOG(LogProceduralMesh, Warning, TEXT("Procedural geometry cache entry for %s failed its checksum; generating it instead"),
+				*Key.ShapeType.ToString());
+		}
+	}
+	if (!Entry->bValid)
+	{
+		return nullptr;
+	}
+
+	// The blocks already have the builder's layout, so each array is one copy out of the mapping
+	TSharedRef<FProceduralMeshBuilder, ESPMode::ThreadSafe> Builder = MakeShared<FProceduralMeshBuilder, ESPMode::ThreadSafe>();
+	Builder->Reset(FProceduralMeshCapacity(Row.NumVertices, Row.NumIndices));
+	Builder->AddUninitializedVertices(Row.NumVertices);
+	Builder->AddUninitializedIndices(Row.NumIndices);
+	FMemory::Memcpy(Builder->Vertices.GetData(), MappedData + Row.PositionsOffset, Row.NumVertices * sizeof(FVector3f));
+	FMemory::Memcpy(Builder->Normals.GetData(), MappedData + Row.NormalsOffset, Row.NumVertices * sizeof(FVector3f));
+	FMemory::Memcpy(Builder->Tangents.GetData(), MappedData + Row.TangentsOffset, Row.NumVertices * sizeof(FVector4f));
+	FMemory::Memcpy(Builder->UVs.GetData(), MappedData + Row.UVsOffset, Row.NumVertices * sizeof(FVector2f));
+	FMemory::Memcpy(Builder->Triangles.GetData(), MappedData + Row.IndicesOffset, Row.NumIndices * sizeof(int32));
+	return Builder;
+}
+
+TArray<FProceduralMeshKey> FProceduralMeshDiskCache::GetKeys() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	TArray<FProceduralMeshKey> Keys;
+	Keys.Reserve(Entries.Num());
+	for (const TPair<FProceduralMeshKey, FEntry>& Pair : Entries)
+	{
+		Keys.Add(Pair.Key);
+	}
+	return Keys;
+}
+
+int32 FProceduralMeshDiskCache::GetNumEntries() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
+
+bool FProceduralMeshDiskCache::Write(const FString& Path, const TArray<TPair<FProceduralMeshKey, FProceduralMeshDataRef>>& Entries)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FProceduralMeshDiskCache::Write);
+
+	TArray64<uint8> FileBytes;
+
+	// Appends a block at the next aligned offset and returns that offset
+	auto AppendBlock = [&FileBytes](const void* Data, uint64 Size) -> uint64
+	{
+		const int64 Offset = Align(FileBytes.Num(), int64(BlockAlignment));
+		FileBytes.SetNumZeroed(Offset + Size);
+		if (Size > 0)
+		{
+			FMemory::Memcpy(FileBytes.GetData() + Offset, Data, Size);
+		}
+		return Offset;
+	};
+
+	// Written for real once the table is known
+	FCacheFileHeader Header;
+	AppendBlock(&Header, sizeof(Header));
+
+	TArray<FCacheEntryRow> Rows;
+	Rows.Reserve(Entries.Num());
+	for (const TPair<FProceduralMeshKey, FProceduralMeshDataRef>& Pair : Entries)
+	{
+		const FProceduralMeshBuilder& Mesh = *Pair.Value;
+
+		// Blocks past MAX_int32 bytes could not be checksummed; such a mesh keeps generating instead
+		if (uint64(Mesh.GetNumVertices()) * sizeof(FVector4f) > uint64(MAX_int32) || uint64(Mesh.GetNumIndices()) * sizeof(int32) > uint64(MAX_int32))
+		{
+			UE_LOG(LogProceduralMesh, Warning, TEXT("Leaving a %s mesh of %d vertices out of the procedural geometry cache: it is too large"),
+				*Pair.Key.ShapeType.ToString(), Mesh.GetNumVertices());
+			continue;
+		}
+
+		const auto ShapeType = StringCast<ANSICHAR>(*Pair.Key.ShapeType.ToString());
+
+		FCacheEntryRow& Row = Rows.AddDefaulted_GetRef();
+		Row.ShapeTypeLength = ShapeType.Length();
+		Row.ShapeTypeOffset = AppendBlock(ShapeType.Get(), Row.ShapeTypeLength);
+		Row.NumParamBytes = Pair.Key.ParamBytes.Num();
+		Row.ParamBytesOffset = AppendBlock(Pair.Key.ParamBytes.GetData(), Row.NumParamBytes);
+		Row.NumVertices = Mesh.GetNumVertices();
+		Row.NumIndices = Mesh.GetNumIndices();
+		Row.PositionsOffset = AppendBlock(Mesh.Vertices.GetData(), Row.NumVertices * sizeof(FVector3f));
+		Row.NormalsOffset = AppendBlock(Mesh.Normals.GetData(), Row.NumVertices * sizeof(FVector3f));
+		Row.TangentsOffset = AppendBlock(Mesh.Tangents.GetData(), Row.NumVertices * sizeof(FVector4f));
+
+		Row.UVsOffset = AppendBlock(Mesh.UVs.GetData(), Row.NumVertices * sizeof(FVector2f));
+		Row.IndicesOffset = AppendBlock(Mesh.Triangles.GetData(), Row.NumIndices * sizeof(int32));
+	}
+
+	for (FCacheEntryRow& Row : Rows)
+	{
+		Row.DataChecksum = ChecksumRowBlocks(FileBytes.GetData(), Row);
+	}
+
+	const uint64 TableSize = uint64(Rows.Num()) * sizeof(FCacheEntryRow);
+	if (TableSize > uint64(MAX_int32))
+	{
+		return false;
+	}
+	Header.NumEntries = Rows.Num();
+	Header.TableOffset = AppendBlock(Rows.GetData(), TableSize);
+	Header.TableChecksum = ChecksumBlock(FileBytes.GetData(), Header.TableOffset, TableSize);
+	Header.FileSize = FileBytes.Num();
+	FMemory::Memcpy(FileBytes.GetData(), &Header, sizeof(Header));
+
+	// Written beside the target and moved over it, so a failed write never leaves a half file to map
+	const FString TempPath = Path + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(FileBytes, *TempPath))
+	{
+		return false;
+	}
+	return IFileManager::Get().Move(*Path, *TempPath, /*bReplace=*/true);
+}
@@ -0,0 +1,69 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshCache.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Generated meshes stored in one memory-mapped file, keyed like FProceduralMeshCache.
+ * Each entry is a key followed by 64-byte aligned position, normal, tangent, UV and index blocks laid out exactly like
+ * FProceduralMeshBuilder's arrays, so a hit is a straight copy out of the mapping with nothing to parse or generate.
+ * Opening only reads the header and entry table; each entry's checksum is verified the first time it is used.
+ * Rebuilt for a level with ProceduralMesh.RebuildDiskCache. Thread-safe.
+ */
+class MODELLING3DONE_API FProceduralMeshDiskCache
+{
+public:
+	// The cache mapped from GetDefaultPath(), opened on first use
+	static FProceduralMeshDiskCache& Get();
+
+	// Content/ProceduralMesh/GeometryCache.bin, staged as a loose file so packaged games can map it
+	static FString GetDefaultPath();
+
+	~FProceduralMeshDiskCache();
+
+	// Maps the file at Path in place of the current one; false (and an empty cache) if it is missing or invalid
+	bool Open(const FString& Path);
+
+	// Unmaps the file; meshes already handed out are copies and stay valid
+	void Close();
+
+	// Copies the mesh for Key out of the file, or returns null when it has no valid entry for it
+	FProceduralMeshDataPtr Find(const FProceduralMeshKey& Key);
+
+	// Every key the file holds
+	TArray<FProceduralMeshKey> GetKeys() const;
+
+	int32 GetNumEntries() const;
+
+	// Writes a new cache file holding exactly these meshes. Goes through a temporary file, so close any mapping of Path first
+	static bool Write(const FString& Path, const TArray<TPair<FProceduralMeshKey, FProceduralMeshDataRef>>& Entries);
+
+private:
+	struct FEntry
+	{
+		// Offset of the entry's row in the file's entry table
+		uint64 TableRowOffset = 0;
+
+		// Checksum already compared, and its outcome
+		bool bVerified = false;
+		bool bValid = false;
+	};
+
+	// Opens GetDefaultPath()
+	FProceduralMeshDiskCache();
+
+	// Closes without taking the lock
+	void CloseLocked();
+
+	mutable FCriticalSection Lock;
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* MappedData = nullptr;
+	uint64 MappedSize = 0;
+	TMap<FProceduralMeshKey, FEntry> Entries;
+};
@@ -3,363 +3,222 @@
 
 #include "ProceduralPacMan.h"
 
+#include "Async/ParallelFor.h"
+#include "ProceduralGeometryStats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
-// Sets default values
-AProceduralPacMan::AProceduralPacMan()
+FProceduralMeshKey FProceduralPacManKeyframes::MakeTableKey(const FProceduralPacManParams& Params, int32 NumKeyframes, float MaxMouthAngleDegrees)
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
-	
-	// Create the procedural mesh component
-	ProceduralMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ProceduralMesh"));
-	RootComponent = ProceduralMesh;
-	
-	// Enable collision
-	ProceduralMesh->bUseAsyncCooking = true;
+	FProceduralPacManParams ShapeParams = Params;
+	ShapeParams.MouthAngleDegrees = 0.0f;
+	ShapeParams.bFixedTopology = true;
+
+	FProceduralMeshKey Key = MakeMeshKey(ShapeParams);
+	Key.Append(NumKeyframes);
+	Key.Append(MaxMouthAngleDegrees);
+	return Key;
 }
 
-// Called when the game starts or when spawned
-void AProceduralPacMan::BeginPlay()
+int32 FProceduralPacManKeyframes::GetKeyframeIndex(float MouthAngleDegrees, int32 NumKeyframes, float MaxMouthAngleDegrees)
 {
-	Super::BeginPlay();
-	GeneratePacMan();
+	if (NumKeyframes < 2 || MaxMouthAngleDegrees <= 0.0f)
+	{
+		return 0;
+	}
+	float Alpha = FMath::Clamp(MouthAngleDegrees / MaxMouthAngleDegrees, 0.0f, 1.0f);
+	return FMath::Clamp(FMath::RoundToInt(Alpha * float(NumKeyframes - 1)), 0, NumKeyframes - 1);
 }
 
-void AProceduralPacMan::OnConstruction(const FTransform& Transform)
+float FProceduralPacManKeyframes::GetKeyframeAngle(int32 KeyframeIndex, int32 NumKeyframes, float MaxMouthAngleDegrees)
 {
-	Super::OnConstruction(Transform);
-	GeneratePacMan();
+	return NumKeyframes < 2 ? 0.0f : MaxMouthAngleDegrees * float(KeyframeIndex) / float(NumKeyframes - 1);
 }
 
-void AProceduralPacMan::GeneratePacMan()
+TSharedRef<const FProceduralPacManKeyframes, ESPMode::ThreadSafe> FProceduralPacManKeyframes::Get(const FProceduralPacManParams& Params, int32 NumKeyframes, float MaxMouthAngleDegrees)
 {
-	// Clear existing mesh
-	ProceduralMesh->ClearAllMeshSections();
-
-	// Arrays to hold mesh data
-	TArray<FVector> Vertices;
-	TArray<int32> Triangles;
-	TArray<FVector> Normals;
-	TArray<FVector2D> UVs;
-	TArray<FColor> VertexColors;
-	TArray<FProcMeshTangent> Tangents;
-
-	// Ensure minimum values
-	int32 Parallels = FMath::Max(3, NumParallels);
-	int32 Meridians = FMath::Max(3, NumMeridians);
-
-	// Convert mouth angle to radians (half angle on each side)
-	float HalfMouthAngleRad = FMath::DegreesToRadians(MouthAngleDegrees / 2.0f);
-
-	// Center vertex for mouth (at origin)
-	int32 CenterVertexIndex = Vertices.Num();
-	Vertices.Add(FVector::ZeroVector);
-	Normals.Add(FVector::ForwardVector);
-	UVs.Add(FVector2D(0.5f, 0.5f));
-
-	// Create North Pole vertex
-	FVector NorthPole = FVector(0, 0, Radius);
-	int32 NorthPoleIndex = Vertices.Num();
-	Vertices.Add(NorthPole);
-	Normals.Add(NorthPole.GetSafeNormal());
-	UVs.Add(FVector2D(0.5f, 1.0f));
-
-	// Generate vertices for parallels (latitude circles)
-	for (int32 ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
-	{
-		float Theta = PI * float(ParallelIdx) / float(Parallels);
-		float SinTheta = FMath::Sin(Theta);
-		float CosTheta = FMath::Cos(Theta);
+	check(NumKeyframes > 1);
+	FProceduralMeshKey TableKey = MakeTableKey(Params, NumKeyframes, MaxMouthAngleDegrees);
 
-		for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
-		{
-			float Phi = 2.0f * PI * float(MeridianIdx) / float(Meridians);
-			
-			// Skip vertices in the mouth region
-			float PhiNormalized = Phi;
-			if (PhiNormalized > PI)
-				PhiNormalized = PhiNormalized - 2.0f * PI;
-			
-			if (FMath::Abs(PhiNormalized) < HalfMouthAngleRad)
-				continue;
-
-			float SinPhi = FMath::Sin(Phi);
-			float CosPhi = FMath::Cos(Phi);
-
-			FVector Position = FVector(
-				Radius * SinTheta * CosPhi,
-				Radius * SinTheta * SinPhi,
-				Radius * CosTheta
-			);
-
-			Vertices.Add(Position);
-			Normals.Add(Position.GetSafeNormal());
-
-			float U = float(MeridianIdx) / float(Meridians);
-			float V = float(ParallelIdx) / float(Parallels);
-			UVs.Add(FVector2D(U, V));
-		}
-	}
+	// Held weakly: a table lives as long as some actor samples it
+	static FCriticalSection Lock;
+	static TMap<FProceduralMeshKey, TWeakPtr<const FProceduralPacManKeyframes, ESPMode::ThreadSafe>> Tables;
 
-	// Create South Pole vertex
-	FVector SouthPole = FVector(0, 0, -Radius);
-	int32 SouthPoleIndex = Vertices.Num();
-	Vertices.Add(SouthPole);
-	Normals.Add(SouthPole.GetSafeNormal());
-	UVs.Add(FVector2D(0.5f, 0.0f));
-
-	// --- Helper function to get vertex index ---
-	auto GetVertexIndex = [&](int32 ParallelIdx, int32 MeridianIdx) -> int32
+	auto FindTable = [&TableKey]() -> FProceduralPacManKeyframesPtr
 	{
-		if (ParallelIdx == 0)
-			return NorthPoleIndex;
-		if (ParallelIdx == Parallels)
-			return SouthPoleIndex;
-
-		float Phi = 2.0f * PI * float(MeridianIdx) / float(Meridians);
-		float PhiNormalized = Phi;
-		if (PhiNormalized > PI)
-			PhiNormalized = PhiNormalized - 2.0f * PI;
-
-		if (FMath::Abs(PhiNormalized) < HalfMouthAngleRad)
-			return -1;
-
-		int32 Index = NorthPoleIndex + 1;
-		for (int32 p = 1; p < ParallelIdx; p++)
-		{
-			for (int32 m = 0; m < Meridians; m++)
-			{
-				float TestPhi = 2.0f * PI * float(m) / float(Meridians);
-				float TestPhiNorm = TestPhi > PI ? TestPhi - 2.0f * PI : TestPhi;
-				if (FMath::Abs(TestPhiNorm) >= HalfMouthAngleRad)
-					Index++;
-			}
-		}
-
-		for (int32 m = 0; m < MeridianIdx; m++)
-		{
-			float TestPhi = 2.0f * PI * float(m) / float(Meridians);
-			float TestPhiNorm = TestPhi > PI ? TestPhi - 2.0f * PI : TestPhi;
-			if (FMath::Abs(TestPhiNorm) >= HalfMouthAngleRad)
-				Index++;
-		}
-
-		return Index;
+		const TWeakPtr<const FProceduralPacManKeyframes, ESPMode::ThreadSafe>* Existing = Tables.Find(TableKey);
+		return Existing ? Existing->Pin() : FProceduralPacManKeyframesPtr();
 	};
 
-	// --- Generate Triangles for the sphere surface ---
-
-	// North Pole cap triangles
-	for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
 	{
-		int32 Current = GetVertexIndex(1, MeridianIdx);
-		int32 Next = GetVertexIndex(1, (MeridianIdx + 1) % Meridians);
-
-		if (Current != -1 && Next != -1)
+		FScopeLock ScopeLock(&Lock);
+		if (FProceduralPacManKeyframesPtr Table = FindTable())
 		{
-			Triangles.Add(NorthPoleIndex);
-			Triangles.Add(Next);
-			Triangles.Add(Current);
+			return Table.ToSharedRef();
 		}
 	}
 
-	// Middle section: quads between parallels
-	for (int32 ParallelIdx = 1; ParallelIdx < Parallels - 1; ParallelIdx++)
+	// Built without the lock, so requests for other tables go ahead meanwhile.
+	// Keyframes only differ in their mouth angle, so they build independently
+	TRACE_CPUPROFILER_EVENT_SCOPE(FProceduralPacManKeyframes::Build);
+	const FProceduralShapeStats Stats = FProceduralShapeStats::Get(TableKey.ShapeType);
+	TArray<TSharedPtr<FProceduralMeshBuilder, ESPMode::ThreadSafe>> Builders;
+	Builders.SetNum(NumKeyframes);
+	ParallelFor(NumKeyframes, [&](int32 KeyframeIndex)
 	{
-		for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
-		{
-			int32 NextMeridianIdx = (MeridianIdx + 1) % Meridians;
-
-			int32 Current = GetVertexIndex(ParallelIdx, MeridianIdx);
-			int32 CurrentNext = GetVertexIndex(ParallelIdx, NextMeridianIdx);
-			int32 Below = GetVertexIndex(ParallelIdx + 1, MeridianIdx);
-			int32 BelowNext = GetVertexIndex(ParallelIdx + 1, NextMeridianIdx);
-
-			if (Current != -1 && CurrentNext != -1 && Below != -1 && BelowNext != -1)
-			{
-				Triangles.Add(Current);
-				Triangles.Add(CurrentNext);
-				Triangles.Add(Below);
-
-				Triangles.Add(CurrentNext);
-				Triangles.Add(BelowNext);
-				Triangles.Add(Below);
-			}
-		}
+		FScopeCycleCounter BuildCycles(Stats.Build);
+
+		FProceduralPacManParams KeyframeParams = Params;
+		KeyframeParams.MouthAngleDegrees = GetKeyframeAngle(KeyframeIndex, NumKeyframes, MaxMouthAngleDegrees);
+		KeyframeParams.bFixedTopology = true;
+
+		TSharedRef<FProceduralMeshBuilder, ESPMode::ThreadSafe> Builder = MakeShared<FProceduralMeshBuilder, ESPMode::ThreadSafe>();
+		FProceduralBuildToken Token;
+		AProceduralPacMan::BuildMesh(KeyframeParams, *Builder, Token);
+		Builder->Finalize();
+		Builders[KeyframeIndex] = Builder;
+	});
+
+	TSharedRef<FProceduralPacManKeyframes, ESPMode::ThreadSafe> Table = MakeShared<FProceduralPacManKeyframes, ESPMode::ThreadSafe>();
+	Table->TableKey = TableKey;
+	Table->Meshes.Reserve(NumKeyframes);
+	for (const TSharedPtr<FProceduralMeshBuilder, ESPMode::ThreadSafe>& Builder : Builders)
+	{
+		Table->Meshes.Add(Builder.ToSharedRef());
 	}
 
-	// South Pole cap triangles
-	for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+	// Another thread may have built the same table meanwhile; keep the first so every actor shares one
+	FScopeLock ScopeLock(&Lock);
+	if (FProceduralPacManKeyframesPtr Existing = FindTable())
 	{
-		int32 Current = GetVertexIndex(Parallels - 1, MeridianIdx);
-		int32 Next = GetVertexIndex(Parallels - 1, (MeridianIdx + 1) % Meridians);
+		return Existing.ToSharedRef();
+	}
 
-		if (Current != -1 && Next != -1)
+	// Forget tables nobody holds any more
+	for (auto It = Tables.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
 		{
-			Triangles.Add(Current);
-			Triangles.Add(Next);
-			Triangles.Add(SouthPoleIndex);
+			It.RemoveCurrent();
 		}
 	}
+	Tables.Add(TableKey, Table);
+	return Table;
+}
+
+FProceduralPacManParams AProceduralPacMan::GetMeshParams(int32 LODIndex) const
+{
+	FProceduralPacManParams Params;
+	Params.Radius = Radius;
+	Params.MouthAngleDegrees = MouthAngleDegrees;
+
+	// Each LOD halves both ring counts, down to the minimum the generator accepts
+	Params.NumParallels = FMath::Max(3, NumParallels >> LODIndex);
+	Params.NumMeridians = FMath::Max(3, NumMeridians >> LODIndex);
 
-	// --- Create mouth wall vertices and triangles ---
-	
-	// Calculate normal for upper wall (perpendicular to the upper mouth edge)
-	// The upper edge is at angle +HalfMouthAngleRad, so normal points perpendicular inward
-	FVector UpperWallNormal = FVector(
-		-FMath::Sin(HalfMouthAngleRad),  // Perpendicular to the edge
-		FMath::Cos(HalfMouthAngleRad),
-		0
-	).GetSafeNormal();
-	
-	// Calculate normal for lower wall
-	FVector LowerWallNormal = FVector(
-		-FMath::Sin(-HalfMouthAngleRad),
-		FMath::Cos(-HalfMouthAngleRad),
-		0
-	).GetSafeNormal();
-	
-	// Create vertices along the upper mouth wall edge
-	TArray<int32> UpperMouthWallVertices;
-	
-	// Add north pole for upper wall (duplicate with different normal)
-	int32 UpperNorthPole = Vertices.Num();
-	Vertices.Add(NorthPole);
-	Normals.Add(UpperWallNormal);
-	UVs.Add(FVector2D(0.0f, 1.0f));
-	UpperMouthWallVertices.Add(UpperNorthPole);
-	
-	for (int32 ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+	// Keyframed mouths snap to the angle their shared mesh was built at
+	Params.bFixedTopology = bFixedMouthTopology || NumMouthKeyframes > 1;
+	if (NumMouthKeyframes > 1)
 	{
-		float Theta = PI * float(ParallelIdx) / float(Parallels);
-		float SinTheta = FMath::Sin(Theta);
-		float CosTheta = FMath::Cos(Theta);
-		
-		// Upper edge is at +HalfMouthAngleRad
-		FVector Position = FVector(
-			Radius * SinTheta * FMath::Cos(HalfMouthAngleRad),
-			Radius * SinTheta * FMath::Sin(HalfMouthAngleRad),
-			Radius * CosTheta
-		);
-		
-		int32 VertIdx = Vertices.Num();
-		Vertices.Add(Position);
-		Normals.Add(UpperWallNormal);
-		UVs.Add(FVector2D(0.0f, 1.0f - float(ParallelIdx) / float(Parallels)));
-		UpperMouthWallVertices.Add(VertIdx);
+		int32 KeyframeIndex = FProceduralPacManKeyframes::GetKeyframeIndex(MouthAngleDegrees, NumMouthKeyframes, MaxMouthAngleDegrees);
+		Params.MouthAngleDegrees = FProceduralPacManKeyframes::GetKeyframeAngle(KeyframeIndex, NumMouthKeyframes, MaxMouthAngleDegrees);
 	}
-	
-	// Add south pole for upper wall
-	int32 UpperSouthPole = Vertices.Num();
-	Vertices.Add(SouthPole);
-	Normals.Add(UpperWallNormal);
-	UVs.Add(FVector2D(0.0f, 0.0f));
-	UpperMouthWallVertices.Add(UpperSouthPole);
-	
-	// Create vertices along the lower mouth wall edge
-	TArray<int32> LowerMouthWallVertices;
-	
-	// Add north pole for lower wall
-	int32 LowerNorthPole = Vertices.Num();
-	Vertices.Add(NorthPole);
-	Normals.Add(LowerWallNormal);
-	UVs.Add(FVector2D(1.0f, 1.0f));
-	LowerMouthWallVertices.Add(LowerNorthPole);
-	
-	for (int32 ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+	return Params;
+}
+
+FProceduralMeshDataPtr AProceduralPacMan::FindPrebuiltMesh(int32 LODIndex) const
+{
+	if (NumMouthKeyframes < 2)
 	{
-		float Theta = PI * float(ParallelIdx) / float(Parallels);
-		float SinTheta = FMath::Sin(Theta);
-		float CosTheta = FMath::Cos(Theta);
-		
-		// Lower edge is at -HalfMouthAngleRad
-		FVector Position = FVector(
-			Radius * SinTheta * FMath::Cos(-HalfMouthAngleRad),
-			Radius * SinTheta * FMath::Sin(-HalfMouthAngleRad),
-			Radius * CosTheta
-		);
-		
-		int32 VertIdx = Vertices.Num();
-		Vertices.Add(Position);
-		Normals.Add(LowerWallNormal);
-		UVs.Add(FVector2D(1.0f, 1.0f - float(ParallelIdx) / float(Parallels)));
-		LowerMouthWallVertices.Add(VertIdx);
+		return nullptr;
 	}
-	
-	// Add south pole for lower wall
-	int32 LowerSouthPole = Vertices.Num();
-	Vertices.Add(SouthPole);
-	Normals.Add(LowerWallNormal);
-	UVs.Add(FVector2D(1.0f, 0.0f));
-	LowerMouthWallVertices.Add(LowerSouthPole);
-	
-	// Create center vertex duplicates for each wall
-	int32 CenterUpperWall = Vertices.Num();
-	Vertices.Add(FVector::ZeroVector);
-	Normals.Add(UpperWallNormal);
-	UVs.Add(FVector2D(0.5f, 0.5f));
-	
-	int32 CenterLowerWall = Vertices.Num();
-	Vertices.Add(FVector::ZeroVector);
-	Normals.Add(LowerWallNormal);
-	UVs.Add(FVector2D(0.5f, 0.5f));
-	
-	// Create triangles for upper mouth wall (connecting to center)
-	for (int32 i = 0; i < UpperMouthWallVertices.Num() - 1; i++)
+
+	// Only look the table up again when this level's shape or keyframe layout changed
+	FProceduralPacManParams Params = GetMeshParams(LODIndex);
+	if (LODKeyframes.Num() <= LODIndex)
 	{
-		Triangles.Add(CenterUpperWall);
-		Triangles.Add(UpperMouthWallVertices[i]);
-		Triangles.Add(UpperMouthWallVertices[i + 1]);
+		LODKeyframes.SetNum(LODIndex + 1);
 	}
-	
-	// Create triangles for lower mouth wall (connecting to center, reversed winding)
-	for (int32 i = 0; i < LowerMouthWallVertices.Num() - 1; i++)
+	FProceduralPacManKeyframesPtr& Keyframes = LODKeyframes[LODIndex];
+	if (!Keyframes.IsValid() || Keyframes->TableKey != FProceduralPacManKeyframes::MakeTableKey(Params, NumMouthKeyframes, MaxMouthAngleDegrees))
 	{
-		Triangles.Add(CenterLowerWall);
-		Triangles.Add(LowerMouthWallVertices[i + 1]);
-		Triangles.Add(LowerMouthWallVertices[i]);
+		Keyframes = FProceduralPacManKeyframes::Get(Params, NumMouthKeyframes, MaxMouthAngleDegrees);
 	}
+	return Keyframes->Meshes[FProceduralPacManKeyframes::GetKeyframeIndex(MouthAngleDegrees, NumMouthKeyframes, MaxMouthAngleDegrees)];
+}
 
+FProceduralMeshBuildFunction AProceduralPacMan::CreateMeshBuildFunction(int32 LODIndex) const
+{
+	return [Params = GetMeshParams(LODIndex)](FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
+	{
+		BuildMesh(Params, Builder, Token);
+	};
+}
 
-	// Create the mesh section
-	ProceduralMesh->CreateMeshSection(0, Vertices, Triangles, Normals, UVs, 
-									  VertexColors, Tangents, true);
+FString AProceduralPacMan::GetTessellationDescription(int32 LODIndex) const
+{
+	const FProceduralPacManParams Params = GetMeshParams(LODIndex);
+	return FString::Printf(TEXT("%dx%d"), Params.NumParallels, Params.NumMeridians);
+}
 
-	// Apply material if set
-	if (PacManMaterial)
-	{
-		ProceduralMesh->SetMaterial(0, PacManMaterial);
-	}
-	
-	// Enable collision
-	ProceduralMesh->ContainsPhysicsTriMeshData(true);
+void AProceduralPacMan::GeneratePacMan()
+{
+	RegenerateMesh();
 }
 
-void AProceduralPacMan::CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals,
-	TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2)
+void AProceduralPacMan::SetMouthAngle(float NewMouthAngleDegrees)
 {
-	// Add vertices
-	int32 StartIndex = Vertices.Num();
-	Vertices.Add(V0);
-	Vertices.Add(V1);
-	Vertices.Add(V2);
-
-	// Add triangle indices (counter-clockwise for proper face orientation)
-	Triangles.Add(StartIndex);
-	Triangles.Add(StartIndex + 1);
-	Triangles.Add(StartIndex + 2);
-
-	// Calculate normal for the triangle
-	FVector Normal = FVector::CrossProduct(V1 - V0, V2 - V0).GetSafeNormal();
-	Normals.Add(Normal);
-	Normals.Add(Normal);
-	Normals.Add(Normal);
-
-	// Add UV coordinates (basic planar mapping)
-	UVs.Add(FVector2D(0, 0));
-	UVs.Add(FVector2D(1, 0));
-	UVs.Add(FVector2D(0, 1));
+	MouthAngleDegrees = NewMouthAngleDegrees;
+	RegenerateMesh();
 }
 
+FProceduralMeshCapacity AProceduralPacMan::ComputeMeshCapacity(const FProceduralPacManParams& Params)
+{
+	return ProceduralGeometry::ComputePacManCapacity(Params);
+}
 
+void AProceduralPacMan::BuildMesh(const FProceduralPacManParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
+{
+	FProceduralMeshWriter Writer(Builder, Token);
+	ProceduralGeometry::BuildPacMan(Params, Writer);
+}
+
+
+void AProceduralPacMan::BuildCollisionHulls(const FProceduralPacManParams& Params, TArray<TArray<FVector>>& OutHulls)
+{
+	// What the mouth leaves of the ball, split by the XZ plane, is two pieces that are each the ball clipped
+	// by two half-spaces through the Z axis (a mouth wall and the split plane), so both are convex
+	float HalfMouthAngleRad = FMath::Max(0.0f, FMath::DegreesToRadians(Params.MouthAngleDegrees / 2.0f));
+	if (HalfMouthAngleRad >= PI)
+	{
+		return;
+	}
+
+	// Coarse sampling of each half: at most half the hull meridian budget across the arc, and as many parallels
+	int32 Parallels = FMath::Clamp(Params.NumParallels, 3, MaxCollisionHullMeridians / 2);
+	int32 ArcSteps = MaxCollisionHullMeridians / 2;
+
+	for (float Side : { 1.0f, -1.0f })
+	{
+		TArray<FVector>& Hull = OutHulls.AddDefaulted_GetRef();
+		Hull.Reserve(3 + (Parallels - 1) * (ArcSteps + 1));
 
+		// The mouth corner and both poles lie on the cut edge of each half
+		Hull.Add(FVector::ZeroVector);
+		Hull.Add(FVector(0, 0, Params.Radius));
+		Hull.Add(FVector(0, 0, -Params.Radius));
+
+		for (int32 ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+		{
+			float Theta = PI * float(ParallelIdx) / float(Parallels);
+			float RingRadius = Params.Radius * FMath::Sin(Theta);
+			float Z = Params.Radius * FMath::Cos(Theta);
+
+			// From the mouth wall round to the back of the head; the lower half mirrors the upper one
+			for (int32 Step = 0; Step <= ArcSteps; Step++)
+			{
+				float Phi = FMath::Lerp(HalfMouthAngleRad, PI, float(Step) / float(ArcSteps));
+				Hull.Add(FVector(RingRadius * FMath::Cos(Phi), Side * RingRadius * FMath::Sin(Phi), Z));
+			}
+		}
+	}
+}
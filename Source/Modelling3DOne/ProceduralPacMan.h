@@ -3,34 +3,70 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "ProceduralMeshComponent.h"
+#include "ProceduralShapeActor.h"
 #include "ProceduralPacMan.generated.h"
 
-UCLASS()
-class MODELLING3DONE_API AProceduralPacMan : public AActor
+// Identifies the generated Pac-Man mesh; every field of FProceduralPacManParams must be appended
+inline FProceduralMeshKey MakeMeshKey(const FProceduralPacManParams& Params)
 {
-	GENERATED_BODY()
+	FProceduralMeshKey Key(TEXT("PacMan"));
+	Key.Append(Params.Radius);
+	Key.Append(Params.MouthAngleDegrees);
+	Key.Append(Params.NumParallels);
+	Key.Append(Params.NumMeridians);
+	Key.Append(Params.bFixedTopology);
+	return Key;
+}
 
-public:
-	// Sets default values for this actor's properties
-	AProceduralPacMan();
+/**
+ * Fixed-topology Pac-Man meshes precomputed at evenly spaced mouth angles from 0 to MaxMouthAngleDegrees.
+ * One table is shared by every actor with the same radius and tessellation, so a crowd animating its mouths
+ * only swaps between these meshes and rewrites its sections in place; nothing is generated per frame.
+ */
+struct MODELLING3DONE_API FProceduralPacManKeyframes
+{
+	// Identifies the table: the shape key with the mouth angle cleared, plus the keyframe layout
+	FProceduralMeshKey TableKey;
+	TArray<FProceduralMeshDataRef> Meshes;
 
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	virtual void OnConstruction(const FTransform& Transform) override;
+	static FProceduralMeshKey MakeTableKey(const FProceduralPacManParams& Params, int32 NumKeyframes, float MaxMouthAngleDegrees);
 
-public:
-	// The procedural mesh component that will hold our geometry
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
-	UProceduralMeshComponent* ProceduralMesh;
+	// Keyframe nearest to the angle, clamped to the table's range, and the exact angle it was built at
+	static int32 GetKeyframeIndex(float MouthAngleDegrees, int32 NumKeyframes, float MaxMouthAngleDegrees);
+	static float GetKeyframeAngle(int32 KeyframeIndex, int32 NumKeyframes, float MaxMouthAngleDegrees);
+
+	// Returns the table for the shape (its mouth angle is ignored), building every keyframe in parallel on first use.
+	// Tables are freed once no actor holds them
+	static TSharedRef<const FProceduralPacManKeyframes, ESPMode::ThreadSafe> Get(const FProceduralPacManParams& Params, int32 NumKeyframes, float MaxMouthAngleDegrees);
+};
 
+using FProceduralPacManKeyframesPtr = TSharedPtr<const FProceduralPacManKeyframes, ESPMode::ThreadSafe>;
+
+UCLASS()
+class MODELLING3DONE_API AProceduralPacMan : public AProceduralShapeActor
+{
+	GENERATED_BODY()
+
+public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="PacMan")
 	float Radius = 100.0f;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="PacMan")
 	float MouthAngleDegrees = 40.0f;
+
+	// Keep every meridian and fold the ones inside the mouth onto its walls. The vertex and index counts then
+	// no longer depend on MouthAngleDegrees, so changing it only rewrites the vertices in place
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="PacMan|Animation")
+	bool bFixedMouthTopology = false;
+
+	// Snap the mouth to this many precomputed angles between 0 and MaxMouthAngleDegrees, shared by every Pac-Man
+	// with the same radius and tessellation (see FProceduralPacManKeyframes). Implies a fixed topology; 0 disables
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="PacMan|Animation", meta=(ClampMin="0", ClampMax="256"))
+	int32 NumMouthKeyframes = 0;
+
+	// Widest mouth the keyframes cover
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="PacMan|Animation", meta=(ClampMin="0", ClampMax="360"))
+	float MaxMouthAngleDegrees = 90.0f;
  
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="PacMan", meta=(ClampMin="3"))
 	int32 NumParallels = 16;
@@ -50,9 +86,33 @@ public:
 	// Function to generate the sphere mesh
 	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
 	void GeneratePacMan();
-	
+
+	// Opens or closes the mouth; with a fixed topology or keyframes this is a cheap per-frame update
+	UFUNCTION(BlueprintCallable, Category = "PacMan|Animation")
+	void SetMouthAngle(float NewMouthAngleDegrees);
+
+	// Snapshot of the shape parameters GeneratePacMan builds from, coarsened for the given LOD
+	FProceduralPacManParams GetMeshParams(int32 LODIndex = 0) const;
+
+	// Exact vertex and index counts GeneratePacMan will emit for the current parameters
+	FProceduralMeshCapacity ComputeMeshCapacity() const { return ComputeMeshCapacity(GetMeshParams()); }
+	static FProceduralMeshCapacity ComputeMeshCapacity(const FProceduralPacManParams& Params);
+
+	// Fills the builder with the Pac-Man mesh; touches no actor state, so it can run off the game thread
+	static void BuildMesh(const FProceduralPacManParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token);
+
+	// Two convex halves of the cut sphere, split at the back, used by Simple collision
+	static void BuildCollisionHulls(const FProceduralPacManParams& Params, TArray<TArray<FVector>>& OutHulls);
+
+protected:
+	virtual FProceduralMeshBuildFunction CreateMeshBuildFunction(int32 LODIndex) const override;
+	virtual FProceduralMeshKey GetMeshKey(int32 LODIndex) const override { return MakeMeshKey(GetMeshParams(LODIndex)); }
+	virtual FString GetTessellationDescription(int32 LODIndex) const override;
+	virtual FProceduralMeshDataPtr FindPrebuiltMesh(int32 LODIndex) const override;
+	virtual UMaterialInterface* GetShapeMaterial() const override { return PacManMaterial; }
+	virtual bool GetSimpleCollisionHulls(TArray<TArray<FVector>>& OutHulls) const override { BuildCollisionHulls(GetMeshParams(), OutHulls); return true; }
+
 private:
-	// Helper function to create a single triangle
-	void CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, 
-					   TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2);
+	// Keyframe table each LOD last sampled, held so it stays alive while this actor uses it
+	mutable TArray<FProceduralPacManKeyframesPtr> LODKeyframes;
 };
\ No newline at end of file
@@ -3,108 +3,270 @@
 
 #include "ProceduralPlaneActor.h"
 
+#include "Camera/PlayerCameraManager.h"
+#include "Kismet/GameplayStatics.h"
 
-// Sets default values
-AProceduralPlaneActor::AProceduralPlaneActor()
+void AProceduralPlaneActor::BeginPlay()
 {
-	PrimaryActorTick.bCanEverTick = false;
-
-	// Create the procedural mesh component
-	ProceduralMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ProceduralMesh"));
-	RootComponent = ProceduralMesh;
-	
-	// Enable collision
-	ProceduralMesh->bUseAsyncCooking = true;
+	RefreshHeightSnapshot();
+	if (IsStreaming())
+	{
+		ComputeStreamedTileLODs(StreamedTileLODs);
+	}
+	Super::BeginPlay();
 }
 
+void AProceduralPlaneActor::OnConstruction(const FTransform& Transform)
+{
+	RefreshHeightSnapshot();
+	if (IsStreaming())
+	{
+		ComputeStreamedTileLODs(StreamedTileLODs);
+	}
+	Super::OnConstruction(Transform);
+}
 
-// Called when the game starts or when spawned
-void AProceduralPlaneActor::BeginPlay()
+void AProceduralPlaneActor::Tick(float DeltaSeconds)
 {
-	Super::BeginPlay();
-	GeneratePlane();
+	Super::Tick(DeltaSeconds);
+	UpdateStreaming();
 }
 
+FProceduralPlaneParams AProceduralPlaneActor::GetMeshParams(int32 LODIndex) const
+{
+	FProceduralPlaneParams Params;
+	Params.Nb_Lignes = Nb_Lignes;
+	Params.Nb_Colones = Nb_Colones;
+	Params.QuadSize = QuadSize;
+	Params.bUseIndexedGrid = bUseIndexedGrid;
 
-void AProceduralPlaneActor::OnConstruction(const FTransform& Transform)
+	// Points into the snapshot; the build functions hold on to it
+	const TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> Heights = GetHeightSnapshot();
+	if (Heights.IsValid() && HeightSamplesWidth > 0 && Heights->Num() >= HeightSamplesWidth)
+	{
+		Params.HeightSamples = Heights->GetData();
+		Params.HeightSamplesX = HeightSamplesWidth;
+		Params.HeightSamplesY = Heights->Num() / HeightSamplesWidth;
+		Params.HeightScale = HeightScale;
+		Params.HeightSamplesHashLow = HeightSnapshotHash.LowBits;
+		Params.HeightSamplesHashHigh = HeightSnapshotHash.HighBits;
+	}
+	Params.NoiseAmplitude = NoiseAmplitude;
+	Params.NoiseScale = NoiseScale;
+	Params.NoiseOctaves = NoiseOctaves;
+	Params.NoiseSeed = NoiseSeed;
+
+	// Each LOD merges 2x2 quads while both counts stay even, which keeps the exact same extent. Heights are
+	// placed by position, so a coarser grid samples the same surface at every other corner
+	for (int32 Level = 0; Level < LODIndex && Params.Nb_Lignes % 2 == 0 && Params.Nb_Colones % 2 == 0 && Params.Nb_Lignes > 0; Level++)
+	{
+		Params.Nb_Lignes /= 2;
+		Params.Nb_Colones /= 2;
+		Params.QuadSize *= 2.0f;
+	}
+	return Params;
+}
+
+FProceduralMeshBuildFunction AProceduralPlaneActor::CreateMeshBuildFunction(int32 LODIndex) const
 {
-	Super::OnConstruction(Transform);
-	GeneratePlane();
+	return [Params = GetMeshParams(LODIndex), Heights = GetHeightSnapshot()](FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
+	{
+		BuildMesh(Params, Builder, Token);
+	};
 }
 
+FString AProceduralPlaneActor::GetTessellationDescription(int32 LODIndex) const
+{
+	const FProceduralPlaneParams Params = GetMeshParams(LODIndex);
+	return FString::Printf(TEXT("%dx%d"), Params.Nb_Lignes, Params.Nb_Colones);
+}
 
-void AProceduralPlaneActor::CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, 
-                                          TArray<FVector>& Normals, TArray<FVector2D>& UVs, 
-                                          const FVector& V0, const FVector& V1, const FVector& V2)
+FProceduralPlaneTile AProceduralPlaneActor::GetTile(int32 TileIndex) const
 {
-	// Add vertices
-	int32 StartIndex = Vertices.Num();
-	Vertices.Add(V0);
-	Vertices.Add(V1);
-	Vertices.Add(V2);
+	FProceduralPlaneTile Tile = GetTileRect(TileIndex);
+	if (IsStreaming() && StreamedTileLODs.Num() == GetNumTiles())
+	{
+		if (StreamedTileLODs[TileIndex] == INDEX_NONE)
+		{
+			Tile.NumRows = 0;
+			Tile.NumCols = 0;
+		}
+		else
+		{
+			Tile.LOD = StreamedTileLODs[TileIndex];
+			Tile.SkirtDepth = SkirtDepth;
+		}
+	}
+	return Tile;
+}
 
-	// Add triangle indices (counter-clockwise for proper face orientation)
-	Triangles.Add(StartIndex);
-	Triangles.Add(StartIndex + 1);
-	Triangles.Add(StartIndex + 2);
+FProceduralPlaneTile AProceduralPlaneActor::GetTileRect(int32 TileIndex) const
+{
+	const int32 NumTileColumns = GetNumTileColumns();
+	FProceduralPlaneTile Tile;
+	Tile.FirstRow = (TileIndex / NumTileColumns) * TileSize;
+	Tile.FirstCol = (TileIndex % NumTileColumns) * TileSize;
+	Tile.NumRows = FMath::Min(TileSize, Nb_Lignes - Tile.FirstRow);
+	Tile.NumCols = FMath::Min(TileSize, Nb_Colones - Tile.FirstCol);
+	return Tile;
+}
 
-	// Calculate normal for the triangle
-	FVector Normal = FVector::CrossProduct(V1 - V0, V2 - V0).GetSafeNormal();
-	Normals.Add(Normal);
-	Normals.Add(Normal);
-	Normals.Add(Normal);
+int32 AProceduralPlaneActor::GetNumTiles() const
+{
+	// A grid that fits in one tile stays a single section with its LOD chain
+	if (TileSize <= 0 || (Nb_Lignes <= TileSize && Nb_Colones <= TileSize))
+	{
+		return 1;
+	}
+	return FMath::DivideAndRoundUp(FMath::Max(0, Nb_Lignes), TileSize) * GetNumTileColumns();
+}
 
-	// Add UV coordinates (basic planar mapping)
-	UVs.Add(FVector2D(0, 0));
-	UVs.Add(FVector2D(1, 0));
-	UVs.Add(FVector2D(0, 1));
+FProceduralMeshBuildFunction AProceduralPlaneActor::CreateTileBuildFunction(int32 TileIndex) const
+{
+	return [Params = GetMeshParams(), Heights = GetHeightSnapshot(), Tile = GetTile(TileIndex)](FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
+	{
+		BuildTileMesh(Params, Tile, Builder, Token);
+	};
 }
 
 void AProceduralPlaneActor::GeneratePlane()
 {
-	// Clear existing mesh
-	ProceduralMesh->ClearAllMeshSections();
+	RefreshHeightSnapshot();
+	if (IsStreaming())
+	{
+		ComputeStreamedTileLODs(StreamedTileLODs);
+	}
+	RegenerateMesh();
+}
 
-	// Arrays to hold mesh data
-	TArray<FVector> Vertices;
-	TArray<int32> Triangles;
-	TArray<FVector> Normals;
-	TArray<FVector2D> UVs;
-	TArray<FColor> VertexColors;
-	TArray<FProcMeshTangent> Tangents;
+void AProceduralPlaneActor::SetHeightSamples(const TArray<float>& Samples, int32 Width)
+{
+	HeightSamples = Samples;
+	HeightSamplesWidth = FMath::Max(1, Width);
+	GeneratePlane();
+}
+
+void AProceduralPlaneActor::SetStreamingFocus(FVector WorldLocation)
+{
+	StreamingFocus = WorldLocation;
+	bHasStreamingFocus = true;
+	UpdateStreaming();
+}
+
+void AProceduralPlaneActor::ClearStreamingFocus()
+{
+	bHasStreamingFocus = false;
+	UpdateStreaming();
+}
+
+TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> AProceduralPlaneActor::GetHeightSnapshot() const
+{
+	if (!HeightSnapshot.IsValid() && HeightSamples.Num() > 0)
+	{
+		HeightSnapshot = MakeShared<TArray<float>, ESPMode::ThreadSafe>(HeightSamples);
+		HeightSnapshotHash = FXxHash128::HashBuffer(HeightSamples.GetData(), HeightSamples.Num() * sizeof(float));
+	}
+	return HeightSnapshot;
+}
+
+void AProceduralPlaneActor::RefreshHeightSnapshot()
+{
+	// The hash tells cached meshes of different samples apart in the mesh keys, along with the sample counts
+	const FXxHash128 Hash = FXxHash128::HashBuffer(HeightSamples.GetData(), HeightSamples.Num() * sizeof(float));
+	if (HeightSamples.Num() == 0)
+	{
+		HeightSnapshot.Reset();
+	}
+	else if (!HeightSnapshot.IsValid() || HeightSnapshot->Num() != HeightSamples.Num() || Hash != HeightSnapshotHash)
+	{
+		HeightSnapshot = MakeShared<TArray<float>, ESPMode::ThreadSafe>(HeightSamples);
+	}
+	HeightSnapshotHash = Hash;
+}
+
+FVector AProceduralPlaneActor::GetLocalStreamingFocus() const
+{
+	if (bHasStreamingFocus)
+	{
+		return GetActorTransform().InverseTransformPosition(StreamingFocus);
+	}
+	if (const APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0))
+	{
+		return GetActorTransform().InverseTransformPosition(CameraManager->GetCameraLocation());
+	}
+	return FVector(0.5 * Nb_Colones * QuadSize, 0.5 * Nb_Lignes * QuadSize, 0.0);
+}
 
-	// Generate a grid of quads, each made of 2 triangles
-	// The plane will be in the XY plane (horizontal)
-	for (int32 Row = 0; Row < Nb_Lignes; Row++)
+void AProceduralPlaneActor::ComputeStreamedTileLODs(TArray<int32>& OutTileLODs) const
+{
+	const FVector Focus = GetLocalStreamingFocus();
+	const int32 NumTiles = GetNumTiles();
+	OutTileLODs.SetNum(NumTiles);
+	for (int32 TileIndex = 0; TileIndex < NumTiles; TileIndex++)
 	{
-		for (int32 Col = 0; Col < Nb_Colones; Col++)
+		// Distance in the plane from the focus to the tile, 0 above it
+		const FProceduralPlaneTile Tile = GetTileRect(TileIndex);
+		const double X0 = double(Tile.FirstCol) * QuadSize;
+		const double X1 = double(Tile.FirstCol + Tile.NumCols) * QuadSize;
+		const double Y0 = double(Tile.FirstRow) * QuadSize;
+		const double Y1 = double(Tile.FirstRow + Tile.NumRows) * QuadSize;
+		const double DeltaX = FMath::Max3(FMath::Min(X0, X1) - Focus.X, 0.0, Focus.X - FMath::Max(X0, X1));
+		const double DeltaY = FMath::Max3(FMath::Min(Y0, Y1) - Focus.Y, 0.0, Focus.Y - FMath::Max(Y0, Y1));
+		const double Distance = FMath::Sqrt(DeltaX * DeltaX + DeltaY * DeltaY);
+
+		int32 LOD = 0;
+		double Limit = StreamingDistance;
+		while (LOD < NumStreamingLODs && Distance >= Limit)
 		{
-			// Calculate the four corners of the quad
-			FVector BottomLeft = FVector(Col * QuadSize, Row * QuadSize, 0);
-			FVector BottomRight = FVector((Col + 1) * QuadSize, Row * QuadSize, 0);
-			FVector TopLeft = FVector(Col * QuadSize, (Row + 1) * QuadSize, 0);
-			FVector TopRight = FVector((Col + 1) * QuadSize, (Row + 1) * QuadSize, 0);
-
-			// Create first triangle (Bottom-Left, Top-Left, Bottom-Right)
-			CreateTriangle(Vertices, Triangles, Normals, UVs, 
-						  BottomLeft, TopLeft, BottomRight);
-
-			// Create second triangle (Bottom-Right, Top-Left, Top-Right)
-			CreateTriangle(Vertices, Triangles, Normals, UVs, 
-						  BottomRight, TopLeft, TopRight);
+			LOD++;
+			Limit *= 2.0;
 		}
+		if (LOD >= NumStreamingLODs)
+		{
+			OutTileLODs[TileIndex] = INDEX_NONE;
+			continue;
+		}
+
+		// Tiles cut short by the far edges only get as coarse as their quad counts divide
+		while (LOD > 0 && (Tile.NumRows % (1 << LOD) != 0 || Tile.NumCols % (1 << LOD) != 0))
+		{
+			LOD--;
+		}
+		OutTileLODs[TileIndex] = LOD;
 	}
+}
 
-	// Create the mesh section
-	ProceduralMesh->CreateMeshSection(0, Vertices, Triangles, Normals, UVs, 
-	                                  VertexColors, Tangents, true);
+void AProceduralPlaneActor::UpdateStreaming()
+{
+	// One rebuild in flight at a time: while the focus keeps moving, each new one would cancel the last before it landed.
+	// The next tick catches up with wherever the focus went in the meantime
+	if (!IsStreaming() || IsGenerationPending() || IsCollapsedIntoBatch() || IsUsingBakedStaticMesh())
+	{
+		return;
+	}
 
-	// Apply material if set
-	if (PlaneMaterial)
+	TArray<int32> TileLODs;
+	ComputeStreamedTileLODs(TileLODs);
+	if (TileLODs != StreamedTileLODs)
 	{
-		ProceduralMesh->SetMaterial(0, PlaneMaterial);
+		StreamedTileLODs = MoveTemp(TileLODs);
+		RegenerateMesh();
 	}
+}
 
-	// Enable collision
-	ProceduralMesh->ContainsPhysicsTriMeshData(true);
+FProceduralMeshCapacity AProceduralPlaneActor::ComputeMeshCapacity(const FProceduralPlaneParams& Params)
+{
+	return ProceduralGeometry::ComputePlaneCapacity(Params);
+}
+
+void AProceduralPlaneActor::BuildMesh(const FProceduralPlaneParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
+{
+	FProceduralMeshWriter Writer(Builder, Token);
+	ProceduralGeometry::BuildPlane(Params, Writer);
+}
+
+void AProceduralPlaneActor::BuildTileMesh(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
+{
+	FProceduralMeshWriter Writer(Builder, Token);
+	ProceduralGeometry::BuildPlaneTile(Params, Tile, Writer);
 }
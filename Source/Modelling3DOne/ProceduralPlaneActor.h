@@ -3,29 +3,89 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "ProceduralMeshComponent.h"
+#include "Hash/xxhash.h"
+#include "ProceduralShapeActor.h"
 #include "ProceduralPlaneActor.generated.h"
 
+// Appends the height sources of FProceduralPlaneParams; only those that are set, so flat planes keep their keys
+inline void AppendHeightParams(FProceduralMeshKey& Key, const FProceduralPlaneParams& Params)
+{
+	if (ProceduralGeometry::HasPlaneHeightSamples(Params))
+	{
+		Key.Append(Params.HeightSamplesX);
+		Key.Append(Params.HeightSamplesY);
+		Key.Append(Params.HeightScale);
+		Key.Append(Params.HeightSamplesHashLow);
+		Key.Append(Params.HeightSamplesHashHigh);
+	}
+	if (ProceduralGeometry::HasPlaneNoise(Params))
+	{
+		Key.Append(Params.NoiseAmplitude);
+		Key.Append(Params.NoiseScale);
+		Key.Append(Params.NoiseOctaves);
+		Key.Append(Params.NoiseSeed);
+	}
+}
+
+// Identifies the generated plane mesh; every field of FProceduralPlaneParams must be appended
+inline FProceduralMeshKey MakeMeshKey(const FProceduralPlaneParams& Params)
+{
+	FProceduralMeshKey Key(TEXT("Plane"));
+	Key.Append(Params.Nb_Lignes);
+	Key.Append(Params.Nb_Colones);
+	Key.Append(Params.QuadSize);
+	Key.Append(Params.bUseIndexedGrid);
+	AppendHeightParams(Key, Params);
+	return Key;
+}
+
+// Identifies one tile of a tiled plane. Soup tiles only depend on their own quads, so resizing the grid keeps the
+// tiles it does not cross; indexed tiles take their UVs from the whole grid, and heights are stretched over it
+inline FProceduralMeshKey MakeMeshKey(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile)
+{
+	// An empty tile, e.g. one streamed out, is the same mesh wherever it is
+	FProceduralMeshKey Key(TEXT("PlaneTile"));
+	if (Tile.NumRows <= 0 || Tile.NumCols <= 0)
+	{
+		return Key;
+	}
+
+	Key.Append(Tile.FirstRow);
+	Key.Append(Tile.FirstCol);
+	Key.Append(Tile.NumRows);
+	Key.Append(Tile.NumCols);
+	Key.Append(Params.QuadSize);
+	Key.Append(Params.bUseIndexedGrid);
+	if (Params.bUseIndexedGrid || ProceduralGeometry::HasPlaneHeights(Params))
+	{
+		Key.Append(Params.Nb_Lignes);
+		Key.Append(Params.Nb_Colones);
+	}
+	AppendHeightParams(Key, Params);
+	if (Tile.LOD > 0 || Tile.SkirtDepth > 0.0f)
+	{
+		Key.Append(Tile.LOD);
+		Key.Append(Tile.SkirtDepth);
+	}
+	return Key;
+}
+
+/**
+ * Grid of quads in the XY plane, optionally displaced into terrain by height samples and noise.
+ * A large grid is split into tiles, which can stream around a focus point at several resolutions.
+ */
 UCLASS()
-class MODELLING3DONE_API AProceduralPlaneActor : public AActor
+class MODELLING3DONE_API AProceduralPlaneActor : public AProceduralShapeActor
 {
 	GENERATED_BODY()
 
-public:
-	// Sets default values for this actor's properties
-	AProceduralPlaneActor();
-
 protected:
-	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	virtual void OnConstruction(const FTransform& Transform) override;
 
-
-public:	
-	// The procedural mesh component that will hold our geometry
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
-	UProceduralMeshComponent* ProceduralMesh;
+public:
+	// Besides picking the LOD, re-resolves the streamed tiles around the focus
+	virtual void Tick(float DeltaSeconds) override;
 
 	// Number of rows (lines) in the plane
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Plane Parameters", meta = (ClampMin = "1"))
@@ -39,17 +99,142 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Plane Parameters")
 	float QuadSize = 100.0f;
 
+	// Share one vertex per grid corner (with grid UVs and an up normal) instead of emitting 6 vertices per quad
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Plane Parameters")
+	bool bUseIndexedGrid = false;
+
+	// Quads along each side of the square tiles a larger grid is split into. Every tile is its own section with its own
+	// bounds, built in parallel and only rebuilt when its quads change; a tiled plane has no LOD chain. 0 keeps one section
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Plane Parameters", meta = (ClampMin = "0"))
+	int32 TileSize = 64;
+
 	// Material to apply to the mesh
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Plane Parameters")
 	UMaterialInterface* PlaneMaterial;
 
+	// Heights added to the grid, row-major with HeightSamplesWidth samples per row, stretched so the first and last samples
+	// land on the plane's corners and sampled bilinearly in between. Fill it from a float texture's texels, or call
+	// SetHeightSamples; after changing it directly, regenerate through GeneratePlane
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Height")
+	TArray<float> HeightSamples;
+
+	// Samples per row of HeightSamples
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Height", meta = (ClampMin = "1"))
+	int32 HeightSamplesWidth = 1;
+
+	// Multiplies every height sample
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Height")
+	float HeightScale = 1.0f;
+
+	// Fractal noise added on top of the samples, up to this far up or down. 0 for none
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Height")
+	float NoiseAmplitude = 0.0f;
+
+	// Width of the coarsest noise features; each further octave halves it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Height", meta = (ClampMin = "1"))
+	float NoiseScale = 1000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Height", meta = (ClampMin = "1", ClampMax = "12"))
+	int32 NoiseOctaves = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Height")
+	int32 NoiseSeed = 0;
+
+	// Build only the tiles around the streaming focus, coarser with distance: full detail within StreamingDistance, half the
+	// resolution with each doubling of the distance, and nothing past NumStreamingLODs resolutions. Rebuilds run on background
+	// tasks and only touch the tiles whose resolution changed. Needs a grid larger than TileSize
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	bool bStreamTiles = false;
+
+	// Distance (in the plane's own units) from the focus to a tile's edge within which it has full detail
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "1"))
+	float StreamingDistance = 5000.0f;
+
+	// Resolutions a streamed tile goes through before it is dropped
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "1", ClampMax = "8"))
+	int32 NumStreamingLODs = 4;
+
+	// Depth of the skirts hung below the border of every streamed tile, which hide the cracks between neighbours of
+	// different resolutions. Should exceed the largest height step between two coarse corners
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0"))
+	float SkirtDepth = 100.0f;
+
+	// Replaces the height samples and regenerates
+	UFUNCTION(BlueprintCallable, Category = "Height")
+	void SetHeightSamples(const TArray<float>& Samples, int32 Width);
+
+	// World location the tiles stream around. Without one they follow the first player's camera, or stay around the
+	// middle of the plane when there is none (e.g. in the editor)
+	UFUNCTION(BlueprintCallable, Category = "Streaming")
+	void SetStreamingFocus(FVector WorldLocation);
+
+	UFUNCTION(BlueprintCallable, Category = "Streaming")
+	void ClearStreamingFocus();
+
 	// Function to generate the plane mesh
 	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
 	void GeneratePlane();
 
+	// Snapshot of the shape parameters GeneratePlane builds from, coarsened for the given LOD
+	FProceduralPlaneParams GetMeshParams(int32 LODIndex = 0) const;
+
+	// Quads of one tile; tiles run row-major, TileSize quads wide except along the far edges. A streamed tile also has
+	// its resolution and skirt, and a dropped one is empty
+	FProceduralPlaneTile GetTile(int32 TileIndex) const;
+
+	// Exact vertex and index counts GeneratePlane will emit for the current parameters
+	FProceduralMeshCapacity ComputeMeshCapacity() const { return ComputeMeshCapacity(GetMeshParams()); }
+	static FProceduralMeshCapacity ComputeMeshCapacity(const FProceduralPlaneParams& Params);
+
+	// Fills the builder with the plane mesh; touches no actor state, so it can run off the game thread
+	static void BuildMesh(const FProceduralPlaneParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token);
+
+	// Same, for one tile of the grid
+	static void BuildTileMesh(const FProceduralPlaneParams& Params, const FProceduralPlaneTile& Tile, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token);
+
+protected:
+	virtual FProceduralMeshBuildFunction CreateMeshBuildFunction(int32 LODIndex) const override;
+	virtual FProceduralMeshKey GetMeshKey(int32 LODIndex) const override { return MakeMeshKey(GetMeshParams(LODIndex)); }
+	virtual FString GetTessellationDescription(int32 LODIndex) const override;
+	virtual UMaterialInterface* GetShapeMaterial() const override { return PlaneMaterial; }
+	virtual int32 GetNumTiles() const override;
+	virtual FProceduralMeshKey GetTileKey(int32 TileIndex) const override { return MakeMeshKey(GetMeshParams(), GetTile(TileIndex)); }
+	virtual FProceduralMeshBuildFunction CreateTileBuildFunction(int32 TileIndex) const override;
+	virtual bool ShouldGenerateAsync() const override { return bGenerateAsync || IsStreaming(); }
+	virtual bool NeedsTick() const override { return IsStreaming(); }
+
 private:
-	// Helper function to create a single triangle
-	void CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, 
-					   TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2);
-};
+	// Tiles along each row of the grid
+	int32 GetNumTileColumns() const { return FMath::DivideAndRoundUp(FMath::Max(0, Nb_Colones), FMath::Max(1, TileSize)); }
+
+	// Quads of one tile at full detail
+	FProceduralPlaneTile GetTileRect(int32 TileIndex) const;
+
+	bool IsStreaming() const { return bStreamTiles && GetNumTiles() > 1; }
+
+	// Heights snapshot of the current samples, taking a new one when there is none yet
+	TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> GetHeightSnapshot() const;
+
+	// Takes a new heights snapshot if the samples changed since the last one
+	void RefreshHeightSnapshot();
+
+	// Focus of the streaming in the actor's space
+	FVector GetLocalStreamingFocus() const;
 
+	// Resolution of every tile around the focus; INDEX_NONE drops the tile
+	void ComputeStreamedTileLODs(TArray<int32>& OutTileLODs) const;
+
+	// Re-resolves the streamed tiles and regenerates when any of them changed
+	void UpdateStreaming();
+
+	// Copy of HeightSamples the builds read. Replaced rather than modified, so builds in flight keep the samples they started
+	// from; taken on first use so class defaults and loaded actors have one too
+	mutable TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> HeightSnapshot;
+	mutable FXxHash128 HeightSnapshotHash;
+
+	// Resolution of every tile the last regeneration asked for; see ComputeStreamedTileLODs
+	TArray<int32> StreamedTileLODs;
+
+	FVector StreamingFocus = FVector::ZeroVector;
+	bool bHasStreamingFocus = false;
+};
@@ -0,0 +1,267 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralPrimitiveBatcher.h"
+
+#include "Async/ParallelFor.h"
+#include "Modelling3DOne.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+namespace
+{
+	// Shape actor a part takes its parameters and material from: the placed actor, or else the class defaults
+	const AProceduralShapeActor* GetPartShape(const FProceduralPrimitivePart& Part)
+	{
+		if (IsValid(Part.ShapeActor))
+		{
+			return Part.ShapeActor;
+		}
+		if (Part.ShapeClass && !Part.ShapeClass->HasAnyClassFlags(CLASS_Abstract))
+		{
+			return Part.ShapeClass->GetDefaultObject<AProceduralShapeActor>();
+		}
+		return nullptr;
+	}
+
+	// Writes one part into the vertex and index ranges it claimed in a merged builder, in batcher space
+	void CopyTransformedPart(const FProceduralMeshBuilder& Source, const FTransform& Transform, FProceduralMeshBuilder& Dest, int32 FirstVertex, int32 FirstIndex)
+	{
+		const FTransform3f PartTransform(Transform);
+		const FVector3f Scale = PartTransform.GetScale3D();
+
+		// Normals go through the inverse scale. A mirroring scale turns the binormals around, and the winding with them
+		const FVector3f InverseScale = FTransform3f::GetSafeScaleReciprocal(Scale);
+		const bool bMirrored = Scale.X * Scale.Y * Scale.Z < 0.0f;
+		const float BinormalSign = bMirrored ? -1.0f : 1.0f;
+
+		FVector3f* Positions = Dest.Vertices.GetData() + FirstVertex;
+		FVector3f* Normals = Dest.Normals.GetData() + FirstVertex;
+		FVector4f* Tangents = Dest.Tangents.GetData() + FirstVertex;
+		FVector2f* UVs = Dest.UVs.GetData() + FirstVertex;
+		for (int32 VertexIdx = 0; VertexIdx < Source.GetNumVertices(); VertexIdx++)
+		{
+			const FVector4f& Tangent = Source.Tangents[VertexIdx];
+			Positions[VertexIdx] = PartTransform.TransformPosition(Source.Vertices[VertexIdx]);
+			Normals[VertexIdx] = PartTransform.TransformVectorNoScale(Source.Normals[VertexIdx] * InverseScale).GetSafeNormal();
+			Tangents[VertexIdx] = FVector4f(PartTransform.TransformVector(FVector3f(Tangent.X, Tangent.Y, Tangent.Z)).GetSafeNormal(), Tangent.W * BinormalSign);
+			UVs[VertexIdx] = Source.UVs[VertexIdx];
+		}
+
+		int32* Indices = Dest.Triangles.GetData() + FirstIndex;
+		for (int32 Index = 0; Index < Source.GetNumIndices(); Index += 3)
+		{
+			Indices[Index] = FirstVertex + Source.Triangles[Index];
+			Indices[Index + 1] = FirstVertex + Source.Triangles[bMirrored ? Index + 2 : Index + 1];
+			Indices[Index + 2] = FirstVertex + Source.Triangles[bMirrored ? Index + 1 : Index + 2];
+		}
+	}
+}
+
+// Sets default values
+AProceduralPrimitiveBatcher::AProceduralPrimitiveBatcher()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	ProceduralMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ProceduralMesh"));
+	RootComponent = ProceduralMesh;
+	ProceduralMesh->bUseAsyncCooking = true;
+}
+
+// Called when the game starts or when spawned
+void AProceduralPrimitiveBatcher::BeginPlay()
+{
+	Super::BeginPlay();
+	RegenerateMesh();
+}
+
+void AProceduralPrimitiveBatcher::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	RegenerateMesh();
+}
+
+void AProceduralPrimitiveBatcher::RegenerateMesh()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(AProceduralPrimitiveBatcher::RegenerateMesh);
+
+	// Parts without a usable shape are skipped
+	TArray<const AProceduralShapeActor*> PartShapes;
+	TArray<FCommittedPart> NewParts;
+	for (const FProceduralPrimitivePart& Part : Parts)
+	{
+		if (const AProceduralShapeActor* Shape = GetPartShape(Part))
+		{
+			FCommittedPart& NewPart = NewParts.AddDefaulted_GetRef();
+			NewPart.Key = Shape->GetLODKeys()[0];
+			NewPart.RelativeTransform = Part.RelativeTransform;
+			NewPart.Material = Part.Material ? Part.Material : Shape->GetShapeMaterial();
+			PartShapes.Add(Shape);
+		}
+	}
+
+	// OnConstruction fires on every editor move of the batcher, which changes none of the parts
+	bool bUnchanged = NewParts.Num() > 0 && ProceduralMesh->GetNumSections() > 0 && CollisionMode == CommittedCollisionMode
+		&& NewParts.Num() == CommittedParts.Num();
+	for (int32 PartIndex = 0; bUnchanged && PartIndex < NewParts.Num(); PartIndex++)
+	{
+		const FCommittedPart& NewPart = NewParts[PartIndex];
+		const FCommittedPart& CommittedPart = CommittedParts[PartIndex];
+		bUnchanged = NewPart.Key == CommittedPart.Key && NewPart.Material == CommittedPart.Material
+			&& NewPart.RelativeTransform.Equals(CommittedPart.RelativeTransform, 0.0);
+	}
+	if (bUnchanged)
+	{
+		return;
+	}
+
+	// Each distinct shape is looked up or built once. Its prebuilt mesh and build function come from the actor here on
+	// the game thread; the workers only search the caches and run the builds, which touch no actor
+	TMap<FProceduralMeshKey, int32> MeshIndices;
+	TArray<int32> PartMeshIndices;
+	TArray<FProceduralMeshRequest> MeshRequests;
+	for (int32 PartIndex = 0; PartIndex < NewParts.Num(); PartIndex++)
+	{
+		int32& MeshIndex = MeshIndices.FindOrAdd(NewParts[PartIndex].Key, INDEX_NONE);
+		if (MeshIndex == INDEX_NONE)
+		{
+			MeshIndex = MeshRequests.Add(PartShapes[PartIndex]->MakeMeshRequest(0, /*bTiled=*/false));
+		}
+		PartMeshIndices.Add(MeshIndex);
+	}
+	TArray<FProceduralMeshDataPtr> Meshes;
+	Meshes.SetNum(MeshRequests.Num());
+	ParallelFor(MeshRequests.Num(), [&](int32 MeshIndex)
+	{
+		Meshes[MeshIndex] = AProceduralShapeActor::FindOrBuildMesh(MeshRequests[MeshIndex]);
+	});
+
+	// One section per material, in the order the materials first appear; every part claims its range up front
+	TArray<UMaterialInterface*> SectionMaterials;
+	TArray<int32> PartSections;
+	TArray<FProceduralMeshCapacity> SectionCapacities;
+	for (int32 PartIndex = 0; PartIndex < NewParts.Num(); PartIndex++)
+	{
+		const int32 SectionIndex = SectionMaterials.AddUnique(NewParts[PartIndex].Material);
+		SectionCapacities.SetNum(SectionMaterials.Num());
+		const FProceduralMeshBuilder& Mesh = *Meshes[PartMeshIndices[PartIndex]];
+		SectionCapacities[SectionIndex].NumVertices += Mesh.GetNumVertices();
+		SectionCapacities[SectionIndex].NumIndices += Mesh.GetNumIndices();
+		PartSections.Add(SectionIndex);
+	}
+	TArray<TUniquePtr<FProceduralMeshBuilder>> Sections;
+	for (const FProceduralMeshCapacity& Capacity : SectionCapacities)
+	{
+		Sections.Add_GetRef(MakeUnique<FProceduralMeshBuilder>())->Reset(Capacity);
+	}
+	TArray<int32> PartFirstVertices;
+	TArray<int32> PartFirstIndices;
+	for (int32 PartIndex = 0; PartIndex < NewParts.Num(); PartIndex++)
+	{
+		const FProceduralMeshBuilder& Mesh = *Meshes[PartMeshIndices[PartIndex]];
+		FProceduralMeshBuilder& Section = *Sections[PartSections[PartIndex]];
+		PartFirstVertices.Add(Section.AddUninitializedVertices(Mesh.GetNumVertices()));
+		PartFirstIndices.Add(Section.AddUninitializedIndices(Mesh.GetNumIndices()));
+	}
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(ProceduralPrimitiveBatcher_Merge);
+		ParallelFor(NewParts.Num(), [&](int32 PartIndex)
+		{
+			CopyTransformedPart(*Meshes[PartMeshIndices[PartIndex]], NewParts[PartIndex].RelativeTransform, *Sections[PartSections[PartIndex]],
+				PartFirstVertices[PartIndex], PartFirstIndices[PartIndex]);
+		});
+	}
+
+	// Simple collision needs hulls from every part; one part without them keeps the whole prop on its triangle mesh
+	TArray<TArray<FVector>> ConvexHulls;
+	bool bSimpleCollision = CollisionMode == EProceduralCollisionMode::Simple && NewParts.Num() > 0;
+	for (int32 PartIndex = 0; bSimpleCollision && PartIndex < NewParts.Num(); PartIndex++)
+	{
+		TArray<TArray<FVector>> PartHulls;
+		bSimpleCollision = PartShapes[PartIndex]->GetSimpleCollisionHulls(PartHulls) && PartHulls.Num() > 0;
+		for (TArray<FVector>& Hull : PartHulls)
+		{
+			for (FVector& Point : Hull)
+			{
+				Point = NewParts[PartIndex].RelativeTransform.TransformPosition(Point);
+			}
+			ConvexHulls.Add(MoveTemp(Hull));
+		}
+	}
+	if (!bSimpleCollision)
+	{
+		ConvexHulls.Reset();
+	}
+	const bool bTriangleCollision = CollisionMode != EProceduralCollisionMode::None && !bSimpleCollision;
+
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(ProceduralPrimitiveBatcher_Upload);
+		ProceduralMesh->ClearAllMeshSections();
+
+		// Every section upload refreshes the body setup, so stale hulls are dropped before them rather than after
+		if (bHasConvexCollision && !bSimpleCollision)
+		{
+			ProceduralMesh->ClearCollisionConvexMeshes();
+			bHasConvexCollision = false;
+		}
+		ProceduralMesh->bUseComplexAsSimpleCollision = bTriangleCollision;
+		for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); SectionIndex++)
+		{
+			Sections[SectionIndex]->Finalize();
+			Sections[SectionIndex]->CreateMeshSection(ProceduralMesh, SectionIndex, bTriangleCollision);
+			if (SectionMaterials[SectionIndex])
+			{
+				ProceduralMesh->SetMaterial(SectionIndex, SectionMaterials[SectionIndex]);
+			}
+		}
+		if (bSimpleCollision)
+		{
+			ProceduralMesh->SetCollisionConvexMeshes(ConvexHulls);
+			bHasConvexCollision = true;
+		}
+	}
+
+	CommittedParts = MoveTemp(NewParts);
+	CommittedCollisionMode = CollisionMode;
+	UE_LOG(LogProceduralMesh, Verbose, TEXT("%s: merged %d parts (%d distinct meshes) into %d sections"),
+		*GetName(), CommittedParts.Num(), MeshRequests.Num(), Sections.Num());
+}
+
+void AProceduralPrimitiveBatcher::CollapseAttachedShapes()
+{
+	Modify();
+
+	TArray<AActor*> AttachedActors;
+	GetAttachedActors(AttachedActors, /*bResetArray=*/true, /*bRecursivelyIncludeAttachedActors=*/true);
+	for (AActor* AttachedActor : AttachedActors)
+	{
+		AProceduralShapeActor* ShapeActor = Cast<AProceduralShapeActor>(AttachedActor);
+		if (!ShapeActor || ShapeActor->IsCollapsedIntoBatch())
+		{
+			continue;
+		}
+
+		FProceduralPrimitivePart& Part = Parts.AddDefaulted_GetRef();
+		Part.ShapeActor = ShapeActor;
+		Part.RelativeTransform = ShapeActor->GetActorTransform().GetRelativeTransform(GetActorTransform());
+		ShapeActor->Modify();
+		ShapeActor->SetCollapsedIntoBatch(true);
+	}
+	RegenerateMesh();
+}
+
+void AProceduralPrimitiveBatcher::ExpandCollapsedShapes()
+{
+	Modify();
+
+	for (int32 PartIndex = Parts.Num() - 1; PartIndex >= 0; PartIndex--)
+	{
+		AProceduralShapeActor* ShapeActor = Parts[PartIndex].ShapeActor;
+		if (IsValid(ShapeActor) && ShapeActor->IsCollapsedIntoBatch())
+		{
+			ShapeActor->Modify();
+			ShapeActor->SetCollapsedIntoBatch(false);
+			Parts.RemoveAt(PartIndex);
+		}
+	}
+	RegenerateMesh();
+}
@@ -0,0 +1,101 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ProceduralShapeActor.h"
+#include "ProceduralPrimitiveBatcher.generated.h"
+
+/**
+ * One primitive of a composed prop: a shape and where it sits in the batcher.
+ */
+USTRUCT(BlueprintType)
+struct MODELLING3DONE_API FProceduralPrimitivePart
+{
+	GENERATED_BODY()
+
+	// Shape generated for this part from its class defaults, so Blueprint subclasses of the shape actors act as presets
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Part")
+	TSubclassOf<AProceduralShapeActor> ShapeClass;
+
+	// Placed shape actor whose parameters are used instead of ShapeClass, e.g. one taken in by CollapseAttachedShapes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Part")
+	AProceduralShapeActor* ShapeActor = nullptr;
+
+	// Placement relative to the batcher
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Part")
+	FTransform RelativeTransform;
+
+	// Replaces the shape's own material; parts with the same material end up in the same section
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Part")
+	UMaterialInterface* Material = nullptr;
+};
+
+/**
+ * Merges many procedural primitives into a single mesh component.
+ * Every part's full-detail mesh comes from the shared cache or is built in parallel, then the parts are
+ * transformed into one section per material. Collision is one body for the whole prop: all sections as a
+ * triangle mesh, or every part's hulls together. One draw call per material and one component replace
+ * a component, section and body per part.
+ */
+UCLASS()
+class MODELLING3DONE_API AProceduralPrimitiveBatcher : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AProceduralPrimitiveBatcher();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+public:
+	// The component holding the merged sections
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
+	UProceduralMeshComponent* ProceduralMesh;
+
+	// Primitives merged into the mesh
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Generation")
+	TArray<FProceduralPrimitivePart> Parts;
+
+	// Collision of the merged mesh. Simple combines the hulls of every part; as soon as one part has no hulls (a sphere
+	// colliding as its analytic primitive, or a plane) the whole prop keeps the triangle mesh instead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Collision")
+	EProceduralCollisionMode CollisionMode = EProceduralCollisionMode::TriangleMesh;
+
+	// Rebuilds the merged sections from the parts; skipped when no part, placement or material changed
+	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
+	void RegenerateMesh();
+
+	// Turns every shape actor attached to this one (recursively) into a part. The actors stay in the level as
+	// the parts' parameters, but drop their own sections, collision and tick
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Mesh Generation")
+	void CollapseAttachedShapes();
+
+	// Gives the parts collapsed from placed actors back to those actors and removes them from Parts
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Mesh Generation")
+	void ExpandCollapsedShapes();
+
+	UFUNCTION(BlueprintPure, Category = "Mesh Generation")
+	int32 GetNumSections() const { return ProceduralMesh->GetNumSections(); }
+
+private:
+	// What a part contributed to the committed mesh, to tell whether a rebuild would change anything
+	struct FCommittedPart
+	{
+		FProceduralMeshKey Key;
+		FTransform RelativeTransform;
+		UMaterialInterface* Material = nullptr;
+	};
+
+	TArray<FCommittedPart> CommittedParts;
+	EProceduralCollisionMode CommittedCollisionMode = EProceduralCollisionMode::TriangleMesh;
+
+	// The mesh component holds the parts' hulls from Simple collision; saved with them
+	UPROPERTY()
+	bool bHasConvexCollision = false;
+};
@@ -0,0 +1,276 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralRingKernel.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Modelling3DOne.h"
+
+// SSE2 is part of every x64 target; AVX2 is compiled per function and only called after the CPU check
+#define PROCEDURAL_RING_SIMD PLATFORM_CPU_X86_FAMILY
+
+#if PROCEDURAL_RING_SIMD
+#include <immintrin.h>
+
+#if defined(__clang__) || defined(__GNUC__)
+#define PROCEDURAL_AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define PROCEDURAL_AVX2_FUNCTION
+#endif
+#endif
+
+// The SIMD paths store straight into the builder's single precision layout
+static_assert(sizeof(FVector3f) == 3 * sizeof(float), "Ring kernels expect a packed FVector3f");
+static_assert(sizeof(FVector4f) == 4 * sizeof(float), "Ring kernels expect a packed FVector4f");
+static_assert(sizeof(FVector2f) == 2 * sizeof(float), "Ring kernels expect a packed FVector2f");
+
+namespace
+{
+	void EmitRingScalar(const FProceduralRingParams& Params, const float* RingSin, const float* RingCos, int32 FirstMeridian, int32 Count,
+		FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+	{
+		const float BinormalSign = Params.bFlipTangentY ? -1.0f : 1.0f;
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			int32 MeridianIdx = FirstMeridian + Index;
+			float CosPhi = RingCos[MeridianIdx];
+			float SinPhi = RingSin[MeridianIdx];
+
+			OutPositions[Index] = FVector3f(Params.PositionScale * CosPhi, Params.PositionScale * SinPhi, Params.PositionZ);
+			OutNormals[Index] = FVector3f(Params.NormalScale * CosPhi, Params.NormalScale * SinPhi, Params.NormalZ);
+			OutTangents[Index] = FVector4f(-Params.TangentScale * SinPhi, Params.TangentScale * CosPhi, 0.0f, BinormalSign);
+			OutUVs[Index] = FVector2f(float(MeridianIdx) / float(Params.NumMeridians), Params.V);
+		}
+	}
+
+#if PROCEDURAL_RING_SIMD
+	// Interleaves four vertices held as X and Y lanes plus a shared Z into x0 y0 z x1 | y1 z x2 y2 | z x3 y3 z
+	FORCEINLINE void StoreVectors4(FVector3f* Out, __m128 X, __m128 Y, __m128 Z)
+	{
+		float* Dest = reinterpret_cast<float*>(Out);
+		const __m128 XYLow = _mm_unpacklo_ps(X, Y);
+		const __m128 XYHigh = _mm_unpackhi_ps(X, Y);
+		_mm_storeu_ps(Dest + 0, _mm_shuffle_ps(XYLow, _mm_shuffle_ps(Z, XYLow, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storeu_ps(Dest + 4, _mm_shuffle_ps(_mm_shuffle_ps(XYLow, Z, _MM_SHUFFLE(0, 0, 3, 3)), XYHigh, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(Dest + 8, _mm_shuffle_ps(_mm_shuffle_ps(Z, XYHigh, _MM_SHUFFLE(2, 2, 0, 0)), _mm_shuffle_ps(XYHigh, Z, _MM_SHUFFLE(0, 0, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+
+	FORCEINLINE void StoreUVs4(FVector2f* Out, __m128 U, __m128 V)
+	{
+		float* Dest = reinterpret_cast<float*>(Out);
+		_mm_storeu_ps(Dest + 0, _mm_unpacklo_ps(U, V));
+		_mm_storeu_ps(Dest + 4, _mm_unpackhi_ps(U, V));
+	}
+
+	// ZSign holds Z = 0 and the binormal sign in both of its halves
+	FORCEINLINE void StoreTangents4(FVector4f* Out, __m128 X, __m128 Y, __m128 ZSign)
+	{
+		float* Dest = reinterpret_cast<float*>(Out);
+		const __m128 XYLow = _mm_unpacklo_ps(X, Y);
+		const __m128 XYHigh = _mm_unpackhi_ps(X, Y);
+		_mm_storeu_ps(Dest + 0, _mm_movelh_ps(XYLow, ZSign));
+		_mm_storeu_ps(Dest + 4, _mm_movehl_ps(ZSign, XYLow));
+		_mm_storeu_ps(Dest + 8, _mm_movelh_ps(XYHigh, ZSign));
+		_mm_storeu_ps(Dest + 12, _mm_movehl_ps(ZSign, XYHigh));
+	}
+
+	FORCEINLINE __m128 MakeTangentZSign(const FProceduralRingParams& Params)
+	{
+		const float BinormalSign = Params.bFlipTangentY ? -1.0f : 1.0f;
+		return _mm_setr_ps(0.0f, BinormalSign, 0.0f, BinormalSign);
+	}
+
+	void EmitRingSSE(const FProceduralRingParams& Params, const float* RingSin, const float* RingCos, int32 FirstMeridian, int32 Count,
+		FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+	{
+		const __m128 PositionScale = _mm_set1_ps(Params.PositionScale);
+		const __m128 NormalScale = _mm_set1_ps(Params.NormalScale);
+		const __m128 TangentScale = _mm_set1_ps(Params.TangentScale);
+		const __m128 NegativeTangentScale = _mm_set1_ps(-Params.TangentScale);
+		const __m128 TangentZSign = MakeTangentZSign(Params);
+		const __m128 NumMeridians = _mm_set1_ps(float(Params.NumMeridians));
+		const __m128 PositionZ = _mm_set1_ps(Params.PositionZ);
+		const __m128 NormalZ = _mm_set1_ps(Params.NormalZ);
+		const __m128 V = _mm_set1_ps(Params.V);
+		__m128i Meridian = _mm_add_epi32(_mm_set1_epi32(FirstMeridian), _mm_setr_epi32(0, 1, 2, 3));
+
+		int32 Index = 0;
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			__m128 CosPhi = _mm_loadu_ps(RingCos + FirstMeridian + Index);
+			__m128 SinPhi = _mm_loadu_ps(RingSin + FirstMeridian + Index);
+
+			StoreVectors4(OutPositions + Index, _mm_mul_ps(PositionScale, CosPhi), _mm_mul_ps(PositionScale, SinPhi), PositionZ);
+			StoreVectors4(OutNormals + Index, _mm_mul_ps(NormalScale, CosPhi), _mm_mul_ps(NormalScale, SinPhi), NormalZ);
+			StoreTangents4(OutTangents + Index, _mm_mul_ps(NegativeTangentScale, SinPhi), _mm_mul_ps(TangentScale, CosPhi), TangentZSign);
+			StoreUVs4(OutUVs + Index, _mm_div_ps(_mm_cvtepi32_ps(Meridian), NumMeridians), V);
+
+			Meridian = _mm_add_epi32(Meridian, _mm_set1_epi32(4));
+		}
+
+		EmitRingScalar(Params, RingSin, RingCos, FirstMeridian + Index, Count - Index,
+			OutPositions + Index, OutNormals + Index, OutTangents + Index, OutUVs + Index);
+	}
+
+	PROCEDURAL_AVX2_FUNCTION void EmitRingAVX2(const FProceduralRingParams& Params, const float* RingSin, const float* RingCos, int32 FirstMeridian, int32 Count,
+		FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+	{
+		const __m256 PositionScale = _mm256_set1_ps(Params.PositionScale);
+		const __m256 NormalScale = _mm256_set1_ps(Params.NormalScale);
+		const __m256 TangentScale = _mm256_set1_ps(Params.TangentScale);
+		const __m256 NegativeTangentScale = _mm256_set1_ps(-Params.TangentScale);
+		const __m128 TangentZSign = MakeTangentZSign(Params);
+		const __m256 NumMeridians = _mm256_set1_ps(float(Params.NumMeridians));
+		const __m128 PositionZ = _mm_set1_ps(Params.PositionZ);
+		const __m128 NormalZ = _mm_set1_ps(Params.NormalZ);
+		const __m128 V = _mm_set1_ps(Params.V);
+		__m256i Meridian = _mm256_add_epi32(_mm256_set1_epi32(FirstMeridian), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+		int32 Index = 0;
+		for (; Index + 8 <= Count; Index += 8)
+		{
+			__m256 CosPhi = _mm256_loadu_ps(RingCos + FirstMeridian + Index);
+			__m256 SinPhi = _mm256_loadu_ps(RingSin + FirstMeridian + Index);
+			__m256 PositionX = _mm256_mul_ps(PositionScale, CosPhi);
+			__m256 PositionY = _mm256_mul_ps(PositionScale, SinPhi);
+			__m256 NormalX = _mm256_mul_ps(NormalScale, CosPhi);
+			__m256 NormalY = _mm256_mul_ps(NormalScale, SinPhi);
+			__m256 TangentX = _mm256_mul_ps(NegativeTangentScale, SinPhi);
+			__m256 TangentY = _mm256_mul_ps(TangentScale, CosPhi);
+			__m256 U = _mm256_div_ps(_mm256_cvtepi32_ps(Meridian), NumMeridians);
+
+			// The interleaving shuffles stay within 128-bit lanes, so the stores go out four vertices at a time
+			StoreVectors4(OutPositions + Index, _mm256_castps256_ps128(PositionX), _mm256_castps256_ps128(PositionY), PositionZ);
+			StoreVectors4(OutPositions + Index + 4, _mm256_extractf128_ps(PositionX, 1), _mm256_extractf128_ps(PositionY, 1), PositionZ);
+			StoreVectors4(OutNormals + Index, _mm256_castps256_ps128(NormalX), _mm256_castps256_ps128(NormalY), NormalZ);
+			StoreVectors4(OutNormals + Index + 4, _mm256_extractf128_ps(NormalX, 1), _mm256_extractf128_ps(NormalY, 1), NormalZ);
+			StoreTangents4(OutTangents + Index, _mm256_castps256_ps128(TangentX), _mm256_castps256_ps128(TangentY), TangentZSign);
+			StoreTangents4(OutTangents + Index + 4, _mm256_extractf128_ps(TangentX, 1), _mm256_extractf128_ps(TangentY, 1), TangentZSign);
+			StoreUVs4(OutUVs + Index, _mm256_castps256_ps128(U), V);
+			StoreUVs4(OutUVs + Index + 4, _mm256_extractf128_ps(U, 1), V);
+
+			Meridian = _mm256_add_epi32(Meridian, _mm256_set1_epi32(8));
+		}
+		_mm256_zeroupper();
+
+		EmitRingSSE(Params, RingSin, RingCos, FirstMeridian + Index, Count - Index,
+			OutPositions + Index, OutNormals + Index, OutTangents + Index, OutUVs + Index);
+	}
+#endif
+
+	void RunRingKernelBenchmark(const TArray<FString>& Args)
+	{
+		const int32 Meridians = FMath::Max(3, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 512);
+		const int32 Parallels = FMath::Max(3, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 512);
+		const int32 Iterations = FMath::Max(1, Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 20);
+
+		FProceduralRingTableRef Ring = FProceduralRingTable::Get(Meridians);
+		const int32 NumVertices = Meridians * (Parallels - 1);
+
+		TArray<FVector3f> ReferencePositions, Positions, Normals;
+		TArray<FVector2f> UVs;
+		TArray<FVector4f> Tangents;
+		ReferencePositions.SetNumUninitialized(NumVertices);
+		Positions.SetNumUninitialized(NumVertices);
+		Normals.SetNumUninitialized(NumVertices);
+		Tangents.SetNumUninitialized(NumVertices);
+		UVs.SetNumUninitialized(NumVertices);
+
+		auto EmitSphere = [&](EProceduralRingKernel Kernel, TArray<FVector3f>& OutPositions)
+		{
+			for (int32 ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+			{
+				float Theta = PI * float(ParallelIdx) / float(Parallels);
+				FProceduralRingParams Params;
+				Params.PositionScale = 100.0f * FMath::Sin(Theta);
+				Params.PositionZ = 100.0f * FMath::Cos(Theta);
+				Params.NormalScale = FMath::Sin(Theta);
+				Params.NormalZ = FMath::Cos(Theta);
+				Params.V = float(ParallelIdx) / float(Parallels);
+				Params.NumMeridians = Meridians;
+				Params.TangentScale = 1.0f;
+				Params.bFlipTangentY = true;
+
+				int32 First = (ParallelIdx - 1) * Meridians;
+				FProceduralRingKernel::EmitRing(Kernel, Params, Ring->GetView(), 0, Meridians,
+					OutPositions.GetData() + First, Normals.GetData() + First, Tangents.GetData() + First, UVs.GetData() + First);
+			}
+		};
+
+		EmitSphere(EProceduralRingKernel::Scalar, ReferencePositions);
+
+		UE_LOG(LogProceduralMesh, Log, TEXT("Ring kernel benchmark: %d meridians x %d parallels, %d iterations, best kernel %s"),
+			Meridians, Parallels, Iterations, FProceduralRingKernel::GetKernelName(FProceduralRingKernel::GetBestKernel()));
+
+		for (EProceduralRingKernel Kernel : { EProceduralRingKernel::Scalar, EProceduralRingKernel::SSE, EProceduralRingKernel::AVX2 })
+		{
+			if (Kernel > FProceduralRingKernel::GetBestKernel())
+			{
+				continue;
+			}
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				EmitSphere(Kernel, Positions);
+			}
+			const double Seconds = (FPlatformTime::Seconds() - StartTime) / Iterations;
+
+			const bool bMatches = FMemory::Memcmp(Positions.GetData(), ReferencePositions.GetData(), NumVertices * sizeof(FVector3f)) == 0;
+			UE_LOG(LogProceduralMesh, Log, TEXT("  %-6s %8.3f ms  %8.1f Mverts/s%s"), FProceduralRingKernel::GetKernelName(Kernel),
+				Seconds * 1000.0, NumVertices / Seconds / 1.0e6, bMatches ? TEXT("") : TEXT("  MISMATCH vs scalar"));
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdProceduralRingKernelBench(
+	TEXT("ProceduralMesh.RingKernelBench"),
+	TEXT("Times the scalar and SIMD sphere ring kernels. Args: [Meridians=512] [Parallels=512] [Iterations=20]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunRingKernelBenchmark));
+
+EProceduralRingKernel FProceduralRingKernel::GetBestKernel()
+{
+#if PROCEDURAL_RING_SIMD
+	static const EProceduralRingKernel BestKernel = FPlatformMisc::HasAVX2InstructionSupport() ? EProceduralRingKernel::AVX2 : EProceduralRingKernel::SSE;
+	return BestKernel;
+#else
+	return EProceduralRingKernel::Scalar;
+#endif
+}
+
+const TCHAR* FProceduralRingKernel::GetKernelName(EProceduralRingKernel Kernel)
+{
+	switch (Kernel)
+	{
+	case EProceduralRingKernel::SSE:
+		return TEXT("SSE");
+	case EProceduralRingKernel::AVX2:
+		return TEXT("AVX2");
+	default:
+		return TEXT("Scalar");
+	}
+}
+
+void FProceduralRingKernel::EmitRing(EProceduralRingKernel Kernel, const FProceduralRingParams& Params, const ProceduralGeometry::FRingView& Ring,
+	int32 FirstMeridian, int32 Count, FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+{
+	checkSlow(FirstMeridian >= 0 && FirstMeridian + Count <= Ring.NumSegments);
+	const float* RingSin = Ring.Sin;
+	const float* RingCos = Ring.Cos;
+
+#if PROCEDURAL_RING_SIMD
+	if (Kernel == EProceduralRingKernel::AVX2 && GetBestKernel() == EProceduralRingKernel::AVX2)
+	{
+		EmitRingAVX2(Params, RingSin, RingCos, FirstMeridian, Count, OutPositions, OutNormals, OutTangents, OutUVs);
+		return;
+	}
+	if (Kernel != EProceduralRingKernel::Scalar)
+	{
+		EmitRingSSE(Params, RingSin, RingCos, FirstMeridian, Count, OutPositions, OutNormals, OutTangents, OutUVs);
+		return;
+	}
+#endif
+
+	EmitRingScalar(Params, RingSin, RingCos, FirstMeridian, Count, OutPositions, OutNormals, OutTangents, OutUVs);
+}
@@ -0,0 +1,39 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralGeometryKernel.h"
+#include "ProceduralRingTable.h"
+
+enum class EProceduralRingKernel : uint8
+{
+	Scalar,
+	SSE,
+	AVX2,
+};
+
+/**
+ * Emits ring vertices straight into the builder arrays.
+ * The SIMD paths process 4 (SSE) or 8 (AVX2) meridians per iteration from the structure-of-arrays
+ * sin/cos table and are bit-identical to the scalar path, which is ProceduralGeometry::EmitRing narrowed to float.
+ * The best path is picked once from the CPU features.
+ */
+struct MODELLING3DONE_API FProceduralRingKernel
+{
+	// Fastest kernel this CPU supports
+	static EProceduralRingKernel GetBestKernel();
+
+	static const TCHAR* GetKernelName(EProceduralRingKernel Kernel);
+
+	// Writes meridians [FirstMeridian, FirstMeridian + Count) of the ring to the output arrays
+	static void EmitRing(const FProceduralRingParams& Params, const ProceduralGeometry::FRingView& Ring, int32 FirstMeridian, int32 Count,
+		FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs)
+	{
+		EmitRing(GetBestKernel(), Params, Ring, FirstMeridian, Count, OutPositions, OutNormals, OutTangents, OutUVs);
+	}
+
+	// Same, forcing a kernel; a kernel the CPU lacks falls back to the best supported one
+	static void EmitRing(EProceduralRingKernel Kernel, const FProceduralRingParams& Params, const ProceduralGeometry::FRingView& Ring,
+		int32 FirstMeridian, int32 Count, FVector3f* OutPositions, FVector3f* OutNormals, FVector4f* OutTangents, FVector2f* OutUVs);
+};
@@ -0,0 +1,33 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralRingTable.h"
+
+
+FProceduralRingTableRef FProceduralRingTable::Get(int32 NumSegments, float Phase)
+{
+	check(NumSegments > 0);
+
+	// Keyed on the exact phase bits; a table is a few KB at most, so they are kept for the whole session
+	static FCriticalSection Lock;
+	static TMap<uint64, FProceduralRingTableRef> Tables;
+	uint32 PhaseBits;
+	FMemory::Memcpy(&PhaseBits, &Phase, sizeof(PhaseBits));
+	const uint64 Key = (uint64(uint32(NumSegments)) << 32) | uint64(PhaseBits);
+
+	FScopeLock ScopeLock(&Lock);
+	if (const FProceduralRingTableRef* Existing = Tables.Find(Key))
+	{
+		return *Existing;
+	}
+
+	TSharedRef<FProceduralRingTable, ESPMode::ThreadSafe> Table = MakeShared<FProceduralRingTable, ESPMode::ThreadSafe>();
+	Table->NumSegments = NumSegments;
+	Table->Phase = Phase;
+	Table->Sin.SetNumUninitialized(NumSegments);
+	Table->Cos.SetNumUninitialized(NumSegments);
+	ProceduralGeometry::FillRing(NumSegments, Phase, Table->Sin.GetData(), Table->Cos.GetData());
+
+	Tables.Add(Key, Table);
+	return Table;
+}
@@ -0,0 +1,33 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralGeometryKernel.h"
+
+/**
+ * Sine and cosine of the NumSegments evenly spaced angles around a ring, starting at Phase.
+ * Tables are immutable and cached per (segment count, phase), so the ring-based generators
+ * share them across shapes, parallels and caps instead of calling Sin/Cos per vertex.
+ */
+struct MODELLING3DONE_API FProceduralRingTable
+{
+	int32 NumSegments = 0;
+	float Phase = 0.0f;
+	TArray<float> Sin;
+	TArray<float> Cos;
+
+	// Angle of one segment. Same float expression the generators used before the tables, so results are bit-identical
+	static FORCEINLINE float GetAngle(int32 SegmentIdx, int32 NumSegments, float Phase = 0.0f)
+	{
+		return ProceduralGeometry::GetRingAngle(SegmentIdx, NumSegments, Phase);
+	}
+
+	// The table as the engine-free generators read it; valid while this table is referenced
+	ProceduralGeometry::FRingView GetView() const { return ProceduralGeometry::FRingView{ Sin.GetData(), Cos.GetData(), NumSegments }; }
+
+	// Returns the shared table for this ring, building it on first use; safe to call from any thread
+	static TSharedRef<const FProceduralRingTable, ESPMode::ThreadSafe> Get(int32 NumSegments, float Phase = 0.0f);
+};
+
+using FProceduralRingTableRef = TSharedRef<const FProceduralRingTable, ESPMode::ThreadSafe>;
@@ -0,0 +1,962 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralShapeActor.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Kismet/GameplayStatics.h"
+#include "Modelling3DOne.h"
+#include "ProceduralGeometryStats.h"
+#include "ProceduralMeshDiskCache.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Serialization/CustomVersion.h"
+#include "Tasks/Task.h"
+#include "UObject/ObjectSaveContext.h"
+
+#if WITH_EDITOR
+#include "MeshDescription.h"
+#include "PhysicsEngine/BodySetup.h"
+#endif
+
+
+// Versions of the data AProceduralShapeActor::Serialize adds after the actor's properties
+struct FProceduralShapeCustomVersion
+{
+	enum Type
+	{
+		BeforeCustomVersionWasAdded = 0,
+		SavedGeneratedMesh,
+		BakedStaticMesh,
+		SavedTangents,
+		PackedVertices,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	static const FGuid GUID;
+};
+
+const FGuid FProceduralShapeCustomVersion::GUID(0x5C1A7E32, 0x4B8D4F06, 0x9E2D61A4, 0x0F73B9C8);
+static FCustomVersionRegistration GRegisterProceduralShapeCustomVersion(FProceduralShapeCustomVersion::GUID,
+	FProceduralShapeCustomVersion::LatestVersion, TEXT("ProceduralShapeVer"));
+
+namespace
+{
+	// The optional pass after a build; the log gives the cache efficiency it bought
+	void OptimizeIndexOrder(FProceduralMeshBuilder& Builder, const FProceduralMeshKey& Key, int32 SectionIndex)
+	{
+		const ProceduralGeometry::FIndexOrderStats Stats = Builder.OptimizeIndexOrder();
+		UE_LOG(LogProceduralMesh, Verbose, TEXT("%s section %d: %d triangles reordered, ACMR %.3f -> %.3f"),
+			*Key.ShapeType.ToString(), SectionIndex, Builder.GetNumIndices() / 3, Stats.ACMRBefore, Stats.ACMRAfter);
+	}
+}
+
+#if WITH_EDITOR
+namespace
+{
+	// Actors of one package that would bake the same static mesh share it
+	struct FBakedMeshKey
+	{
+		TArray<FProceduralMeshKey> LODKeys;
+		UMaterialInterface* Material = nullptr;
+		float LODScreenSizeStep = 0.0f;
+		EProceduralCollisionMode CollisionMode = EProceduralCollisionMode::TriangleMesh;
+		UPackage* Package = nullptr;
+
+		bool operator==(const FBakedMeshKey& Other) const
+		{
+			return Package == Other.Package && Material == Other.Material && LODScreenSizeStep == Other.LODScreenSizeStep
+				&& CollisionMode == Other.CollisionMode && LODKeys == Other.LODKeys;
+		}
+
+		friend uint32 GetTypeHash(const FBakedMeshKey& Key)
+		{
+			uint32 Hash = HashCombineFast(GetTypeHash(Key.Package), GetTypeHash(Key.Material));
+			for (const FProceduralMeshKey& LODKey : Key.LODKeys)
+			{
+				Hash = HashCombineFast(Hash, GetTypeHash(LODKey));
+			}
+			return Hash;
+		}
+	};
+
+	// Static meshes baked for the packages being cooked. The actors that use a mesh hold it, and a package's entries
+	// are dropped once the cooker is done with it, so nothing outlives the package's cook
+	TMap<FBakedMeshKey, TWeakObjectPtr<UStaticMesh>> GBakedMeshes;
+}
+#endif
+
+
+// Sets default values
+AProceduralShapeActor::AProceduralShapeActor()
+{
+	// Tick only drives LOD selection, so it starts off and is enabled once a mesh has more than one LOD
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickInterval = 0.1f;
+	
+	// Create the procedural mesh component
+	ProceduralMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ProceduralMesh"));
+	RootComponent = ProceduralMesh;
+	
+	// Enable collision
+	ProceduralMesh->bUseAsyncCooking = true;
+}
+
+// Called when the game starts or when spawned
+void AProceduralShapeActor::BeginPlay()
+{
+	Super::BeginPlay();
+	RegenerateMesh();
+}
+
+void AProceduralShapeActor::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	RegenerateMesh();
+}
+
+void AProceduralShapeActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelPendingGeneration();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AProceduralShapeActor::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	SetVisibleLOD(ComputeTargetLOD());
+}
+
+void AProceduralShapeActor::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	// Undo history and reference gathering have no use for the arrays
+	if (Ar.IsTransacting() || Ar.IsObjectReferenceCollector())
+	{
+		return;
+	}
+	Ar.UsingCustomVersion(FProceduralShapeCustomVersion::GUID);
+	if (Ar.CustomVer(FProceduralShapeCustomVersion::GUID) < FProceduralShapeCustomVersion::SavedGeneratedMesh)
+	{
+		return;
+	}
+
+	// Parameters the cooked static mesh was baked from
+	if (Ar.CustomVer(FProceduralShapeCustomVersion::GUID) >= FProceduralShapeCustomVersion::BakedStaticMesh)
+	{
+		Ar << BakedKeys;
+	}
+
+	// Only a mesh that still matches the parameters is worth saving: the committed one, or else the one loaded with
+	// the actor when nothing regenerated it since (e.g. a commandlet resaving the level). A pending build means neither
+	// matches, and a cooked package holding the baked static mesh needs neither. Tiled shapes save their tiles
+	const bool bSaveCommitted = Ar.IsSaving() && CommittedMeshes.Num() > 0;
+	TArray<FProceduralMeshKey>& MeshKeys = bSaveCommitted ? CommittedKeys : SavedKeys;
+	TArray<FProceduralMeshDataPtr>& Meshes = bSaveCommitted ? CommittedMeshes : SavedMeshes;
+	bool bHasSavedMesh = false;
+	if (Ar.IsSaving())
+	{
+		bHasSavedMesh = bSaveGeneratedMesh && !HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject) && !PendingToken.IsValid()
+			&& !(Ar.IsCooking() && BakedStaticMesh) && Meshes.Num() > 0 && MeshKeys == GetSectionKeys();
+	}
+	Ar << bHasSavedMesh;
+	if (!bHasSavedMesh)
+	{
+		return;
+	}
+
+	int32 NumLODSections = Meshes.Num();
+	Ar << NumLODSections;
+	if (Ar.IsLoading())
+	{
+		if (NumLODSections < 0)
+		{
+			Ar.SetError();
+			return;
+		}
+		MeshKeys.SetNum(NumLODSections);
+		Meshes.SetNum(NumLODSections);
+	}
+
+	for (int32 LODIndex = 0; LODIndex < NumLODSections && !Ar.IsError(); LODIndex++)
+	{
+		Ar << MeshKeys[LODIndex];
+
+		if (Ar.IsSaving())
+		{
+			// Saving only reads the arrays
+			ConstCastSharedPtr<FProceduralMeshBuilder>(Meshes[LODIndex])->Serialize(Ar);
+		}
+		else
+		{
+			const int32 Version = Ar.CustomVer(FProceduralShapeCustomVersion::GUID);
+			const EProceduralMeshRecordLayout Layout = Version < FProceduralShapeCustomVersion::SavedTangents ? EProceduralMeshRecordLayout::NoTangents
+				: Version < FProceduralShapeCustomVersion::PackedVertices ? EProceduralMeshRecordLayout::FloatVertices
+				: EProceduralMeshRecordLayout::PackedVertices;
+			TSharedRef<FProceduralMeshBuilder, ESPMode::ThreadSafe> Builder = MakeShared<FProceduralMeshBuilder, ESPMode::ThreadSafe>();
+			Builder->Serialize(Ar, Layout);
+			Meshes[LODIndex] = Builder;
+		}
+	}
+
+	// A damaged record is dropped and the shape simply regenerates, as does one saved without tangents
+	if (Ar.IsLoading() && (Ar.IsError() || Ar.CustomVer(FProceduralShapeCustomVersion::GUID) < FProceduralShapeCustomVersion::SavedTangents))
+	{
+		SavedKeys.Empty();
+		SavedMeshes.Empty();
+	}
+}
+
+#if WITH_EDITOR
+void AProceduralShapeActor::BeginCacheForCookedPlatformData(const ITargetPlatform* TargetPlatform)
+{
+	Super::BeginCacheForCookedPlatformData(TargetPlatform);
+
+	// Called once per target platform; the bake is the same for all of them. A tiled shape keeps its tiles, which it
+	// builds and streams itself, rather than shipping as one whole-shape static mesh
+	if (CookedStaticMesh || !bBakeStaticMeshOnCook || bCollapsedIntoBatch || IsTiled() || HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		return;
+	}
+
+	FBakedMeshKey Key;
+	Key.LODKeys = GetLODKeys();
+	Key.Material = GetShapeMaterial();
+	Key.LODScreenSizeStep = Key.LODKeys.Num() > 1 ? LODScreenSizeStep : 0.0f;
+	Key.CollisionMode = CollisionMode;
+	Key.Package = GetPackage();
+
+	TWeakObjectPtr<UStaticMesh>& BakedMesh = GBakedMeshes.FindOrAdd(Key);
+	if (!BakedMesh.IsValid())
+	{
+		BakedMesh = BakeStaticMesh(this);
+	}
+	CookedStaticMesh = BakedMesh.Get();
+	CookedKeys = MoveTemp(Key.LODKeys);
+	CookedCollisionMode = CollisionMode;
+}
+
+void AProceduralShapeActor::ClearAllCachedCookedPlatformData()
+{
+	Super::ClearAllCachedCookedPlatformData();
+
+	// The package is saved, so the meshes baked for it have nobody left to share them with
+	UPackage* Package = GetPackage();
+	for (auto It = GBakedMeshes.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Package == Package)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	CookedStaticMesh = nullptr;
+	CookedKeys.Reset();
+}
+
+void AProceduralShapeActor::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	// The bake only ever goes into cooked packages, and only while the parameters still match it; an editor save
+	// keeps the plain procedural actor
+	if (!ObjectSaveContext.IsCooking() || !CookedStaticMesh || CookedSaveState.bSwapped || GetLODKeys() != CookedKeys
+		|| CollisionMode != CookedCollisionMode)
+	{
+		return;
+	}
+
+	CookedSaveState.bSwapped = true;
+	CookedSaveState.BakedStaticMesh = BakedStaticMesh;
+	CookedSaveState.BakedCollisionMode = BakedCollisionMode;
+	CookedSaveState.BakedKeys = MoveTemp(BakedKeys);
+	BakedStaticMesh = CookedStaticMesh;
+	BakedKeys = CookedKeys;
+	BakedCollisionMode = CookedCollisionMode;
+
+	// The cook process never shows the level, so the sections saved by the component can go rather than ship twice.
+	// The game drops the component's hulls once it shows the bake, and they are small, so they stay
+	if (IsRunningCommandlet())
+	{
+		for (int32 SectionIndex = 0; SectionIndex < ProceduralMesh->GetNumSections(); SectionIndex++)
+		{
+			CookedSaveState.Sections.Add(MoveTemp(*ProceduralMesh->GetProcMeshSection(SectionIndex)));
+		}
+		ProceduralMesh->ClearAllMeshSections();
+	}
+}
+
+void AProceduralShapeActor::PostSave(FObjectPostSaveContext ObjectSaveContext)
+{
+	Super::PostSave(ObjectSaveContext);
+
+	if (!CookedSaveState.bSwapped)
+	{
+		return;
+	}
+
+	BakedStaticMesh = CookedSaveState.BakedStaticMesh;
+	BakedCollisionMode = CookedSaveState.BakedCollisionMode;
+	BakedKeys = MoveTemp(CookedSaveState.BakedKeys);
+	for (int32 SectionIndex = 0; SectionIndex < CookedSaveState.Sections.Num(); SectionIndex++)
+	{
+		ProceduralMesh->SetProcMeshSection(SectionIndex, CookedSaveState.Sections[SectionIndex]);
+	}
+	CookedSaveState = FCookedSaveState();
+}
+
+UStaticMesh* AProceduralShapeActor::BakeStaticMesh(UObject* Outer) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(AProceduralShapeActor::BakeStaticMesh);
+
+	const TArray<FProceduralMeshKey> LODKeys = GetLODKeys();
+	const FName MeshName = MakeUniqueObjectName(Outer, UStaticMesh::StaticClass(), *FString::Printf(TEXT("%s_Baked"), *LODKeys[0].ShapeType.ToString()));
+	UStaticMesh* StaticMesh = NewObject<UStaticMesh>(Outer, MeshName);
+	StaticMesh->GetStaticMaterials().Add(FStaticMaterial(GetShapeMaterial()));
+
+	// One source model per LOD, switched at the screen sizes the actor uses for its own sections
+	StaticMesh->SetNumSourceModels(LODKeys.Num());
+	StaticMesh->bAutoComputeLODScreenSize = false;
+	float ScreenSize = 1.0f;
+	for (int32 LODIndex = 0; LODIndex < LODKeys.Num(); LODIndex++)
+	{
+		FStaticMeshSourceModel& SourceModel = StaticMesh->GetSourceModel(LODIndex);
+		const FProceduralMeshDataRef Mesh = FindOrBuildLODMesh(LODIndex);
+
+		// The generated normals and tangents are exact, and BuildMeshDescription passes both through.
+		// Half precision UVs are the static mesh default; tiled UVs that would lose texels to it keep full precision
+		SourceModel.BuildSettings.bRecomputeNormals = false;
+		SourceModel.BuildSettings.bRecomputeTangents = false;
+		SourceModel.BuildSettings.bUseFullPrecisionUVs = !Mesh->CanUseHalfPrecisionUVs();
+		SourceModel.ScreenSize.Default = ScreenSize;
+		ScreenSize *= LODScreenSizeStep;
+
+		FMeshDescription* MeshDescription = StaticMesh->CreateMeshDescription(LODIndex);
+		Mesh->BuildMeshDescription(*MeshDescription);
+		StaticMesh->CommitMeshDescription(LODIndex);
+	}
+
+	// Same collision CommitMesh sets up: the shape's hulls for Simple, the triangles otherwise.
+	// A shape whose simple collision is an analytic primitive keeps it, so its static mesh gets no hulls
+	StaticMesh->CreateBodySetup();
+	UBodySetup* BodySetup = StaticMesh->GetBodySetup();
+	TArray<TArray<FVector>> ConvexHulls;
+	if (CollisionMode == EProceduralCollisionMode::Simple && GetSimpleCollisionHulls(ConvexHulls))
+	{
+		for (TArray<FVector>& Hull : ConvexHulls)
+		{
+			FKConvexElem& ConvexElem = BodySetup->AggGeom.ConvexElems.AddDefaulted_GetRef();
+			ConvexElem.VertexData = MoveTemp(Hull);
+			ConvexElem.UpdateElemBox();
+		}
+		BodySetup->CollisionTraceFlag = CTF_UseDefault;
+	}
+	else
+	{
+		BodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
+	}
+	BodySetup->InvalidatePhysicsData();
+
+	// Full build: render data, plus distance fields when the project generates them
+	StaticMesh->Build(/*bInSilent=*/true);
+	return StaticMesh;
+}
+#endif
+
+TArray<FProceduralMeshKey> AProceduralShapeActor::GetLODKeys() const
+{
+	TArray<FProceduralMeshKey> LODKeys;
+	for (int32 LODIndex = 0; LODIndex < FMath::Max(1, NumLODs); LODIndex++)
+	{
+		FProceduralMeshKey Key = GetLODKey(LODIndex);
+
+		// The shape cannot get any coarser; further levels would only duplicate this one
+		if (LODKeys.Num() > 0 && Key == LODKeys.Last())
+		{
+			break;
+		}
+		LODKeys.Add(MoveTemp(Key));
+	}
+	return LODKeys;
+}
+
+TArray<FProceduralMeshKey> AProceduralShapeActor::GetSectionKeys() const
+{
+	const int32 NumTiles = GetNumTiles();
+	if (NumTiles <= 1)
+	{
+		return GetLODKeys();
+	}
+
+	TArray<FProceduralMeshKey> TileKeys;
+	TileKeys.Reserve(NumTiles);
+	for (int32 TileIndex = 0; TileIndex < NumTiles; TileIndex++)
+	{
+		TileKeys.Add(AppendGenerationOptions(GetTileKey(TileIndex)));
+	}
+	return TileKeys;
+}
+
+FProceduralMeshKey AProceduralShapeActor::GetLODKey(int32 LODIndex) const
+{
+	return AppendGenerationOptions(GetMeshKey(LODIndex));
+}
+
+FProceduralMeshKey AProceduralShapeActor::AppendGenerationOptions(FProceduralMeshKey Key) const
+{
+	// Appended only when set, so meshes cached and saved without the option keep their keys
+	if (bOptimizeIndexOrder)
+	{
+		Key.Append(uint8(1));
+	}
+	return Key;
+}
+
+FProceduralMeshDataRef AProceduralShapeActor::FindOrBuildLODMesh(int32 LODIndex) const
+{
+	return FindOrBuildMesh(MakeMeshRequest(LODIndex, /*bTiled=*/false));
+}
+
+FProceduralMeshDataRef AProceduralShapeActor::FindOrBuildSectionMesh(int32 SectionIndex) const
+{
+	return FindOrBuildMesh(MakeMeshRequest(SectionIndex, IsTiled()));
+}
+
+FProceduralMeshRequest AProceduralShapeActor::MakeMeshRequest(int32 SectionIndex, bool bTiled) const
+{
+	FProceduralMeshRequest Request;
+	Request.Key = bTiled ? AppendGenerationOptions(GetTileKey(SectionIndex)) : GetLODKey(SectionIndex);
+	Request.SectionIndex = SectionIndex;
+	Request.bUseSharedMeshCache = bUseSharedMeshCache;
+	Request.bOptimizeIndexOrder = bOptimizeIndexOrder;
+	if (!bTiled)
+	{
+		Request.Mesh = FindPrebuiltMesh(SectionIndex);
+	}
+	if (!Request.Mesh.IsValid() && SavedKeys.IsValidIndex(SectionIndex) && SavedKeys[SectionIndex] == Request.Key)
+	{
+		Request.Mesh = SavedMeshes[SectionIndex];
+	}
+	if (!Request.Mesh.IsValid())
+	{
+		Request.BuildFunction = bTiled ? CreateTileBuildFunction(SectionIndex) : CreateMeshBuildFunction(SectionIndex);
+#if CPUPROFILERTRACE_ENABLED
+		Request.TraceLabel = GetTraceLabel(TEXT("Build"), Request.Key, SectionIndex, bTiled);
+#endif
+	}
+	return Request;
+}
+
+FProceduralMeshDataRef AProceduralShapeActor::FindOrBuildMesh(const FProceduralMeshRequest& Request)
+{
+	const FProceduralMeshKey& Key = Request.Key;
+	if (Request.Mesh.IsValid())
+	{
+		return Request.Mesh.ToSharedRef();
+	}
+	if (Request.bUseSharedMeshCache)
+	{
+		if (FProceduralMeshDataPtr CachedMesh = FProceduralMeshCache::Get().Find(Key))
+		{
+			return CachedMesh.ToSharedRef();
+		}
+		if (FProceduralMeshDataPtr DiskMesh = FProceduralMeshDiskCache::Get().Find(Key))
+		{
+			FProceduralMeshCache::Get().Add(Key, DiskMesh.ToSharedRef());
+			return DiskMesh.ToSharedRef();
+		}
+	}
+
+	TSharedRef<FProceduralMeshBuilder, ESPMode::ThreadSafe> Builder = MakeShared<FProceduralMeshBuilder, ESPMode::ThreadSafe>();
+	{
+		FScopeCycleCounter BuildCycles(FProceduralShapeStats::Get(Key.ShapeType).Build);
+		TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*Request.TraceLabel);
+
+		FProceduralBuildToken Token;
+		Request.BuildFunction(*Builder, Token);
+		Builder->Finalize();
+		if (Request.bOptimizeIndexOrder)
+		{
+			OptimizeIndexOrder(*Builder, Key, Request.SectionIndex);
+		}
+	}
+	if (Request.bUseSharedMeshCache)
+	{
+		FProceduralMeshCache::Get().Add(Key, Builder);
+	}
+	return Builder;
+}
+
+void AProceduralShapeActor::RegenerateMesh()
+{
+	// A collapsed actor is only a parameter set; the batcher that took it in draws and collides for it
+	if (bCollapsedIntoBatch)
+	{
+		ReleaseMesh();
+		return;
+	}
+
+	// In a cooked game the baked static mesh stands in for the sections until the parameters move away from it
+	if (BakedStaticMesh)
+	{
+		if (GetLODKeys() == BakedKeys && CollisionMode == BakedCollisionMode)
+		{
+			ActivateBakedStaticMesh();
+			return;
+		}
+		DiscardBakedStaticMesh();
+	}
+
+	// OnConstruction fires on every editor move and property tweak; only rebuild when the geometry would change
+	const bool bTiled = IsTiled();
+	TArray<FProceduralMeshKey> SectionKeys = GetSectionKeys();
+	const bool bHasCommittedMesh = ProceduralMesh->GetNumSections() > 0;
+	if (PendingToken.IsValid() ? SectionKeys == PendingKeys : (bHasCommittedMesh && SectionKeys == CommittedKeys && CollisionMode == CommittedCollisionMode))
+	{
+		// Material and LOD selection are not part of the keys and are cheap to reapply
+		ApplySectionSettings();
+		return;
+	}
+
+	// Whatever is still in flight is superseded by this request
+	CancelPendingGeneration();
+	const uint32 RequestId = ++LatestRequestId;
+
+	// Sections whose key did not change keep their mesh, so editing one region of a tiled shape only builds the tiles it covers
+	TMap<FProceduralMeshKey, FProceduralMeshDataPtr> CommittedMeshesByKey;
+	CommittedMeshesByKey.Reserve(CommittedKeys.Num());
+	for (int32 SectionIndex = 0; SectionIndex < CommittedKeys.Num(); SectionIndex++)
+	{
+		CommittedMeshesByKey.Add(CommittedKeys[SectionIndex], CommittedMeshes[SectionIndex]);
+	}
+
+	// The shape may keep some levels prebuilt, and another actor with the same parameters may already have built others
+	const int32 NumSections = SectionKeys.Num();
+	TArray<FProceduralMeshDataPtr> Meshes;
+	TArray<FProceduralMeshBuildFunction> BuildFunctions;
+	TArray<TSharedPtr<FProceduralMeshBuilder, ESPMode::ThreadSafe>> Builders;
+	TArray<FString> TraceLabels;
+	Meshes.SetNum(NumSections);
+	BuildFunctions.SetNum(NumSections);
+	Builders.SetNum(NumSections);
+	TraceLabels.SetNum(NumSections);
+	bool bAllCached = true;
+	for (int32 SectionIndex = 0; SectionIndex < NumSections; SectionIndex++)
+	{
+		const FProceduralMeshKey& Key = SectionKeys[SectionIndex];
+		Meshes[SectionIndex] = CommittedMeshesByKey.FindRef(Key);
+		if (!Meshes[SectionIndex].IsValid() && !bTiled)
+		{
+			Meshes[SectionIndex] = FindPrebuiltMesh(SectionIndex);
+		}
+		if (!Meshes[SectionIndex].IsValid() && bUseSharedMeshCache)
+		{
+			Meshes[SectionIndex] = FProceduralMeshCache::Get().Find(Key);
+		}
+
+		// Loaded with the actor: used as is, and offered to the cache so identical actors loaded later share it
+		if (!Meshes[SectionIndex].IsValid() && SavedKeys.IsValidIndex(SectionIndex) && SavedKeys[SectionIndex] == Key)
+		{
+			Meshes[SectionIndex] = SavedMeshes[SectionIndex];
+			if (bUseSharedMeshCache)
+			{
+				FProceduralMeshCache::Get().Add(Key, SavedMeshes[SectionIndex].ToSharedRef());
+			}
+		}
+
+		// Precomputed for the level: one copy out of the mapped file instead of a build
+		if (!Meshes[SectionIndex].IsValid() && bUseSharedMeshCache)
+		{
+			Meshes[SectionIndex] = FProceduralMeshDiskCache::Get().Find(Key);
+			if (Meshes[SectionIndex].IsValid())
+			{
+				FProceduralMeshCache::Get().Add(Key, Meshes[SectionIndex].ToSharedRef());
+			}
+		}
+		if (!Meshes[SectionIndex].IsValid())
+		{
+			BuildFunctions[SectionIndex] = bTiled ? CreateTileBuildFunction(SectionIndex) : CreateMeshBuildFunction(SectionIndex);
+			bAllCached = false;
+#if CPUPROFILERTRACE_ENABLED
+			TraceLabels[SectionIndex] = GetTraceLabel(TEXT("Build"), Key, SectionIndex, bTiled);
+#endif
+
+			// A rebuild with the same counts then writes into the arrays it already has
+			if (SpareBuilders.IsValidIndex(SectionIndex) && SpareBuilders[SectionIndex].IsValid())
+			{
+				Builders[SectionIndex] = MoveTemp(SpareBuilders[SectionIndex]);
+			}
+			else
+			{
+				Builders[SectionIndex] = MakeShared<FProceduralMeshBuilder, ESPMode::ThreadSafe>();
+			}
+		}
+	}
+
+	// Its references would keep the replaced meshes from becoming spares when the commit below runs synchronously
+	CommittedMeshesByKey.Empty();
+
+	// The saved meshes only stand for the parameters they were loaded with
+	SavedKeys.Empty();
+	SavedMeshes.Empty();
+
+	// Builds every section the caches did not have, in parallel across the worker threads; returns false if the request
+	// was cancelled midway
+	auto BuildMissingSections = [SectionKeys, BuildFunctions = MoveTemp(BuildFunctions), Builders = MoveTemp(Builders), TraceLabels = MoveTemp(TraceLabels),
+		bAddToCache = bUseSharedMeshCache, bOptimize = bOptimizeIndexOrder]
+		(TArray<FProceduralMeshDataPtr>& Meshes, const FProceduralBuildToken& Token) -> bool
+	{
+		TArray<int32> MissingSections;
+		for (int32 SectionIndex = 0; SectionIndex < Meshes.Num(); SectionIndex++)
+		{
+			if (!Meshes[SectionIndex].IsValid())
+			{
+				MissingSections.Add(SectionIndex);
+			}
+		}
+
+		// Every task writes only its own section
+		ParallelFor(MissingSections.Num(), [&](int32 MissingIndex)
+		{
+			const int32 SectionIndex = MissingSections[MissingIndex];
+			if (Token.IsCancelled())
+			{
+				return;
+			}
+
+			TSharedRef<FProceduralMeshBuilder, ESPMode::ThreadSafe> Builder = Builders[SectionIndex].ToSharedRef();
+			{
+				FScopeCycleCounter BuildCycles(FProceduralShapeStats::Get(SectionKeys[SectionIndex].ShapeType).Build);
+				TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*TraceLabels[SectionIndex]);
+
+				BuildFunctions[SectionIndex](*Builder, Token);
+				if (Token.IsCancelled())
+				{
+					return;
+				}
+				Builder->Finalize();
+				if (bOptimize)
+				{
+					OptimizeIndexOrder(*Builder, SectionKeys[SectionIndex], SectionIndex);
+				}
+			}
+
+			if (bAddToCache)
+			{
+				FProceduralMeshCache::Get().Add(SectionKeys[SectionIndex], Builder);
+			}
+			Meshes[SectionIndex] = Builder;
+		});
+		return !Token.IsCancelled();
+	};
+
+	if (!ShouldGenerateAsync() || bAllCached)
+	{
+		FProceduralBuildToken Token;
+		BuildMissingSections(Meshes, Token);
+		CommitMesh(Meshes, SectionKeys, bTiled);
+		return;
+	}
+
+	TSharedRef<FProceduralBuildToken, ESPMode::ThreadSafe> Token = MakeShared<FProceduralBuildToken, ESPMode::ThreadSafe>();
+	PendingToken = Token;
+	PendingKeys = SectionKeys;
+
+	TWeakObjectPtr<AProceduralShapeActor> WeakThis(this);
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, RequestId, SectionKeys = MoveTemp(SectionKeys), Meshes = MoveTemp(Meshes), bTiled, Token,
+		BuildMissingSections = MoveTemp(BuildMissingSections)]() mutable
+	{
+		if (!BuildMissingSections(Meshes, *Token))
+		{
+			return;
+		}
+
+		// Hand the finished arrays back to the game thread for the upload
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, RequestId, SectionKeys = MoveTemp(SectionKeys), Meshes = MoveTemp(Meshes), bTiled, Token]()
+		{
+			AProceduralShapeActor* This = WeakThis.Get();
+			if (This && !Token->IsCancelled() && This->LatestRequestId == RequestId)
+			{
+				This->PendingToken.Reset();
+				This->CommitMesh(Meshes, SectionKeys, bTiled);
+			}
+		});
+	});
+}
+
+void AProceduralShapeActor::SetCollapsedIntoBatch(bool bCollapsed)
+{
+	bCollapsedIntoBatch = bCollapsed;
+	SetActorHiddenInGame(bCollapsed);
+	SetActorEnableCollision(!bCollapsed);
+	RegenerateMesh();
+}
+
+void AProceduralShapeActor::ReleaseMesh()
+{
+	CancelPendingGeneration();
+	DiscardBakedStaticMesh();
+	ProceduralMesh->ClearAllMeshSections();
+	if (bHasConvexCollision)
+	{
+		ProceduralMesh->ClearCollisionConvexMeshes();
+		bHasConvexCollision = false;
+	}
+	SetCollisionPrimitivesEnabled(false);
+	if (CommittedMeshes.Num() > 0)
+	{
+		SavedKeys = MoveTemp(CommittedKeys);
+		SavedMeshes = MoveTemp(CommittedMeshes);
+	}
+	CommittedMeshes.Reset();
+	CommittedKeys.Reset();
+	SpareBuilders.Reset();
+	CurrentLOD = INDEX_NONE;
+	SetActorTickEnabled(false);
+}
+
+void AProceduralShapeActor::CommitMesh(const TArray<FProceduralMeshDataPtr>& Meshes, const TArray<FProceduralMeshKey>& Keys, bool bTiled)
+{
+	check(IsInGameThread());
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*GetTraceLabel(TEXT("Commit"), Keys[0], 0, bTiled));
+	const FProceduralShapeStats Stats = FProceduralShapeStats::Get(Keys[0].ShapeType);
+
+	// Simple collision replaces the cooked triangle mesh with the shape's hulls or primitive
+	TArray<TArray<FVector>> ConvexHulls;
+	bool bSimpleCollision = false;
+	if (CollisionMode == EProceduralCollisionMode::Simple)
+	{
+		FScopeCycleCounter CollisionCycles(Stats.Collision);
+		TRACE_CPUPROFILER_EVENT_SCOPE(ProceduralShape_CollisionHulls);
+		bSimpleCollision = GetSimpleCollisionHulls(ConvexHulls);
+	}
+	const bool bTriangleCollision = CollisionMode != EProceduralCollisionMode::None && !bSimpleCollision;
+
+	// With the same collision setup and layout the sections on the component stay: a section whose mesh did not change is
+	// left alone, and one with the same vertex count and indices (e.g. only a radius changed) is rewritten in place instead
+	// of reallocating its render buffers. The component cannot drop sections, so fewer of them start over
+	const bool bKeepSections = CommittedMeshes.Num() > 0 && CollisionMode == CommittedCollisionMode && bTiled == bCommittedTiled
+		&& ProceduralMesh->GetNumSections() == CommittedMeshes.Num() && Meshes.Num() >= CommittedMeshes.Num();
+	TArray<int32> SectionsToUpdate;
+	TArray<int32> SectionsToCreate;
+	for (int32 SectionIndex = Meshes.Num() - 1; SectionIndex >= 0; SectionIndex--)
+	{
+		if (!bKeepSections || SectionIndex >= CommittedMeshes.Num())
+		{
+			SectionsToCreate.Add(SectionIndex);
+		}
+		else if (Meshes[SectionIndex] != CommittedMeshes[SectionIndex])
+		{
+			(Meshes[SectionIndex]->HasSameTopology(*CommittedMeshes[SectionIndex]) ? SectionsToUpdate : SectionsToCreate).Add(SectionIndex);
+		}
+	}
+
+	{
+		FScopeCycleCounter UploadCycles(Stats.Upload);
+		TRACE_CPUPROFILER_EVENT_SCOPE(ProceduralShape_Upload);
+		if (!bKeepSections)
+		{
+			// Clear existing mesh
+			ProceduralMesh->ClearAllMeshSections();
+
+			// Every section upload refreshes the body setup, so stale hulls are dropped before them rather than after
+			if (bHasConvexCollision && !bSimpleCollision)
+			{
+				ProceduralMesh->ClearCollisionConvexMeshes();
+				bHasConvexCollision = false;
+			}
+			ProceduralMesh->bUseComplexAsSimpleCollision = bTriangleCollision;
+		}
+
+		// The component cooks its collision from every section at once, so only the last upload refreshes it. Both lists
+		// run from the highest section down: the first creation grows the section array once, and LOD0 comes last.
+		// Visibility, materials and collision flags of updated sections carry over
+		for (int32 UpdateIndex = 0; UpdateIndex < SectionsToUpdate.Num(); UpdateIndex++)
+		{
+			const bool bLastUpload = SectionsToCreate.Num() == 0 && UpdateIndex == SectionsToUpdate.Num() - 1;
+			Meshes[SectionsToUpdate[UpdateIndex]]->UpdateMeshSection(ProceduralMesh, SectionsToUpdate[UpdateIndex], /*bUpdateCollision=*/bLastUpload);
+		}
+
+		// Only the full-detail level of a LOD chain carries collision; every tile does
+		for (int32 CreateIndex = 0; CreateIndex < SectionsToCreate.Num(); CreateIndex++)
+		{
+			const int32 SectionIndex = SectionsToCreate[CreateIndex];
+			Meshes[SectionIndex]->CreateMeshSection(ProceduralMesh, SectionIndex, bTriangleCollision && (bTiled || SectionIndex == 0),
+				/*bRefreshComponent=*/CreateIndex == SectionsToCreate.Num() - 1);
+		}
+		if (SectionsToCreate.Num() > 0)
+		{
+			CurrentLOD = INDEX_NONE;
+		}
+	}
+
+	{
+		FScopeCycleCounter CollisionCycles(Stats.Collision);
+		TRACE_CPUPROFILER_EVENT_SCOPE(ProceduralShape_Collision);
+		if (bSimpleCollision && (ConvexHulls.Num() > 0 || bHasConvexCollision))
+		{
+			ProceduralMesh->SetCollisionConvexMeshes(ConvexHulls);
+			bHasConvexCollision = ConvexHulls.Num() > 0;
+		}
+		SetCollisionPrimitivesEnabled(bSimpleCollision);
+	}
+
+	// A replaced mesh held by nobody else (neither cached nor shared with another actor) becomes the spare of its section
+	SpareBuilders.SetNum(Meshes.Num());
+	for (int32 SectionIndex = 0; SectionIndex < FMath::Min(CommittedMeshes.Num(), Meshes.Num()); SectionIndex++)
+	{
+		if (CommittedMeshes[SectionIndex].IsValid() && CommittedMeshes[SectionIndex].GetSharedReferenceCount() == 1)
+		{
+			SpareBuilders[SectionIndex] = ConstCastSharedPtr<FProceduralMeshBuilder>(CommittedMeshes[SectionIndex]);
+		}
+	}
+
+	CommittedMeshes = Meshes;
+	CommittedKeys = Keys;
+	CommittedCollisionMode = CollisionMode;
+	bCommittedTiled = bTiled;
+	ApplySectionSettings();
+
+	// Enable collision
+	ProceduralMesh->ContainsPhysicsTriMeshData(true);
+}
+
+void AProceduralShapeActor::ApplySectionSettings()
+{
+	FScopeCycleCounter MaterialCycles(FProceduralShapeStats::Get(CommittedKeys.Num() > 0 ? CommittedKeys[0].ShapeType : NAME_None).Material);
+	TRACE_CPUPROFILER_EVENT_SCOPE(ProceduralShape_ApplySectionSettings);
+
+	// Apply material if set
+	if (UMaterialInterface* Material = GetShapeMaterial())
+	{
+		for (int32 SectionIndex = 0; SectionIndex < ProceduralMesh->GetNumSections(); SectionIndex++)
+		{
+			ProceduralMesh->SetMaterial(SectionIndex, Material);
+		}
+	}
+
+	SetVisibleLOD(ComputeTargetLOD());
+
+	// Screen-size selection only needs to run when there is something to choose between
+	SetActorTickEnabled((GetNumLODSections() > 1 && ForcedLOD < 0) || NeedsTick());
+}
+
+FString AProceduralShapeActor::GetTraceLabel(const TCHAR* Phase, const FProceduralMeshKey& Key, int32 SectionIndex, bool bTiled) const
+{
+	if (bTiled)
+	{
+		return FString::Printf(TEXT("%s %s Tile%d"), *Key.ShapeType.ToString(), Phase, SectionIndex);
+	}
+	return FString::Printf(TEXT("%s %s LOD%d %s"), *Key.ShapeType.ToString(), Phase, SectionIndex, *GetTessellationDescription(SectionIndex));
+}
+
+int32 AProceduralShapeActor::ComputeTargetLOD() const
+{
+	const int32 MaxLOD = FMath::Max(0, GetNumLODSections() - 1);
+	if (ForcedLOD >= 0 || MaxLOD == 0)
+	{
+		return FMath::Clamp(ForcedLOD, 0, MaxLOD);
+	}
+
+	// Without a player camera (e.g. in the editor) keep full detail
+	const APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (!CameraManager)
+	{
+		return 0;
+	}
+
+	// Same screen size measure as static mesh LODs: projected bounds radius relative to half the view width
+	const FBoxSphereBounds& Bounds = ProceduralMesh->Bounds;
+	const double Distance = FMath::Max(1.0, FVector::Dist(Bounds.Origin, CameraManager->GetCameraLocation()));
+	const double HalfFOVTangent = FMath::Tan(FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5));
+	const double ScreenSize = Bounds.SphereRadius / (Distance * HalfFOVTangent);
+
+	int32 LODIndex = 0;
+	double Threshold = LODScreenSizeStep;
+	while (LODIndex < MaxLOD && ScreenSize < Threshold)
+	{
+		LODIndex++;
+		Threshold *= LODScreenSizeStep;
+	}
+	return LODIndex;
+}
+
+void AProceduralShapeActor::SetVisibleLOD(int32 LODIndex)
+{
+	if (LODIndex == CurrentLOD)
+	{
+		return;
+	}
+
+	for (int32 SectionIndex = 0; SectionIndex < ProceduralMesh->GetNumSections(); SectionIndex++)
+	{
+		ProceduralMesh->SetMeshSectionVisible(SectionIndex, bCommittedTiled || SectionIndex == LODIndex);
+	}
+	CurrentLOD = LODIndex;
+}
+
+void AProceduralShapeActor::ActivateBakedStaticMesh()
+{
+	CancelPendingGeneration();
+
+	if (!BakedMeshComponent)
+	{
+		BakedMeshComponent = NewObject<UStaticMeshComponent>(this, NAME_None, RF_Transient);
+		BakedMeshComponent->SetupAttachment(ProceduralMesh);
+		BakedMeshComponent->SetStaticMesh(BakedStaticMesh);
+		BakedMeshComponent->SetCollisionProfileName(ProceduralMesh->GetCollisionProfileName());
+		BakedMeshComponent->SetCollisionEnabled(BakedCollisionMode == EProceduralCollisionMode::None ? ECollisionEnabled::NoCollision : ProceduralMesh->GetCollisionEnabled());
+		BakedMeshComponent->RegisterComponent();
+
+		// Whatever the procedural component was saved with is never shown
+		ProceduralMesh->ClearAllMeshSections();
+		if (bHasConvexCollision)
+		{
+			ProceduralMesh->ClearCollisionConvexMeshes();
+			bHasConvexCollision = false;
+		}
+		CommittedMeshes.Reset();
+		CommittedKeys.Reset();
+		SpareBuilders.Reset();
+		SavedKeys.Empty();
+		SavedMeshes.Empty();
+
+		// An analytic collision primitive is not part of the static mesh, so the shape keeps its own
+		TArray<TArray<FVector>> UnusedHulls;
+		SetCollisionPrimitivesEnabled(BakedCollisionMode == EProceduralCollisionMode::Simple && GetSimpleCollisionHulls(UnusedHulls));
+	}
+
+	// The static mesh picks its LOD itself
+	if (UMaterialInterface* Material = GetShapeMaterial())
+	{
+		BakedMeshComponent->SetMaterial(0, Material);
+	}
+	BakedMeshComponent->SetForcedLodModel(ForcedLOD + 1);
+	SetActorTickEnabled(false);
+}
+
+void AProceduralShapeActor::DiscardBakedStaticMesh()
+{
+	if (BakedMeshComponent)
+	{
+		BakedMeshComponent->DestroyComponent();
+		BakedMeshComponent = nullptr;
+	}
+	BakedStaticMesh = nullptr;
+	BakedKeys.Reset();
+}
+
+void AProceduralShapeActor::CancelPendingGeneration()
+{
+	if (PendingToken.IsValid())
+	{
+		PendingToken->Cancel();
+		PendingToken.Reset();
+	}
+}
@@ -0,0 +1,411 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ProceduralMeshComponent.h"
+#include "ProceduralMeshBuilder.h"
+#include "ProceduralMeshCache.h"
+#include "ProceduralGridKernel.h"
+#include "ProceduralRingKernel.h"
+#include "ProceduralShapeActor.generated.h"
+
+class UStaticMesh;
+class UStaticMeshComponent;
+
+/**
+ * Cancellation flag shared between a background build and the actor that requested it.
+ * Set as soon as a newer request supersedes the build, so generators can stop early.
+ */
+struct FProceduralBuildToken
+{
+	std::atomic<bool> bCancelled{false};
+
+	bool IsCancelled() const { return bCancelled.load(std::memory_order_relaxed); }
+	void Cancel() { bCancelled.store(true, std::memory_order_relaxed); }
+};
+
+/**
+ * Writer the engine-free generators of ProceduralGeometryKernel.h fill a builder through.
+ * Narrows their vertices to the builder's float arrays, serves the cached ring tables and emits
+ * rings and displaced grid rows with the SIMD kernels.
+ */
+struct FProceduralMeshWriter
+{
+	FProceduralMeshWriter(FProceduralMeshBuilder& InBuilder, const FProceduralBuildToken& InToken)
+		: Builder(InBuilder)
+		, Token(InToken)
+	{
+	}
+
+	void Reset(const FProceduralMeshCapacity& Capacity) { Builder.Reset(Capacity); }
+
+	FORCEINLINE int32 AddVertex(const ProceduralGeometry::FVec3& Position, const ProceduralGeometry::FVec3& Normal,
+		const ProceduralGeometry::FTangent& Tangent, const ProceduralGeometry::FVec2& UV)
+	{
+		return Builder.AddVertex(FVector3f(float(Position.X), float(Position.Y), float(Position.Z)), FVector3f(float(Normal.X), float(Normal.Y), float(Normal.Z)),
+			FVector4f(float(Tangent.TangentX.X), float(Tangent.TangentX.Y), float(Tangent.TangentX.Z), Tangent.bFlipTangentY ? -1.0f : 1.0f),
+			FVector2f(float(UV.X), float(UV.Y)));
+	}
+
+	FORCEINLINE void AddTriangle(int32 V0, int32 V1, int32 V2) { Builder.AddTriangle(V0, V1, V2); }
+
+	// Shared table for the ring; held until the writer goes away
+	ProceduralGeometry::FRingView GetRing(int32 NumSegments)
+	{
+		return Rings.Add_GetRef(FProceduralRingTable::Get(NumSegments))->GetView();
+	}
+
+	int32 AddRing(const FProceduralRingParams& Params, const ProceduralGeometry::FRingView& Ring, int32 FirstMeridian, int32 Count)
+	{
+		int32 RingStart = Builder.AddUninitializedVertices(Count);
+		FProceduralRingKernel::EmitRing(Params, Ring, FirstMeridian, Count,
+			Builder.Vertices.GetData() + RingStart, Builder.Normals.GetData() + RingStart, Builder.Tangents.GetData() + RingStart,
+			Builder.UVs.GetData() + RingStart);
+		return RingStart;
+	}
+
+	int32 AddGridRow(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove, int32 Count)
+	{
+		int32 RowStart = Builder.AddUninitializedVertices(Count);
+		FProceduralGridKernel::EmitGridRow(Params, Heights, HeightsBelow, HeightsAbove, Count,
+			Builder.Vertices.GetData() + RowStart, Builder.Normals.GetData() + RowStart, Builder.Tangents.GetData() + RowStart,
+			Builder.UVs.GetData() + RowStart);
+		return RowStart;
+	}
+
+	// A newer request superseded this build
+	bool IsCancelled() const { return Token.IsCancelled(); }
+
+private:
+	FProceduralMeshBuilder& Builder;
+	const FProceduralBuildToken& Token;
+	TArray<FProceduralRingTableRef, TInlineAllocator<1>> Rings;
+};
+
+// Fills a builder from a by-value snapshot of the shape parameters; safe to run on any thread
+using FProceduralMeshBuildFunction = TFunction<void(FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)>;
+
+/**
+ * One section's mesh as far as the game thread resolves it: the mesh itself when the shape holds it (prebuilt or saved
+ * with the actor), otherwise the key and build function the rest takes. Touches no actor, so any thread can finish it.
+ */
+struct FProceduralMeshRequest
+{
+	FProceduralMeshKey Key;
+	int32 SectionIndex = 0;
+	FProceduralMeshDataPtr Mesh;
+	FProceduralMeshBuildFunction BuildFunction;
+	FString TraceLabel;
+	bool bUseSharedMeshCache = true;
+	bool bOptimizeIndexOrder = false;
+};
+
+// How a procedural shape collides
+UENUM(BlueprintType)
+enum class EProceduralCollisionMode : uint8
+{
+	// Cook the full-detail section into a triangle mesh: exact, but the slowest to create and to query
+	TriangleMesh,
+	// The shape's analytic primitive or a few convex hulls; shapes without one keep the triangle mesh
+	Simple,
+	// Generate no collision data at all
+	None UMETA(DisplayName = "No Collision"),
+};
+
+/**
+ * Base class of the procedural primitives.
+ * Owns the mesh component and the generation pipeline: the arrays are built (optionally on a
+ * background task) from a snapshot of the parameters, then committed on the game thread.
+ * Each LOD is its own mesh section; only the one matching the actor's screen size is visible.
+ * A shape split into tiles instead shows all of its tile sections at full detail.
+ */
+UCLASS(Abstract)
+class MODELLING3DONE_API AProceduralShapeActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AProceduralShapeActor();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	virtual void OnConstruction(const FTransform& Transform) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Picks the visible LOD section from the screen size; only enabled while there is more than one LOD or NeedsTick
+	virtual void Tick(float DeltaSeconds) override;
+
+	// Saves the committed mesh along with the parameters, see bSaveGeneratedMesh
+	virtual void Serialize(FArchive& Ar) override;
+
+#if WITH_EDITOR
+	// Bakes the static mesh stand-in when the level is cooked, see bBakeStaticMeshOnCook. The bake is kept until the
+	// cooker is done with the package
+	virtual void BeginCacheForCookedPlatformData(const ITargetPlatform* TargetPlatform) override;
+	virtual void ClearAllCachedCookedPlatformData() override;
+
+	// A cooked save swaps the baked static mesh in and the procedural sections out; PostSave puts both back
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+	virtual void PostSave(FObjectPostSaveContext ObjectSaveContext) override;
+
+	// Builds a static mesh asset from the LOD chain: source models with render data, distance fields and
+	// collision matching CollisionMode. Runs the full static mesh build, so it is meant for cooking and tools
+	UStaticMesh* BakeStaticMesh(UObject* Outer) const;
+#endif
+
+	// The procedural mesh component that will hold our geometry
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
+	UProceduralMeshComponent* ProceduralMesh;
+
+	// Build the geometry on a background task; only the section upload and material run on the game thread
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Generation")
+	bool bGenerateAsync = false;
+
+	// Reuse meshes already generated by any actor with identical parameters (see FProceduralMeshCache)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Generation")
+	bool bUseSharedMeshCache = true;
+
+	// Number of LOD sections to generate. Each LOD halves the shape's tessellation; the chain stops early once it cannot get coarser
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "1", ClampMax = "8"))
+	int32 NumLODs = 1;
+
+	// LOD N is shown once the actor's screen size (bounds radius over half the view width) drops below Step^N
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "0.01", ClampMax = "0.99"))
+	float LODScreenSizeStep = 0.5f;
+
+	// Always show this LOD, e.g. to preview a level in the editor; -1 selects by screen size
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "-1", ClampMax = "7"))
+	int32 ForcedLOD = -1;
+
+	// LOD section currently visible
+	UFUNCTION(BlueprintPure, Category = "LOD")
+	int32 GetCurrentLOD() const { return CurrentLOD; }
+
+	// Rebuilds the mesh from the current parameters. When async, the latest request wins and older builds are cancelled
+	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
+	void RegenerateMesh();
+
+	// True while a background build has been requested but not committed yet
+	UFUNCTION(BlueprintPure, Category = "Mesh Generation")
+	bool IsGenerationPending() const { return PendingToken.IsValid(); }
+
+	// Save the generated mesh with the actor, so loading the level uploads it instead of generating it again.
+	// The saved mesh is only used while its parameters still match; turn off to keep large shapes out of the map file
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Generation")
+	bool bSaveGeneratedMesh = true;
+
+	// Cook the LOD chain into a static mesh that replaces the procedural sections in packaged games. The actor
+	// falls back to generating its mesh only if its parameters or collision mode change at runtime. Tiled shapes are
+	// never baked, as one static mesh would replace their per-tile sections and streaming
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Generation")
+	bool bBakeStaticMeshOnCook = true;
+
+	// True while the cooked static mesh is shown instead of the procedural sections
+	UFUNCTION(BlueprintPure, Category = "Mesh Generation")
+	bool IsUsingBakedStaticMesh() const { return BakedMeshComponent != nullptr; }
+
+	// Reorder each generated LOD for the GPU's post-transform vertex cache, overdraw and vertex fetch. Adds to the build
+	// time, so it pays off on dense shapes drawn many times per frame, e.g. in shadow and depth passes. The ACMR before
+	// and after each build is logged to LogProceduralMesh at Verbose. Each rebuild gets its own order, so parameter changes
+	// re-create the sections rather than refill them; Pac-Man's prebuilt mouth keyframes keep their shared generation order
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Generation")
+	bool bOptimizeIndexOrder = false;
+
+	// Lets AProceduralInstanceBatcher fold this actor into an instanced mesh; tiled shapes are always left out
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Generation")
+	bool bAllowInstanceBatching = true;
+
+	// Hands the geometry to an AProceduralPrimitiveBatcher: the actor keeps its parameters for the batcher to build from,
+	// but hides and drops its own sections, collision and tick. Turning it off regenerates the actor's mesh
+	void SetCollapsedIntoBatch(bool bCollapsed);
+
+	// True while an AProceduralPrimitiveBatcher draws this actor's geometry
+	bool IsCollapsedIntoBatch() const { return bCollapsedIntoBatch; }
+
+	// The sections are tiles of one mesh rather than a LOD chain, see GetNumTiles
+	bool IsTiled() const { return GetNumTiles() > 1; }
+
+	// Collision generated along with the mesh; see EProceduralCollisionMode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Collision")
+	EProceduralCollisionMode CollisionMode = EProceduralCollisionMode::TriangleMesh;
+
+	// Keys of the LOD chain, LOD0 first; identical trailing levels are dropped
+	TArray<FProceduralMeshKey> GetLODKeys() const;
+
+	// Finished mesh of one LOD, from the shared cache or built synchronously; game thread only, as it reads the actor
+	FProceduralMeshDataRef FindOrBuildLODMesh(int32 LODIndex) const;
+
+	// Keys of the sections RegenerateMesh commits: one per tile of a tiled shape, the LOD chain otherwise
+	TArray<FProceduralMeshKey> GetSectionKeys() const;
+
+	// Finished mesh of one of those sections, found or built like FindOrBuildLODMesh
+	FProceduralMeshDataRef FindOrBuildSectionMesh(int32 SectionIndex) const;
+
+	// Material applied to the generated sections
+	virtual UMaterialInterface* GetShapeMaterial() const { return nullptr; }
+
+protected:
+	// Builds merged meshes from the same virtuals as the actors' own
+	friend class AProceduralPrimitiveBatcher;
+
+	// Captures the shape parameters of one LOD by value into a function that builds its mesh
+	virtual FProceduralMeshBuildFunction CreateMeshBuildFunction(int32 LODIndex) const PURE_VIRTUAL(AProceduralShapeActor::CreateMeshBuildFunction, return FProceduralMeshBuildFunction(););
+
+	// Every parameter that affects the geometry of one LOD (not the transform or material)
+	virtual FProceduralMeshKey GetMeshKey(int32 LODIndex) const PURE_VIRTUAL(AProceduralShapeActor::GetMeshKey, return FProceduralMeshKey(););
+
+	// Finished mesh of one LOD from a shape-specific store that takes precedence over the shared cache, if the shape has one
+	virtual FProceduralMeshDataPtr FindPrebuiltMesh(int32 LODIndex) const { return nullptr; }
+
+	// Convex hulls (actor space) approximating the full-detail shape for Simple collision.
+	// Returns false when the shape has no simple form, in which case it keeps the triangle mesh
+	virtual bool GetSimpleCollisionHulls(TArray<TArray<FVector>>& OutHulls) const { return false; }
+
+	// Switches collision components the shape owns besides the hulls, such as an analytic primitive
+	virtual void SetCollisionPrimitivesEnabled(bool bEnabled) {}
+
+	// Ring resolution of cylindrical hulls; Chaos query cost grows with the hull vertex count
+	static constexpr int32 MaxCollisionHullMeridians = 16;
+
+	// Tessellation of one LOD as shown in profiler captures, e.g. "16x32" for parallels x meridians
+	virtual FString GetTessellationDescription(int32 LODIndex) const { return FString(); }
+
+	// Number of sections the full-detail mesh is split into. With more than one, each tile is keyed, built and
+	// uploaded on its own and the shape has no LOD chain
+	virtual int32 GetNumTiles() const { return 1; }
+
+	// Every parameter that affects the geometry of one tile; only asked of shapes with more than one
+	virtual FProceduralMeshKey GetTileKey(int32 TileIndex) const { return GetMeshKey(0); }
+
+	// Captures the shape parameters of one tile by value into a function that builds its mesh
+	virtual FProceduralMeshBuildFunction CreateTileBuildFunction(int32 TileIndex) const { return CreateMeshBuildFunction(0); }
+
+	// Build on a background task even when bGenerateAsync is off, e.g. for rebuilds the shape requests from Tick
+	virtual bool ShouldGenerateAsync() const { return bGenerateAsync; }
+
+	// The shape has per-frame work of its own besides picking the visible LOD, such as streaming its tiles
+	virtual bool NeedsTick() const { return false; }
+
+private:
+	// Shape key of one LOD plus the generation options that change its arrays
+	FProceduralMeshKey GetLODKey(int32 LODIndex) const;
+
+	// Appends the generation options to a shape key
+	FProceduralMeshKey AppendGenerationOptions(FProceduralMeshKey Key) const;
+
+	// Prebuilt or saved mesh of one section, or else everything FindOrBuildMesh needs to find or build it; game thread only
+	FProceduralMeshRequest MakeMeshRequest(int32 SectionIndex, bool bTiled) const;
+
+	// The request's mesh, else the shared cache, the disk cache, then a synchronous build; safe on any thread
+	static FProceduralMeshDataRef FindOrBuildMesh(const FProceduralMeshRequest& Request);
+
+	// Insights scope name for one phase of one section: shape type, phase, then LOD and tessellation or the tile
+	FString GetTraceLabel(const TCHAR* Phase, const FProceduralMeshKey& Key, int32 SectionIndex, bool bTiled) const;
+
+	// Uploads the sections to the mesh component, leaving unchanged ones alone and rewriting the others in place when
+	// their topology is unchanged; game thread only
+	void CommitMesh(const TArray<FProceduralMeshDataPtr>& Meshes, const TArray<FProceduralMeshKey>& Keys, bool bTiled);
+
+	// Applies the material to every section and refreshes LOD visibility and ticking
+	void ApplySectionSettings();
+
+	// LOD the current view calls for, from ForcedLOD or the screen size of the bounds
+	int32 ComputeTargetLOD() const;
+
+	// LOD sections on the component; a tiled mesh counts as a single level
+	int32 GetNumLODSections() const { return bCommittedTiled ? 1 : ProceduralMesh->GetNumSections(); }
+
+	// Shows only the given LOD section, or every tile
+	void SetVisibleLOD(int32 LODIndex);
+
+	// Flags any in-flight background build as stale
+	void CancelPendingGeneration();
+
+	// Shows the cooked static mesh in place of the procedural sections, creating its component on first use
+	void ActivateBakedStaticMesh();
+
+	// Removes the cooked static mesh for good once the parameters no longer match it
+	void DiscardBakedStaticMesh();
+
+	// Empties the mesh component and stops LOD ticking; the last mesh is kept as if it had been loaded with the actor
+	void ReleaseMesh();
+
+	// Incremented per request; a background result is only committed while it is still the latest
+	uint32 LatestRequestId = 0;
+
+	// Token of the background build currently in flight, if any
+	TSharedPtr<FProceduralBuildToken, ESPMode::ThreadSafe> PendingToken;
+
+	// Section keys of the build in flight and of the mesh currently on the component
+	TArray<FProceduralMeshKey> PendingKeys;
+	TArray<FProceduralMeshKey> CommittedKeys;
+
+	// Meshes currently on the component, one per section, to tell whether the next one can be kept or written in place
+	TArray<FProceduralMeshDataPtr> CommittedMeshes;
+
+	// The sections on the component are tiles rather than LODs
+	bool bCommittedTiled = false;
+
+	// Static mesh cooked from the LOD keys and collision mode below; only ever set in cooked packages
+	UPROPERTY()
+	UStaticMesh* BakedStaticMesh = nullptr;
+
+	UPROPERTY()
+	EProceduralCollisionMode BakedCollisionMode = EProceduralCollisionMode::TriangleMesh;
+
+	TArray<FProceduralMeshKey> BakedKeys;
+
+#if WITH_EDITORONLY_DATA
+	// Static mesh baked by BeginCacheForCookedPlatformData for the package being cooked
+	UPROPERTY(Transient)
+	UStaticMesh* CookedStaticMesh = nullptr;
+#endif
+
+#if WITH_EDITOR
+	// LOD keys and collision mode CookedStaticMesh was baked from
+	TArray<FProceduralMeshKey> CookedKeys;
+	EProceduralCollisionMode CookedCollisionMode = EProceduralCollisionMode::TriangleMesh;
+
+	// What PreSave swapped out for a cooked save, restored by PostSave
+	struct FCookedSaveState
+	{
+		bool bSwapped = false;
+		UStaticMesh* BakedStaticMesh = nullptr;
+		EProceduralCollisionMode BakedCollisionMode = EProceduralCollisionMode::TriangleMesh;
+		TArray<FProceduralMeshKey> BakedKeys;
+		TArray<FProcMeshSection> Sections;
+	};
+	FCookedSaveState CookedSaveState;
+#endif
+
+	// Created at runtime to draw BakedStaticMesh
+	UPROPERTY(Transient)
+	UStaticMeshComponent* BakedMeshComponent = nullptr;
+
+	// Meshes loaded with the actor and the section keys they were generated from; consumed by the first regeneration
+	TArray<FProceduralMeshKey> SavedKeys;
+	TArray<FProceduralMeshDataPtr> SavedMeshes;
+
+	// Previously committed meshes nobody else holds, per section; the next build refills their arrays instead of allocating
+	TArray<TSharedPtr<FProceduralMeshBuilder, ESPMode::ThreadSafe>> SpareBuilders;
+
+	// Collision mode the committed mesh was set up with
+	EProceduralCollisionMode CommittedCollisionMode = EProceduralCollisionMode::TriangleMesh;
+
+	// The mesh component holds convex elements from Simple collision; saved with them
+	UPROPERTY()
+	bool bHasConvexCollision = false;
+
+	// See SetCollapsedIntoBatch
+	UPROPERTY()
+	bool bCollapsedIntoBatch = false;
+
+	int32 CurrentLOD = 0;
+};
@@ -3,184 +3,88 @@
 
 #include "ProceduralSphereActor.h"
 
+#include "Components/SphereComponent.h"
+
+static_assert(uint8(EProceduralSphereTopology::LatLong) == uint8(ProceduralGeometry::ESphereTopology::LatLong)
+	&& uint8(EProceduralSphereTopology::Icosphere) == uint8(ProceduralGeometry::ESphereTopology::Icosphere)
+	&& uint8(EProceduralSphereTopology::CubeSphere) == uint8(ProceduralGeometry::ESphereTopology::CubeSphere),
+	"EProceduralSphereTopology must mirror ProceduralGeometry::ESphereTopology");
 
 // Sets default values
 AProceduralSphereActor::AProceduralSphereActor()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
-	
-	// Create the procedural mesh component
-	ProceduralMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ProceduralMesh"));
-	RootComponent = ProceduralMesh;
-	
-	// Enable collision
-	ProceduralMesh->bUseAsyncCooking = true;
-}
-
-// Called when the game starts or when spawned
-void AProceduralSphereActor::BeginPlay()
-{
-	Super::BeginPlay();
-	GenerateSphere();
-}
-
-void AProceduralSphereActor::OnConstruction(const FTransform& Transform)
-{
-	Super::OnConstruction(Transform);
-	GenerateSphere();
+	// Idle until Simple collision switches it on in place of the mesh collision
+	CollisionSphere = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionSphere"));
+	CollisionSphere->SetupAttachment(ProceduralMesh);
+	CollisionSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 }
 
-void AProceduralSphereActor::GenerateSphere()
+FProceduralSphereParams AProceduralSphereActor::GetMeshParams(int32 LODIndex) const
 {
-	// Clear existing mesh
-	ProceduralMesh->ClearAllMeshSections();
-
-	// Arrays to hold mesh data
-	TArray<FVector> Vertices;
-	TArray<int32> Triangles;
-	TArray<FVector> Normals;
-	TArray<FVector2D> UVs;
-	TArray<FColor> VertexColors;
-	TArray<FProcMeshTangent> Tangents;
-
-	// Ensure minimum values
-	int32 Parallels = FMath::Max(3, NumParallels);
-	int32 Meridians = FMath::Max(3, NumMeridians);
+	FProceduralSphereParams Params;
+	Params.Radius = Radius;
+	Params.Topology = static_cast<ProceduralGeometry::ESphereTopology>(Topology);
 
-	// Create North Pole vertex (index 0)
-	FVector NorthPole = FVector(0, 0, Radius);
-	Vertices.Add(NorthPole);
-	Normals.Add(NorthPole.GetSafeNormal());
-	UVs.Add(FVector2D(0.5f, 1.0f));
-
-	// Generate vertices for parallels (latitude circles)
-	// Skip poles: start from parallel 1 to Parallels-1
-	for (int32 ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+	// Fields the layout ignores stay zero, so identical meshes share one cache key
+	if (Topology == EProceduralSphereTopology::LatLong)
 	{
-		// Angle from north pole (0 to PI)
-		float Theta = PI * float(ParallelIdx) / float(Parallels);
-		float SinTheta = FMath::Sin(Theta);
-		float CosTheta = FMath::Cos(Theta);
-
-		for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
-		{
-			// Angle around the sphere (0 to 2*PI)
-			float Phi = 2.0f * PI * float(MeridianIdx) / float(Meridians);
-			float SinPhi = FMath::Sin(Phi);
-			float CosPhi = FMath::Cos(Phi);
-
-			// Spherical to Cartesian coordinates
-			FVector Position = FVector(
-				Radius * SinTheta * CosPhi,  // X
-				Radius * SinTheta * SinPhi,  // Y
-				Radius * CosTheta            // Z
-			);
-
-			Vertices.Add(Position);
-			Normals.Add(Position.GetSafeNormal());
-
-			// UV mapping
-			float U = float(MeridianIdx) / float(Meridians);
-			float V = float(ParallelIdx) / float(Parallels);
-			UVs.Add(FVector2D(U, V));
-		}
+		// Each LOD halves both ring counts, down to the minimum the generator accepts
+		Params.NumParallels = FMath::Max(3, NumParallels >> LODIndex);
+		Params.NumMeridians = FMath::Max(3, NumMeridians >> LODIndex);
 	}
-
-	// Create South Pole vertex (last vertex)
-	FVector SouthPole = FVector(0, 0, -Radius);
-	int32 SouthPoleIndex = Vertices.Num();
-	Vertices.Add(SouthPole);
-	Normals.Add(SouthPole.GetSafeNormal());
-	UVs.Add(FVector2D(0.5f, 0.0f));
-
-	// --- Generate Triangles ---
-
-	// North Pole cap triangles
-	for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+	else
 	{
-		int32 Next = (MeridianIdx + 1) % Meridians;
-		
-		// Triangle: North Pole -> Next meridian -> Current meridian
-		Triangles.Add(0);                    // North pole
-		Triangles.Add(1 + Next);             // Next vertex on first parallel
-		Triangles.Add(1 + MeridianIdx);      // Current vertex on first parallel
+		// Each LOD drops one split, which quarters the triangles
+		Params.Subdivisions = FMath::Clamp(Subdivisions - LODIndex, 0, ProceduralGeometry::MaxSphereSubdivisions);
 	}
+	return Params;
+}
 
-
-	// Middle section: quads between parallels (each quad = 2 triangles)
-	for (int32 ParallelIdx = 1; ParallelIdx < Parallels - 1; ParallelIdx++)
+FString AProceduralSphereActor::GetTessellationDescription(int32 LODIndex) const
+{
+	const FProceduralSphereParams Params = GetMeshParams(LODIndex);
+	switch (Topology)
 	{
-		for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
-		{
-			int32 Next = (MeridianIdx + 1) % Meridians;
-
-			// Calculate vertex indices
-			int32 Current = 1 + (ParallelIdx - 1) * Meridians + MeridianIdx;
-			int32 CurrentNext = 1 + (ParallelIdx - 1) * Meridians + Next;
-			int32 Below = 1 + ParallelIdx * Meridians + MeridianIdx;
-			int32 BelowNext = 1 + ParallelIdx * Meridians + Next;
-
-			// First triangle of the quad
-			Triangles.Add(Current);
-			Triangles.Add(CurrentNext);
-			Triangles.Add(Below);
-
-			// Second triangle of the quad
-			Triangles.Add(CurrentNext);
-			Triangles.Add(BelowNext);
-			Triangles.Add(Below);
-		}
+	case EProceduralSphereTopology::Icosphere:
+		return FString::Printf(TEXT("Ico%d"), Params.Subdivisions);
+	case EProceduralSphereTopology::CubeSphere:
+		return FString::Printf(TEXT("Cube%d"), Params.Subdivisions);
+	default:
+		return FString::Printf(TEXT("%dx%d"), Params.NumParallels, Params.NumMeridians);
 	}
+}
 
-	// South Pole cap triangles
-	int32 LastParallelStart = 1 + (Parallels - 2) * Meridians;
-	for (int32 MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+FProceduralMeshBuildFunction AProceduralSphereActor::CreateMeshBuildFunction(int32 LODIndex) const
+{
+	return [Params = GetMeshParams(LODIndex)](FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
 	{
-		int32 Next = (MeridianIdx + 1) % Meridians;
-
-		// Triangle: Current meridian -> Next meridian -> South Pole
-		Triangles.Add(LastParallelStart + MeridianIdx);
-		Triangles.Add(LastParallelStart + Next);
-		Triangles.Add(SouthPoleIndex);
-	}
-
-	// Create the mesh section
-	ProceduralMesh->CreateMeshSection(0, Vertices, Triangles, Normals, UVs, 
-	                                  VertexColors, Tangents, true);
+		BuildMesh(Params, Builder, Token);
+	};
+}
 
-	// Apply material if set
-	if (SphereMaterial)
+void AProceduralSphereActor::SetCollisionPrimitivesEnabled(bool bEnabled)
+{
+	// The sphere needs no hulls at all: it collides as the primitive, with the mesh component's collision settings
+	CollisionSphere->SetSphereRadius(FMath::Abs(Radius));
+	if (bEnabled)
 	{
-		ProceduralMesh->SetMaterial(0, SphereMaterial);
+		CollisionSphere->SetCollisionProfileName(ProceduralMesh->GetCollisionProfileName());
 	}
-	
-	// Enable collision
-	ProceduralMesh->ContainsPhysicsTriMeshData(true);
+	CollisionSphere->SetCollisionEnabled(bEnabled ? ProceduralMesh->GetCollisionEnabled() : ECollisionEnabled::NoCollision);
 }
 
-void AProceduralSphereActor::CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles,
-	TArray<FVector>& Normals, TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2)
+void AProceduralSphereActor::GenerateSphere()
 {
-	// Add vertices
-	int32 StartIndex = Vertices.Num();
-	Vertices.Add(V0);
-	Vertices.Add(V1);
-	Vertices.Add(V2);
-
-	// Add triangle indices (counter-clockwise for proper face orientation)
-	Triangles.Add(StartIndex);
-	Triangles.Add(StartIndex + 1);
-	Triangles.Add(StartIndex + 2);
+	RegenerateMesh();
+}
 
-	// Calculate normal for the triangle
-	FVector Normal = FVector::CrossProduct(V1 - V0, V2 - V0).GetSafeNormal();
-	Normals.Add(Normal);
-	Normals.Add(Normal);
-	Normals.Add(Normal);
+FProceduralMeshCapacity AProceduralSphereActor::ComputeMeshCapacity(const FProceduralSphereParams& Params)
+{
+	return ProceduralGeometry::ComputeSphereCapacity(Params);
+}
 
-	// Add UV coordinates (basic planar mapping)
-	UVs.Add(FVector2D(0, 0));
-	UVs.Add(FVector2D(1, 0));
-	UVs.Add(FVector2D(0, 1));
+void AProceduralSphereActor::BuildMesh(const FProceduralSphereParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token)
+{
+	FProceduralMeshWriter Writer(Builder, Token);
+	ProceduralGeometry::BuildSphere(Params, Writer);
 }
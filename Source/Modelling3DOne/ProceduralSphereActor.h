@@ -3,12 +3,37 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "ProceduralMeshComponent.h"
+#include "ProceduralShapeActor.h"
 #include "ProceduralSphereActor.generated.h"
 
+class USphereComponent;
+
+// How the sphere surface is tessellated; mirrors ProceduralGeometry::ESphereTopology
+UENUM(BlueprintType)
+enum class EProceduralSphereTopology : uint8
+{
+	// Rings of latitude and longitude: clean UVs, but the triangles crowd at the poles
+	LatLong UMETA(DisplayName = "Lat/Long"),
+	// Subdivided icosahedron: near-uniform triangles, the fewest vertices for a given silhouette
+	Icosphere,
+	// Subdivided cube projected onto the sphere: a regular grid on each of the six faces
+	CubeSphere UMETA(DisplayName = "Cube Sphere"),
+};
+
+// Identifies the generated sphere mesh; every field of FProceduralSphereParams must be appended
+inline FProceduralMeshKey MakeMeshKey(const FProceduralSphereParams& Params)
+{
+	FProceduralMeshKey Key(TEXT("Sphere"));
+	Key.Append(Params.Radius);
+	Key.Append(Params.NumParallels);
+	Key.Append(Params.NumMeridians);
+	Key.Append(uint8(Params.Topology));
+	Key.Append(Params.Subdivisions);
+	return Key;
+}
+
 UCLASS()
-class MODELLING3DONE_API AProceduralSphereActor : public AActor
+class MODELLING3DONE_API AProceduralSphereActor : public AProceduralShapeActor
 {
 	GENERATED_BODY()
 
@@ -16,16 +41,6 @@ public:
 	// Sets default values for this actor's properties
 	AProceduralSphereActor();
 
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	virtual void OnConstruction(const FTransform& Transform) override;
-
-public:
-	// The procedural mesh component that will hold our geometry
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
-	UProceduralMeshComponent* ProceduralMesh;
-
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Sphere")
 	float Radius = 100.0f;
  
@@ -35,11 +50,23 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Sphere", meta=(ClampMin="3"))
 	int32 NumMeridians = 32;
 
+	// Tessellation layout; NumParallels and NumMeridians only apply to LatLong
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Sphere")
+	EProceduralSphereTopology Topology = EProceduralSphereTopology::LatLong;
+
+	// Times the icosahedron or cube is split; each level quadruples the triangles. Level 3 is 642 icosphere or 386 cube-sphere vertices
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Sphere", meta=(ClampMin="0", ClampMax="8", EditCondition="Topology != EProceduralSphereTopology::LatLong"))
+	int32 Subdivisions = 3;
+
 	
 	// Material to apply to the mesh
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sphere Parameters")
 	UMaterialInterface* SphereMaterial;
 
+	// Exact sphere primitive used in place of hulls when CollisionMode is Simple
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Collision")
+	USphereComponent* CollisionSphere;
+
 	// Show wireframe overlay
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
 	bool bShowWireframe = false;
@@ -47,9 +74,24 @@ public:
 	// Function to generate the sphere mesh
 	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
 	void GenerateSphere();
-	
-private:
-	// Helper function to create a single triangle
-	void CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, 
-					   TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2);
+
+	// Snapshot of the shape parameters GenerateSphere builds from, coarsened for the given LOD
+	FProceduralSphereParams GetMeshParams(int32 LODIndex = 0) const;
+
+	// Exact vertex and index counts GenerateSphere will emit for the current parameters
+	FProceduralMeshCapacity ComputeMeshCapacity() const { return ComputeMeshCapacity(GetMeshParams()); }
+	static FProceduralMeshCapacity ComputeMeshCapacity(const FProceduralSphereParams& Params);
+
+	// Fills the builder with the sphere mesh; touches no actor state, so it can run off the game thread
+	static void BuildMesh(const FProceduralSphereParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token);
+
+protected:
+	virtual FProceduralMeshBuildFunction CreateMeshBuildFunction(int32 LODIndex) const override;
+	virtual FProceduralMeshKey GetMeshKey(int32 LODIndex) const override { return MakeMeshKey(GetMeshParams(LODIndex)); }
+	virtual FString GetTessellationDescription(int32 LODIndex) const override;
+	virtual UMaterialInterface* GetShapeMaterial() const override { return SphereMaterial; }
+
+	// Simple collision is CollisionSphere alone, without any hulls
+	virtual bool GetSimpleCollisionHulls(TArray<TArray<FVector>>& OutHulls) const override { return true; }
+	virtual void SetCollisionPrimitivesEnabled(bool bEnabled) override;
 };
\ No newline at end of file
@@ -3,28 +3,26 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "ProceduralMeshComponent.h"
+#include "ProceduralShapeActor.h"
 #include "ProceduralTrapezoidActor.generated.h"
 
+// Identifies the generated trapezoid mesh; every field of FProceduralTrapezoidParams must be appended
+inline FProceduralMeshKey MakeMeshKey(const FProceduralTrapezoidParams& Params)
+{
+	FProceduralMeshKey Key(TEXT("Trapezoid"));
+	Key.Append(Params.TopWidth);
+	Key.Append(Params.BottomWidth);
+	Key.Append(Params.Height);
+	Key.Append(Params.Depth);
+	return Key;
+}
+
 UCLASS()
-class MODELLING3DONE_API AProceduralTrapezoidActor : public AActor
+class MODELLING3DONE_API AProceduralTrapezoidActor : public AProceduralShapeActor
 {
 	GENERATED_BODY()
 
 public:
-	// Sets default values for this actor's properties
-	AProceduralTrapezoidActor();
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	virtual void OnConstruction(const FTransform& Transform) override;
-
-public:
-	// The procedural mesh component that will hold our geometry
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh")
-	UProceduralMeshComponent* ProceduralMesh;
 	
 	// Top base width (smaller parallel side)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Trapezoid", meta=(ClampMin="0.1"))
@@ -53,9 +51,23 @@ public:
 	// Function to generate the sphere mesh
 	UFUNCTION(BlueprintCallable, Category = "Mesh Generation")
 	void GenerateTrapezoid();
-	
-private:
-	// Helper function to create a single triangle
-	void CreateTriangle(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, 
-					   TArray<FVector2D>& UVs, const FVector& V0, const FVector& V1, const FVector& V2);
+
+	// Snapshot of the shape parameters GenerateTrapezoid builds from; the prism has a single LOD
+	FProceduralTrapezoidParams GetMeshParams(int32 LODIndex = 0) const;
+
+	// Exact vertex and index counts GenerateTrapezoid will emit for the current parameters
+	FProceduralMeshCapacity ComputeMeshCapacity() const { return ComputeMeshCapacity(GetMeshParams()); }
+	static FProceduralMeshCapacity ComputeMeshCapacity(const FProceduralTrapezoidParams& Params);
+
+	// Fills the builder with the trapezoid mesh; touches no actor state, so it can run off the game thread
+	static void BuildMesh(const FProceduralTrapezoidParams& Params, FProceduralMeshBuilder& Builder, const FProceduralBuildToken& Token);
+
+	// The prism is convex, so Simple collision is exactly its 8 corners
+	static void BuildCollisionHulls(const FProceduralTrapezoidParams& Params, TArray<TArray<FVector>>& OutHulls);
+
+protected:
+	virtual FProceduralMeshBuildFunction CreateMeshBuildFunction(int32 LODIndex) const override;
+	virtual FProceduralMeshKey GetMeshKey(int32 LODIndex) const override { return MakeMeshKey(GetMeshParams(LODIndex)); }
+	virtual UMaterialInterface* GetShapeMaterial() const override { return TrapezoidMaterial; }
+	virtual bool GetSimpleCollisionHulls(TArray<TArray<FVector>>& OutHulls) const override { BuildCollisionHulls(GetMeshParams(), OutHulls); return true; }
 };
@@ -0,0 +1,581 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+// Standalone throughput benchmark of the procedural generators, built without the engine:
+//   g++ -O2 -std=c++17 -I Source/Modelling3DOne Tools/GeometryBench/GeometryBench.cpp -o GeometryBench
+// Runs every shape across tessellation levels and reports vertices/s and ns/triangle.
+//   --json             machine-readable output, one record per shape and level, for regression gating
+//   --min-time=<ms>    time each case for at least this long (default 200)
+//   --acmr             instead of timing generation, report each case's ACMR before and after OptimizeIndexOrder
+//   --verify           instead of timing generation, compare generators against their reference implementations
+
+#include "ProceduralGeometryKernel.h"
+#include "ProceduralIndexOptimizer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ProceduralGeometry;
+
+namespace
+{
+	// Ring table owned by the benchmark, filled like the engine's shared tables
+	struct FRingTable
+	{
+		std::vector<float> Sin;
+		std::vector<float> Cos;
+	};
+
+	// Same contract as the engine's writer: single precision arrays sized once from the exact capacity, then filled by cursor
+	struct FBenchWriter
+	{
+		std::vector<FStoredVec3> Positions;
+		std::vector<FStoredVec3> Normals;
+		std::vector<FStoredVec4> Tangents;
+		std::vector<FStoredVec2> UVs;
+		std::vector<int32_t> Indices;
+		int32_t NumVertices = 0;
+		int32_t NumIndices = 0;
+		FProceduralMeshCapacity Capacity;
+
+		// Built on first use and kept, as in the engine, so the timed loop only measures generation
+		std::map<int32_t, FRingTable> Rings;
+
+		void Reset(const FProceduralMeshCapacity& InCapacity)
+		{
+			Capacity = InCapacity;
+			Positions.resize(Capacity.NumVertices);
+			Normals.resize(Capacity.NumVertices);
+			Tangents.resize(Capacity.NumVertices);
+			UVs.resize(Capacity.NumVertices);
+			Indices.resize(Capacity.NumIndices);
+			NumVertices = 0;
+			NumIndices = 0;
+		}
+
+		int32_t AddVertex(const FVec3& Position, const FVec3& Normal, const FTangent& Tangent, const FVec2& UV)
+		{
+			Positions[NumVertices] = FStoredVec3{ float(Position.X), float(Position.Y), float(Position.Z) };
+			Normals[NumVertices] = FStoredVec3{ float(Normal.X), float(Normal.Y), float(Normal.Z) };
+			Tangents[NumVertices] = FStoredVec4{ float(Tangent.TangentX.X), float(Tangent.TangentX.Y), float(Tangent.TangentX.Z), Tangent.bFlipTangentY ? -1.0f : 1.0f };
+			UVs[NumVertices] = FStoredVec2{ float(UV.X), float(UV.Y) };
+			return NumVertices++;
+		}
+
+		void AddTriangle(int32_t V0, int32_t V1, int32_t V2)
+		{
+			int32_t* Dest = Indices.data() + NumIndices;
+			Dest[0] = V0;
+			Dest[1] = V1;
+			Dest[2] = V2;
+			NumIndices += 3;
+		}
+
+		FRingView GetRing(int32_t NumSegments)
+		{
+			FRingTable& Table = Rings[NumSegments];
+			if (Table.Sin.empty())
+			{
+				Table.Sin.resize(NumSegments);
+				Table.Cos.resize(NumSegments);
+				FillRing(NumSegments, 0.0f, Table.Sin.data(), Table.Cos.data());
+			}
+			return FRingView{ Table.Sin.data(), Table.Cos.data(), NumSegments };
+		}
+
+		int32_t AddRing(const FProceduralRingParams& Params, const FRingView& Ring, int32_t FirstMeridian, int32_t Count)
+		{
+			int32_t RingStart = NumVertices;
+			EmitRing(Params, Ring, FirstMeridian, Count, Positions.data() + RingStart, Normals.data() + RingStart, Tangents.data() + RingStart,
+				UVs.data() + RingStart);
+			NumVertices += Count;
+			return RingStart;
+		}
+
+		int32_t AddGridRow(const FProceduralGridRowParams& Params, const float* Heights, const float* HeightsBelow, const float* HeightsAbove, int32_t Count)
+		{
+			int32_t RowStart = NumVertices;
+			EmitGridRow(Params, Heights, HeightsBelow, HeightsAbove, Count, Positions.data() + RowStart, Normals.data() + RowStart,
+				Tangents.data() + RowStart, UVs.data() + RowStart);
+			NumVertices += Count;
+			return RowStart;
+		}
+
+		bool IsCancelled() const { return false; }
+
+		bool IsComplete() const { return NumVertices == Capacity.NumVertices && NumIndices == Capacity.NumIndices; }
+
+		// FNV-1a over everything written, so a gate notices changed output as well as changed speed
+		uint64_t Checksum() const
+		{
+			uint64_t Hash = 14695981039346656037ull;
+			auto Mix = [&Hash](const void* Data, size_t Size)
+			{
+				const unsigned char* Bytes = static_cast<const unsigned char*>(Data);
+				for (size_t Index = 0; Index < Size; Index++)
+				{
+					Hash = (Hash ^ Bytes[Index]) * 1099511628211ull;
+				}
+			};
+			Mix(Positions.data(), NumVertices * sizeof(FStoredVec3));
+			Mix(Normals.data(), NumVertices * sizeof(FStoredVec3));
+			Mix(Tangents.data(), NumVertices * sizeof(FStoredVec4));
+			Mix(UVs.data(), NumVertices * sizeof(FStoredVec2));
+			Mix(Indices.data(), NumIndices * sizeof(int32_t));
+			return Hash;
+		}
+	};
+
+	struct FBenchCase
+	{
+		std::string Shape;
+		int32_t Tessellation = 0;
+		std::function<void(FBenchWriter&)> Build;
+	};
+
+	struct FBenchResult
+	{
+		int32_t NumVertices = 0;
+		int32_t NumTriangles = 0;
+		int64_t Iterations = 0;
+		double NsPerTriangle = 0.0;
+		double VerticesPerSecond = 0.0;
+		uint64_t Checksum = 0;
+		bool bComplete = false;
+	};
+
+	std::vector<FBenchCase> MakeCases()
+	{
+		// Ring counts for the lat/long and ring shapes, quads per side for the plane
+		const int32_t Levels[] = { 8, 32, 128, 512 };
+
+		std::vector<FBenchCase> Cases;
+		for (int32_t Level : Levels)
+		{
+			FProceduralSphereParams Sphere;
+			Sphere.Radius = 100.0f;
+			Sphere.NumParallels = Level;
+			Sphere.NumMeridians = 2 * Level;
+			Cases.push_back({ "sphere", Level, [Sphere](FBenchWriter& Writer) { BuildSphere(Sphere, Writer); } });
+
+			// Split until the vertex count is about that of the lat/long sphere above: 8 rings -> level 2, 512 -> level 8
+			FProceduralSphereParams Icosphere;
+			Icosphere.Radius = 100.0f;
+			Icosphere.Topology = ESphereTopology::Icosphere;
+			while ((2 << Icosphere.Subdivisions) < Level)
+			{
+				Icosphere.Subdivisions++;
+			}
+			Cases.push_back({ "icosphere", Level, [Icosphere](FBenchWriter& Writer) { BuildSphere(Icosphere, Writer); } });
+
+			FProceduralSphereParams CubeSphere = Icosphere;
+			CubeSphere.Topology = ESphereTopology::CubeSphere;
+			Cases.push_back({ "cubesphere", Level, [CubeSphere](FBenchWriter& Writer) { BuildSphere(CubeSphere, Writer); } });
+
+			FProceduralPacManParams PacMan;
+			PacMan.Radius = 100.0f;
+			PacMan.MouthAngleDegrees = 60.0f;
+			PacMan.NumParallels = Level;
+			PacMan.NumMeridians = 2 * Level;
+			Cases.push_back({ "pacman", Level, [PacMan](FBenchWriter& Writer) { BuildPacMan(PacMan, Writer); } });
+
+			FProceduralPacManParams FixedPacMan = PacMan;
+			FixedPacMan.bFixedTopology = true;
+			Cases.push_back({ "pacman_fixed", Level, [FixedPacMan](FBenchWriter& Writer) { BuildPacMan(FixedPacMan, Writer); } });
+
+			FProceduralConeParams Cone;
+			Cone.TopRadius = 10.0f;
+			Cone.BottomRadius = 50.0f;
+			Cone.Height = 100.0f;
+			Cone.NumMeridians = 2 * Level;
+			Cases.push_back({ "cone", Level, [Cone](FBenchWriter& Writer) { BuildCone(Cone, Writer); } });
+
+			FProceduralCylinderParams Cylinder;
+			Cylinder.Radius = 50.0f;
+			Cylinder.Height = 100.0f;
+			Cylinder.NumMeridians = 2 * Level;
+			Cases.push_back({ "cylinder", Level, [Cylinder](FBenchWriter& Writer) { BuildCylinder(Cylinder, Writer); } });
+
+			FProceduralPlaneParams Plane;
+			Plane.Nb_Lignes = Level;
+			Plane.Nb_Colones = Level;
+			Plane.QuadSize = 10.0f;
+			Cases.push_back({ "plane_soup", Level, [Plane](FBenchWriter& Writer) { BuildPlane(Plane, Writer); } });
+
+			FProceduralPlaneParams IndexedPlane = Plane;
+			IndexedPlane.bUseIndexedGrid = true;
+			Cases.push_back({ "plane_indexed", Level, [IndexedPlane](FBenchWriter& Writer) { BuildPlane(IndexedPlane, Writer); } });
+
+			FProceduralPlaneParams NoisePlane = IndexedPlane;
+			NoisePlane.NoiseAmplitude = 50.0f;
+			NoisePlane.NoiseScale = 200.0f;
+			Cases.push_back({ "plane_noise", Level, [NoisePlane](FBenchWriter& Writer) { BuildPlane(NoisePlane, Writer); } });
+		}
+
+		// The prism has no tessellation; it measures the fixed per-build overhead
+		FProceduralTrapezoidParams Trapezoid;
+		Trapezoid.TopWidth = 50.0f;
+		Trapezoid.BottomWidth = 100.0f;
+		Trapezoid.Height = 100.0f;
+		Trapezoid.Depth = 50.0f;
+		Cases.push_back({ "trapezoid", 1, [Trapezoid](FBenchWriter& Writer) { BuildTrapezoid(Trapezoid, Writer); } });
+
+		return Cases;
+	}
+
+	/**
+	 * Pac-Man with the original vertex lookup, which counts the kept meridians of every earlier parallel on each call
+	 * (O(Parallels^2 * Meridians^2) per mesh). Kept as the reference for BuildPacMan's slot table: for the same
+	 * parameters both must write the same bytes. Skipping topology only
+	 */
+	void BuildPacManReference(const FProceduralPacManParams& Params, FBenchWriter& Writer)
+	{
+		Writer.Reset(ComputePacManCapacity(Params));
+
+		int32_t Parallels = Math::Max(3, Params.NumParallels);
+		int32_t Meridians = Math::Max(3, Params.NumMeridians);
+		float HalfMouthAngleRad = Math::DegreesToRadians(Params.MouthAngleDegrees / 2.0f);
+		FRingView Ring = Writer.GetRing(Meridians);
+		float NormalSign = Math::Sign(Params.Radius);
+		FTangent PoleTangent = MakeLatLongTangent(0.0f, 1.0f, NormalSign);
+
+		Writer.AddVertex(FVec3(0, 0, 0), FVec3(1, 0, 0), PoleTangent, FVec2(0.5f, 0.5f));
+		FVec3 NorthPole = FVec3(0, 0, Params.Radius);
+		int32_t NorthPoleIndex = Writer.AddVertex(NorthPole, NorthPole.GetSafeNormal(), PoleTangent, FVec2(0.5f, 1.0f));
+
+		// One meridian at a time, skipping the mouth
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+		{
+			float Theta = Pi * float(ParallelIdx) / float(Parallels);
+			float SinTheta = Math::Sin(Theta);
+			float CosTheta = Math::Cos(Theta);
+
+			FProceduralRingParams RingParams;
+			RingParams.PositionScale = Params.Radius * SinTheta;
+			RingParams.PositionZ = Params.Radius * CosTheta;
+			RingParams.NormalScale = NormalSign * SinTheta;
+			RingParams.NormalZ = NormalSign * CosTheta;
+			RingParams.V = float(ParallelIdx) / float(Parallels);
+			RingParams.NumMeridians = Meridians;
+			RingParams.TangentScale = PoleTangent.TangentX.Y;
+			RingParams.bFlipTangentY = PoleTangent.bFlipTangentY;
+
+			for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+			{
+				if (IsMeridianInMouth(MeridianIdx, Meridians, HalfMouthAngleRad))
+					continue;
+
+				Writer.AddRing(RingParams, Ring, MeridianIdx, 1);
+			}
+		}
+
+		FVec3 SouthPole = FVec3(0, 0, -Params.Radius);
+		int32_t SouthPoleIndex = Writer.AddVertex(SouthPole, SouthPole.GetSafeNormal(), PoleTangent, FVec2(0.5f, 0.0f));
+
+		auto GetVertexIndex = [&](int32_t ParallelIdx, int32_t MeridianIdx) -> int32_t
+		{
+			if (ParallelIdx == 0)
+				return NorthPoleIndex;
+			if (ParallelIdx == Parallels)
+				return SouthPoleIndex;
+
+			if (IsMeridianInMouth(MeridianIdx, Meridians, HalfMouthAngleRad))
+				return -1;
+
+			int32_t Index = NorthPoleIndex + 1;
+			for (int32_t p = 1; p < ParallelIdx; p++)
+			{
+				for (int32_t m = 0; m < Meridians; m++)
+				{
+					if (!IsMeridianInMouth(m, Meridians, HalfMouthAngleRad))
+						Index++;
+				}
+			}
+
+			for (int32_t m = 0; m < MeridianIdx; m++)
+			{
+				if (!IsMeridianInMouth(m, Meridians, HalfMouthAngleRad))
+					Index++;
+			}
+
+			return Index;
+		};
+
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t Current = GetVertexIndex(1, MeridianIdx);
+			int32_t Next = GetVertexIndex(1, (MeridianIdx + 1) % Meridians);
+			if (Current != -1 && Next != -1)
+			{
+				Writer.AddTriangle(NorthPoleIndex, Next, Current);
+			}
+		}
+
+		for (int32_t ParallelIdx = 1; ParallelIdx < Parallels - 1; ParallelIdx++)
+		{
+			for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+			{
+				int32_t NextMeridianIdx = (MeridianIdx + 1) % Meridians;
+
+				int32_t Current = GetVertexIndex(ParallelIdx, MeridianIdx);
+				int32_t CurrentNext = GetVertexIndex(ParallelIdx, NextMeridianIdx);
+				int32_t Below = GetVertexIndex(ParallelIdx + 1, MeridianIdx);
+				int32_t BelowNext = GetVertexIndex(ParallelIdx + 1, NextMeridianIdx);
+
+				if (Current != -1 && CurrentNext != -1 && Below != -1 && BelowNext != -1)
+				{
+					Writer.AddTriangle(Current, CurrentNext, Below);
+					Writer.AddTriangle(CurrentNext, BelowNext, Below);
+				}
+			}
+		}
+
+		for (int32_t MeridianIdx = 0; MeridianIdx < Meridians; MeridianIdx++)
+		{
+			int32_t Current = GetVertexIndex(Parallels - 1, MeridianIdx);
+			int32_t Next = GetVertexIndex(Parallels - 1, (MeridianIdx + 1) % Meridians);
+			if (Current != -1 && Next != -1)
+			{
+				Writer.AddTriangle(Current, Next, SouthPoleIndex);
+			}
+		}
+
+		// Mouth walls, one per edge, each fanned from its own center vertex
+		FVec3 UpperWallNormal = FVec3(-Math::Sin(HalfMouthAngleRad), Math::Cos(HalfMouthAngleRad), 0).GetSafeNormal();
+		FVec3 LowerWallNormal = FVec3(-Math::Sin(-HalfMouthAngleRad), Math::Cos(-HalfMouthAngleRad), 0).GetSafeNormal();
+		float CosUpperEdge = Math::Cos(HalfMouthAngleRad);
+		float SinUpperEdge = Math::Sin(HalfMouthAngleRad);
+		float CosLowerEdge = Math::Cos(-HalfMouthAngleRad);
+		float SinLowerEdge = Math::Sin(-HalfMouthAngleRad);
+		FTangent UpperWallTangent = MakeTangent(UpperWallNormal, FVec3(CosUpperEdge, SinUpperEdge, 0) * -Params.Radius, FVec3(0, 0, Params.Radius));
+		FTangent LowerWallTangent = MakeTangent(LowerWallNormal, FVec3(CosLowerEdge, SinLowerEdge, 0) * Params.Radius, FVec3(0, 0, Params.Radius));
+
+		auto AddWallEdge = [&](float CosEdge, float SinEdge, const FVec3& Normal, const FTangent& Tangent, float U) -> int32_t
+		{
+			int32_t EdgeNorthPole = Writer.AddVertex(NorthPole, Normal, Tangent, FVec2(U, 1.0f));
+			for (int32_t ParallelIdx = 1; ParallelIdx < Parallels; ParallelIdx++)
+			{
+				float Theta = Pi * float(ParallelIdx) / float(Parallels);
+				float SinTheta = Math::Sin(Theta);
+				float CosTheta = Math::Cos(Theta);
+				FVec3 Position = FVec3(Params.Radius * SinTheta * CosEdge, Params.Radius * SinTheta * SinEdge, Params.Radius * CosTheta);
+				Writer.AddVertex(Position, Normal, Tangent, FVec2(U, 1.0f - float(ParallelIdx) / float(Parallels)));
+			}
+			Writer.AddVertex(SouthPole, Normal, Tangent, FVec2(U, 0.0f));
+			return EdgeNorthPole;
+		};
+		int32_t UpperNorthPole = AddWallEdge(CosUpperEdge, SinUpperEdge, UpperWallNormal, UpperWallTangent, 0.0f);
+		int32_t LowerNorthPole = AddWallEdge(CosLowerEdge, SinLowerEdge, LowerWallNormal, LowerWallTangent, 1.0f);
+
+		int32_t CenterUpperWall = Writer.AddVertex(FVec3(0, 0, 0), UpperWallNormal, UpperWallTangent, FVec2(0.5f, 0.5f));
+		int32_t CenterLowerWall = Writer.AddVertex(FVec3(0, 0, 0), LowerWallNormal, LowerWallTangent, FVec2(0.5f, 0.5f));
+
+		for (int32_t i = 0; i < Parallels; i++)
+		{
+			Writer.AddTriangle(CenterUpperWall, UpperNorthPole + i, UpperNorthPole + i + 1);
+		}
+		for (int32_t i = 0; i < Parallels; i++)
+		{
+			Writer.AddTriangle(CenterLowerWall, LowerNorthPole + i + 1, LowerNorthPole + i);
+		}
+	}
+
+	// Byte comparison of everything two writers wrote
+	bool IsSameMesh(const FBenchWriter& A, const FBenchWriter& B)
+	{
+		return A.NumVertices == B.NumVertices && A.NumIndices == B.NumIndices
+			&& std::memcmp(A.Positions.data(), B.Positions.data(), A.NumVertices * sizeof(FStoredVec3)) == 0
+			&& std::memcmp(A.Normals.data(), B.Normals.data(), A.NumVertices * sizeof(FStoredVec3)) == 0
+			&& std::memcmp(A.Tangents.data(), B.Tangents.data(), A.NumVertices * sizeof(FStoredVec4)) == 0
+			&& std::memcmp(A.UVs.data(), B.UVs.data(), A.NumVertices * sizeof(FStoredVec2)) == 0
+			&& std::memcmp(A.Indices.data(), B.Indices.data(), A.NumIndices * sizeof(int32_t)) == 0;
+	}
+
+	// Runs every reference comparison and prints one line per case; false if any differ
+	bool RunVerification()
+	{
+		// (Parallels, Meridians, MouthAngleDegrees): no mouth, the whole sphere removed, odd counts, a mouth wider than half
+		// the sphere, counts below the minimum of 3, and a high tessellation
+		const struct
+		{
+			int32_t Parallels;
+			int32_t Meridians;
+			float MouthAngleDegrees;
+		} PacManCases[] = {
+			{ 8, 16, 0.0f }, { 8, 16, 360.0f }, { 8, 16, 60.0f }, { 9, 17, 45.0f }, { 16, 31, 270.0f },
+			{ 2, 2, 90.0f }, { 3, 3, 120.0f }, { 32, 64, 359.0f }, { 64, 128, 60.0f }, { 64, 128, 0.0f }, { 64, 128, 360.0f }, { 128, 256, 60.0f },
+		};
+
+		bool bAllSame = true;
+		for (const auto& Case : PacManCases)
+		{
+			FProceduralPacManParams Params;
+			Params.Radius = 100.0f;
+			Params.NumParallels = Case.Parallels;
+			Params.NumMeridians = Case.Meridians;
+			Params.MouthAngleDegrees = Case.MouthAngleDegrees;
+
+			FBenchWriter Writer;
+			BuildPacMan(Params, Writer);
+			FBenchWriter Reference;
+			BuildPacManReference(Params, Reference);
+
+			const bool bSame = Writer.IsComplete() && Reference.IsComplete() && IsSameMesh(Writer, Reference);
+			bAllSame &= bSame;
+			std::printf("pacman %4d x %4d mouth %5.1f  %8d vertices %8d triangles  %s\n", Case.Parallels, Case.Meridians, Case.MouthAngleDegrees,
+				Writer.NumVertices, Writer.NumIndices / 3, bSame ? "same" : "DIFFERENT");
+		}
+		return bAllSame;
+	}
+
+	FBenchResult RunCase(const FBenchCase& Case, double MinSeconds)
+	{
+		using FClock = std::chrono::steady_clock;
+
+		// Untimed first build sizes the arrays and the ring tables
+		FBenchWriter Writer;
+		Case.Build(Writer);
+
+		FBenchResult Result;
+		Result.NumVertices = Writer.NumVertices;
+		Result.NumTriangles = Writer.NumIndices / 3;
+		Result.Checksum = Writer.Checksum();
+		Result.bComplete = Writer.IsComplete();
+
+		double Seconds = 0.0;
+		const FClock::time_point StartTime = FClock::now();
+		do
+		{
+			Case.Build(Writer);
+			Result.Iterations++;
+			Seconds = std::chrono::duration<double>(FClock::now() - StartTime).count();
+		}
+		while (Seconds < MinSeconds);
+
+		const double SecondsPerBuild = Seconds / double(Result.Iterations);
+		Result.NsPerTriangle = Result.NumTriangles > 0 ? SecondsPerBuild * 1.0e9 / Result.NumTriangles : 0.0;
+		Result.VerticesPerSecond = Result.NumVertices / SecondsPerBuild;
+		return Result;
+	}
+
+	struct FACMRResult
+	{
+		int32_t NumTriangles = 0;
+		FIndexOrderStats Stats;
+		double OptimizeMs = 0.0;
+	};
+
+	// One build, then the same reordering FProceduralMeshBuilder::OptimizeIndexOrder runs
+	FACMRResult RunACMRCase(const FBenchCase& Case)
+	{
+		using FClock = std::chrono::steady_clock;
+
+		FBenchWriter Writer;
+		Case.Build(Writer);
+
+		FACMRResult Result;
+		Result.NumTriangles = Writer.NumIndices / 3;
+		std::vector<int32_t> Remap(Writer.NumVertices);
+		const FClock::time_point StartTime = FClock::now();
+		Result.Stats = OptimizeIndexOrder(Writer.Indices.data(), Writer.NumIndices, Writer.Positions.data(), Writer.NumVertices, Remap.data());
+		Result.OptimizeMs = std::chrono::duration<double, std::milli>(FClock::now() - StartTime).count();
+		return Result;
+	}
+}
+
+int main(int ArgC, char** ArgV)
+{
+	bool bJson = false;
+	bool bACMR = false;
+	bool bVerify = false;
+	double MinSeconds = 0.2;
+	for (int ArgIdx = 1; ArgIdx < ArgC; ArgIdx++)
+	{
+		if (std::strcmp(ArgV[ArgIdx], "--json") == 0)
+		{
+			bJson = true;
+		}
+		else if (std::strcmp(ArgV[ArgIdx], "--acmr") == 0)
+		{
+			bACMR = true;
+		}
+		else if (std::strcmp(ArgV[ArgIdx], "--verify") == 0)
+		{
+			bVerify = true;
+		}
+		else if (std::strncmp(ArgV[ArgIdx], "--min-time=", 11) == 0)
+		{
+			MinSeconds = std::atof(ArgV[ArgIdx] + 11) / 1000.0;
+		}
+		else
+		{
+			std::fprintf(stderr, "Usage: %s [--json] [--min-time=<ms>] [--acmr] [--verify]\n", ArgV[0]);
+			return 2;
+		}
+	}
+
+	if (bVerify)
+	{
+		return RunVerification() ? 0 : 1;
+	}
+
+	const std::vector<FBenchCase> Cases = MakeCases();
+	bool bAllComplete = true;
+
+	if (bACMR)
+	{
+		std::printf("%-14s %6s %10s %10s %10s %12s\n", "shape", "tess", "triangles", "ACMR", "optimized", "optimize ms");
+		for (const FBenchCase& Case : Cases)
+		{
+			const FACMRResult Result = RunACMRCase(Case);
+			std::printf("%-14s %6d %10d %10.3f %10.3f %12.2f\n", Case.Shape.c_str(), Case.Tessellation, Result.NumTriangles,
+				Result.Stats.ACMRBefore, Result.Stats.ACMRAfter, Result.OptimizeMs);
+		}
+		return 0;
+	}
+
+	if (bJson)
+	{
+		std::printf("{\n  \"results\": [\n");
+	}
+	else
+	{
+		std::printf("%-14s %6s %10s %10s %10s %14s %12s\n", "shape", "tess", "vertices", "triangles", "builds", "Mverts/s", "ns/triangle");
+	}
+
+	for (size_t CaseIdx = 0; CaseIdx < Cases.size(); CaseIdx++)
+	{
+		const FBenchCase& Case = Cases[CaseIdx];
+		const FBenchResult Result = RunCase(Case, MinSeconds);
+		bAllComplete &= Result.bComplete;
+
+		if (bJson)
+		{
+			std::printf("    { \"shape\": \"%s\", \"tessellation\": %d, \"vertices\": %d, \"triangles\": %d, \"iterations\": %lld, "
+				"\"vertices_per_second\": %.1f, \"ns_per_triangle\": %.3f, \"checksum\": \"%016llx\", \"complete\": %s }%s\n",
+				Case.Shape.c_str(), Case.Tessellation, Result.NumVertices, Result.NumTriangles, (long long)Result.Iterations,
+				Result.VerticesPerSecond, Result.NsPerTriangle, (unsigned long long)Result.Checksum, Result.bComplete ? "true" : "false",
+				CaseIdx + 1 < Cases.size() ? "," : "");
+		}
+		else
+		{
+			std::printf("%-14s %6d %10d %10d %10lld %14.1f %12.3f%s\n", Case.Shape.c_str(), Case.Tessellation, Result.NumVertices,
+				Result.NumTriangles, (long long)Result.Iterations, Result.VerticesPerSecond / 1.0e6, Result.NsPerTriangle,
+				Result.bComplete ? "" : "  CAPACITY MISMATCH");
+		}
+	}
+
+	if (bJson)
+	{
+		std::printf("  ]\n}\n");
+	}
+
+	// A capacity formula out of sync with its generator fails the run, like Finalize's ensure in the engine
+	return bAllComplete ? 0 : 1;
+}